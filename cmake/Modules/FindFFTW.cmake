@@ -7,6 +7,7 @@
 #   FFTW_FOUND               ... true if fftw is found on the system
 #   FFTW_LIBRARIES           ... full path to fftw library
 #   FFTW_INCLUDES            ... fftw include directory
+#   FFTW_OMP_LIB             ... fftw OpenMP library, if found
 #
 # The following variables will be checked by the function
 #   FFTW_USE_STATIC_LIBS    ... if true, only static libraries are found
@@ -114,6 +115,13 @@ else()
     NAMES "fftw3.h"
   )
 endif( FFTW_ROOT )
+#OpenMP version of the library (optional)
+find_library(
+  FFTW_OMP_LIB
+  NAMES "fftw3_omp"
+  PATHS ${FFTW_ROOT} ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR}
+  PATH_SUFFIXES "lib" "lib64"
+)
 set(FFTW_LIBRARIES ${FFTW_LIB})
 if(FFTWF_LIB)
   set(FFTW_LIBRARIES ${FFTW_LIBRARIES} ${FFTWF_LIB})
@@ -126,4 +134,4 @@ set( CMAKE_FIND_LIBRARY_SUFFIXES ${CMAKE_FIND_LIBRARY_SUFFIXES_SAV} )
 include(FindPackageHandleStandardArgs)
 find_package_handle_standard_args(FFTW DEFAULT_MSG
                                   FFTW_INCLUDES FFTW_LIBRARIES)
-mark_as_advanced(FFTW_INCLUDES FFTW_LIBRARIES FFTW_LIB FFTWF_LIB FFTWL_LIB)
+mark_as_advanced(FFTW_INCLUDES FFTW_LIBRARIES FFTW_LIB FFTWF_LIB FFTWL_LIB FFTW_OMP_LIB)
@@ -2,6 +2,28 @@
 #ifndef __CCL_BACKGROUND_H_INCLUDED__
 #define __CCL_BACKGROUND_H_INCLUDED__
 
+/**
+ * Conversion types for ccl_convert_distances
+ */
+#define CCL_DIST_CHI 0 // Comoving radial distance from redshift
+#define CCL_DIST_DM 1 // Comoving angular distance from redshift
+#define CCL_DIST_DA 2 // Angular diameter distance from redshift
+#define CCL_DIST_DL 3 // Luminosity distance from redshift
+#define CCL_DIST_MU 4 // Distance modulus from redshift
+#define CCL_DIST_Z_OF_CHI 5 // Redshift from comoving radial distance
+#define CCL_DIST_Z_OF_DL 6 // Redshift from luminosity distance
+
+/**
+ * Number of nodes of each of the tables used by ccl_convert_distances
+ */
+#define CCL_DIST_TABLE_NX 4096
+
+/**
+ * Maximum redshift covered by the inverse (z of distance) tables.
+ * Beyond it, ccl_convert_distances inverts the distance table numerically.
+ */
+#define CCL_DIST_TABLE_ZMAX_INV 100.
+
 CCL_BEGIN_DECLS
 
 //species_x labels
@@ -242,6 +264,35 @@ double ccl_scale_factor_of_chi(ccl_cosmology * cosmo, double chi, int * status);
  */
 void ccl_scale_factor_of_chis(ccl_cosmology * cosmo, int nchi, double chi[], double output[], int* status);
 
+/**
+ * Convert redshifts into distances, or distances into redshifts, for large catalogues.
+ * The first call tabulates chi(z) on a uniform grid in ln(1+z) over the range of the
+ * distance splines, and z(chi) and z(D_L) on uniform grids in distance up to
+ * z=CCL_DIST_TABLE_ZMAX_INV, all with CCL_DIST_TABLE_NX nodes. Later calls only read these
+ * tables, with direct indexing and cubic Hermite interpolation, in parallel. Inputs do not
+ * need to be sorted, and long streams (e.g. memory-mapped files) can be processed in chunks
+ * by successive calls.
+ * @param cosmo Cosmological parameters
+ * @param dist_type one of CCL_DIST_CHI, CCL_DIST_DM, CCL_DIST_DA, CCL_DIST_DL, CCL_DIST_MU (input redshifts),
+ * CCL_DIST_Z_OF_CHI or CCL_DIST_Z_OF_DL (input distances in Mpc, output redshifts)
+ * @param n Number of inputs
+ * @param input array of n redshifts or distances
+ * @param output array of length n to store the results, in Mpc for distances. Inputs outside the range of
+ * the tables give NAN and a nonzero status.
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return void
+ */
+void ccl_convert_distances(ccl_cosmology * cosmo, int dist_type, int n, double *input,
+			   double *output, int * status);
+
+/**
+ * Free the table used by ccl_convert_distances, if it has been computed.
+ * @param cosmo Cosmological parameters
+ * @return void
+ */
+void ccl_cosmology_distance_table_free(ccl_cosmology * cosmo);
+
 /**
  * Physical density (rho) as a function of scale factor.  Critical density is defined as rho_critical = 3 H^2(a)/ (8 pi G). Density of a given species is then rho_x = Omega_x(a) rho_critical(a). For example, rho_matter(a) = Omega_m  a^{-3} / (H^2/H0^2)  3H^2 / (8 pi G) =  Omega_m  a^{-3}  3H0^2 / (8 pi G) =  Omega_m a^{-3}  rho_critical_present. Units of M_sun/(Mpc)^3.
  * @param cosmo Cosmological parameters
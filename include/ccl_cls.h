@@ -2,6 +2,8 @@
 #ifndef __CCL_CLS_H_INCLUDED__
 #define __CCL_CLS_H_INCLUDED__
 
+#include <gsl/gsl_integration.h>
+
 typedef enum ccl_tracer_t
 {
   ccl_number_counts_tracer = 1,
@@ -20,8 +22,37 @@ typedef enum ccl_tracer_func_t
   ccl_trf_wM = 207, //Magnification window function
 } ccl_tracer_func_t;
 
+typedef enum ccl_cl_limber_t
+{
+  ccl_limber_qag_logk = 301, //Adaptive Gauss-Kronrod integration in log(k)
+  ccl_limber_gl_chi   = 302, //Fixed-node composite Gauss-Legendre integration in chi
+} ccl_cl_limber_t;
+
+typedef enum ccl_cl_nonlimber_t
+{
+  ccl_nonlimber_native = 311, //FFTLog-based integration using the tracer kernels
+  ccl_nonlimber_angpow = 312, //Angpow (default). Other pairs than number counts without magnification use Limber
+} ccl_cl_nonlimber_t;
+
 CCL_BEGIN_DECLS
 
+/**
+ * ClRadialTable structure, holding background quantities
+ * tabulated on a uniform grid in comoving distance, chi_i=i*dchi.
+ * Used to update the radial kernels of a tracer without
+ * recomputing them (see ccl_cl_tracer_set_photoz).
+ */
+typedef struct {
+  int n; //Number of nodes
+  double dchi; //Grid spacing
+  double *a; //Scale factor
+  double *h; //Expansion rate H(z)/c
+  double *growth; //Growth factor (NULL unless needed)
+  double *fgrowth; //Growth rate (NULL unless needed)
+  double *cosn; //Generalized cosine of chi (see ccl_sinn)
+  double *sinn; //Comoving angular distance
+} CCL_ClRadialTable;
+
 /**
  * ClTracer structure, used to contain everything
  * that a Cl tracer could have, such as splines for
@@ -46,6 +77,18 @@ typedef struct {
   SplPar *spl_ba; //Spline for alignment bias
   SplPar *spl_wL; //Spline for lensing kernel
   SplPar *spl_wM; //Spline for magnification
+  //Radial kernels entering the Limber integrand, tabulated in chi when the tracer is created
+  SplPar *spl_kd; //Ell-independent kernel (galaxy density)
+  SplPar *spl_kr; //RSD kernel (growth rate times growth factor times dN/dchi)
+  SplPar *spl_kg; //Growth factor, needed to rescale the RSD kernel
+  SplPar *spl_kl; //Lensing-like kernel (magnification, shear and IA, CMB lensing), multiplied by an ell-dependent prefactor
+  unsigned long id; //Unique identifier of this tracer (see CCL_ClCache)
+  //Photo-z shift and stretch (see ccl_cl_tracer_set_photoz)
+  double pz_shift;
+  double pz_stretch;
+  double pz_zmean; //Mean redshift of the input N(z), used as the pivot of the stretch
+  SplPar *spl_nz0; //Normalized input N(z). NULL until the photo-z parameters are first set
+  CCL_ClRadialTable *pz_tab; //Background on the grid used to update the kernels. NULL until needed
 } CCL_ClTracer;
 
 
@@ -169,6 +212,23 @@ CCL_ClTracer *ccl_cl_tracer_lensing_simple(ccl_cosmology *cosmo,
  */
 CCL_ClTracer *ccl_cl_tracer_cmblens(ccl_cosmology *cosmo,double z_source,int *status);
 
+/**
+ * Shifts and stretches the redshift distribution of a number counts or weak lensing tracer,
+ * so that N(z) -> N_0(<z>+(z-<z>-dz)/stretch)/stretch, where N_0 is the N(z) the tracer was
+ * created with and <z> its mean redshift. The parameters always refer to N_0, so successive
+ * calls do not accumulate. The background quantities needed to recompute the radial kernels
+ * are tabulated on the first call and reused afterwards.
+ * If an error occurs the tracer should not be used any more (other than to free it).
+ * @param cosmo Cosmological parameters
+ * @param clt a Cltracer
+ * @param dz shift in redshift
+ * @param stretch stretch factor around the mean redshift (must be positive)
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return void
+ */
+void ccl_cl_tracer_set_photoz(ccl_cosmology *cosmo,CCL_ClTracer *clt,double dz,double stretch,int *status);
+
 /**
  * Destructor for a Cltracer
  * @param clt a Cltracer
@@ -209,7 +269,16 @@ double ccl_get_tracer_fa(ccl_cosmology *cosmo,CCL_ClTracer *clt,double a,int fun
 int ccl_get_tracer_fas(ccl_cosmology *cosmo,CCL_ClTracer *clt,int na,double *a,double *fa,
 		       int func_code,int *status);
 
-//Workspace for C_ell computations
+//Scratch space of the native non-Limber integrator (opaque, see ccl_cls.c)
+typedef struct cl_nonlimber_scratch_s cl_nonlimber_scratch;
+
+//Workspace for C_ell computations.
+//Besides the multipole nodes, the workspace owns the scratch space used by ccl_angular_cls
+//and ccl_angular_cls_multi. The space that only depends on the nodes and the number of threads
+//is allocated with the workspace. The rest is allocated the first time it's needed (or when
+//more tracers or quadrature nodes than before are used) and reused afterwards, so that repeated
+//calls with the same workspace don't allocate memory. For this reason a workspace must not be
+//used by several concurrent calls.
 typedef struct {
   int lmax; //*Maximum multipole
   int l_limber; //*All power spectra for l>l_limber will be computed using Limber's approximation
@@ -217,6 +286,32 @@ typedef struct {
   int l_linstep; //*Linear step used at high l
   int n_ls; //Number of multipoles that result from the previous combination of parameters
   int *l_arr; //*Array of multipole values resulting from the previous parameters
+  int limber_method; //Method used to compute Limber integrals (see ccl_cl_limber_t). Defaults to ccl_limber_qag_logk
+  int nonlimber_method; //Method used for l<=l_limber (see ccl_cl_nonlimber_t). Defaults to ccl_nonlimber_angpow
+  double l_tol; //If positive, Limber nodes are added adaptively until the interpolation error is below l_tol (relative). Defaults to 0 (fixed nodes)
+  double *l_nodes; //Multipole nodes as floating point numbers
+  int n_spectra_alloc; //Number of power spectra cl_nodes can hold
+  double *cl_nodes; //Power spectra at the multipole nodes (spectrum i at node j in cl_nodes[i*n_ls+j])
+  SplPar *spl_nodes; //Spline used to interpolate cl_nodes
+  int *ref_i, *ref_l; //Intervals between nodes checked by the adaptive node placement and their midpoints
+  char *ref_conv, *ref_bad; //Whether those intervals have converged or need to be split
+  double *ref_cl; //Power spectra at the midpoints (n_spectra_alloc*n_ls elements)
+  int n_scratch_threads; //Number of threads for which per-thread scratch space has been allocated
+  int n_scratch; //Size of the per-thread scratch space
+  double *scratch; //Per-thread scratch space (n_scratch elements for each thread)
+  cl_nonlimber_scratch *nl_scratch; //Scratch space of the native non-Limber integrator (NULL until it's used)
+  int n_threads; //Number of threads for which integration workspaces have been allocated
+  gsl_integration_workspace **w_integ; //One integration workspace per thread
+  gsl_integration_glfixed_table *tgl; //Gauss-Legendre nodes used by the fixed-node Limber quadrature
+  int n_chi_alloc; //Allocated size of the quadrature arrays below
+  int n_chi; //Number of nodes of the last fixed-node Limber quadrature
+  double *chi, *wchi; //Nodes and weights of that quadrature
+  double *chi_new, *wchi_new; //Scratch space for a new quadrature
+  double *achi; //Scale factor at the quadrature nodes
+  double *pw; //Power spectrum at the quadrature nodes for all multipoles (see limber_power_weights in ccl_cls.c)
+  ccl_cosmology *pw_cosmo; //Cosmology for which pw was computed (NULL if it hasn't been computed)
+  ccl_parameters pw_params; //Parameters of that cosmology
+  ccl_configuration pw_config; //Configuration of that cosmology
 } CCL_ClWorkspace;
 
 //CCL_ClWorkspace constructor
@@ -229,7 +324,11 @@ CCL_ClWorkspace *ccl_cl_workspace_new_limber(int lmax, double l_logstep,int l_li
 void ccl_cl_workspace_free(CCL_ClWorkspace *w);
 
 /**
- * Computes limber or non-limber power spectrum for two different tracers
+ * Computes limber or non-limber power spectrum for two different tracers.
+ * The power spectrum is computed at the multipole nodes of the workspace and interpolated.
+ * If w->l_tol>0, Limber nodes are bisected until the interpolation error is below w->l_tol.
+ * The new nodes are kept in the workspace, so a coarse workspace can be refined once and
+ * shared by several pairs of tracers.
  * @param cosmo Cosmological parameters
  * @param w a ClWorkspace
  * @param clt1 a Cltracer
@@ -245,6 +344,159 @@ void ccl_angular_cls(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
 		     CCL_ClTracer *clt1,CCL_ClTracer *clt2,
 		     int nl_out,int *l,double *cl,int *status);
 
+//Entry of a CCL_ClCache: power spectrum between two tracers at the nodes of a workspace
+typedef struct {
+  unsigned long id1,id2; //Identifiers of the tracers
+  int lmax; //Parameters of the workspace used to compute the power spectrum
+  int l_limber;
+  double l_logstep;
+  int l_linstep;
+  int limber_method;
+  int nonlimber_method;
+  double l_tol;
+  SplPar *spl; //Spline of the power spectrum at the workspace nodes
+  unsigned long last_used; //Last call in which this entry was used
+} CCL_ClCacheEntry;
+
+//Cache of angular power spectra for a given cosmology.
+//Entries are keyed by the identity of both tracers and by the parameters that define
+//the multipole nodes of the workspace. An entry computed for a larger lmax is used for
+//smaller ones. At most max_entries power spectra are stored, dropping the least recently
+//used one when needed. All entries are dropped when the cache is used with a different
+//cosmology or when ccl_cl_cache_clear is called. A cache must not be used by several
+//concurrent calls.
+typedef struct {
+  int max_entries; //Maximum number of entries
+  int n_entries; //Current number of entries
+  CCL_ClCacheEntry *entries;
+  unsigned long n_calls; //Number of calls to ccl_angular_cls_cached since the cache was created
+  unsigned long n_hits; //Number of those calls that didn't need to compute the power spectrum
+  ccl_cosmology *cosmo; //Cosmology of the stored entries
+  ccl_parameters params; //Parameters of that cosmology
+  ccl_configuration config; //Configuration of that cosmology
+} CCL_ClCache;
+
+//CCL_ClCache constructor
+CCL_ClCache *ccl_cl_cache_new(int max_entries,int *status);
+//Drops all the entries of a CCL_ClCache
+void ccl_cl_cache_clear(CCL_ClCache *c);
+//CCL_ClCache destructor
+void ccl_cl_cache_free(CCL_ClCache *c);
+
+/**
+ * Same as ccl_angular_cls, but the power spectrum at the workspace nodes is looked up in
+ * (and, if not found, stored into) a cache, so that it's only computed once.
+ * @param cosmo Cosmological parameters
+ * @param w a ClWorkspace
+ * @param cache a CCL_ClCache
+ * @param clt1 a Cltracer
+ * @param clt2 a Cltracer
+ * @param nl_out number of multipoles
+ * @param l an array of ell values
+ * @param cl the C_ell output array
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return void
+ */
+void ccl_angular_cls_cached(ccl_cosmology *cosmo,CCL_ClWorkspace *w,CCL_ClCache *cache,
+			    CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+			    int nl_out,int *l,double *cl,int *status);
+
+/**
+ * Computes the Limber power spectra between all pairs of a set of tracers.
+ * The matter power spectrum is sampled once per multipole node on a grid of
+ * comoving distances shared by all tracers, and each C_ell is computed as an
+ * inner product over that grid. The Limber approximation is used at all multipoles.
+ * If w->l_tol>0, nodes are added until all the power spectra are interpolated within w->l_tol.
+ * @param cosmo Cosmological parameters
+ * @param w a ClWorkspace
+ * @param n_tracers number of tracers
+ * @param clts array of n_tracers Cltracers
+ * @param nl_out number of multipoles
+ * @param l an array of ell values
+ * @param cl the C_ell output array, with n_tracers*n_tracers*nl_out elements.
+ * The power spectrum between tracers i and j at l[k] is stored in cl[(i*n_tracers+j)*nl_out+k].
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return void
+ */
+void ccl_angular_cls_multi(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+			   int n_tracers,CCL_ClTracer **clts,
+			   int nl_out,int *l,double *cl,int *status);
+
+/**
+ * Angular power spectrum templates for a pair of tracers.
+ * At fixed cosmology, C_ell is a bilinear function of the nuisance parameters of both
+ * tracers. For number counts tracers these are the values of b(z) at its nodes, followed
+ * by the values of s(z) at its nodes if the tracer has magnification. For weak lensing
+ * tracers with intrinsic alignments, they are the values of ba(z) at its nodes. Other
+ * tracers have no nuisance parameters.
+ */
+typedef struct {
+  int n_par1; //Number of nuisance parameters of the first tracer
+  int n_par2; //Number of nuisance parameters of the second tracer
+  int nl; //Number of multipoles
+  int *l; //Multipoles
+  double *cl; //Coefficient of p1[i-1]*p2[j-1] at l[k] (with p[-1]=1) stored in cl[(i*(n_par2+1)+j)*nl+k]
+} CCL_ClTemplates;
+
+/**
+ * Computes angular power spectrum templates for a pair of tracers. This costs
+ * (n_par1+1)*(n_par2+1) power spectra (computed in one go if w doesn't require
+ * non-Limber calculations), after which the power spectrum can be obtained for any
+ * value of the nuisance parameters through ccl_cl_templates_eval.
+ * @param cosmo Cosmological parameters
+ * @param w a ClWorkspace
+ * @param clt1 a Cltracer
+ * @param clt2 a Cltracer
+ * @param nl_out number of multipoles
+ * @param l an array of ell values
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return CCL_ClTemplates object
+ */
+CCL_ClTemplates *ccl_cl_templates_new(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+				      CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+				      int nl_out,int *l,int *status);
+
+/**
+ * Evaluates the angular power spectrum for a given set of nuisance parameters.
+ * @param t CCL_ClTemplates object
+ * @param p1 nuisance parameters of the first tracer (n_par1 elements)
+ * @param p2 nuisance parameters of the second tracer (n_par2 elements)
+ * @param cl the C_ell output array, with nl elements
+ * @return void
+ */
+void ccl_cl_templates_eval(CCL_ClTemplates *t,double *p1,double *p2,double *cl);
+
+//CCL_ClTemplates destructor
+void ccl_cl_templates_free(CCL_ClTemplates *t);
+
+/**
+ * Computes the Gaussian covariance of the binned angular power spectra between all pairs
+ * of a set of tracers. The n_pairs=n_tracers*(n_tracers+1)/2 pairs (i,j) with i<=j are
+ * ordered as (0,0),(0,1),...,(0,n_tracers-1),(1,1),... Bandpowers are averages of C_ell
+ * weighted by (2*ell+1). Since the Gaussian covariance does not couple different bins,
+ * only its diagonal blocks are returned.
+ * @param cosmo Cosmological parameters
+ * @param w a ClWorkspace
+ * @param n_tracers number of tracers
+ * @param clts array of n_tracers ClTracers
+ * @param noise noise power spectra, with n_tracers*n_tracers elements, N_ij=noise[i*n_tracers+j]. NULL for no noise.
+ * @param fsky sky fraction
+ * @param n_bins number of ell bins
+ * @param l_edges bin edges (n_bins+1 elements). Bin b contains l_edges[b]<=ell<l_edges[b+1].
+ * @param cl_binned output bandpowers (without noise) of pair p in bin b stored in cl_binned[p*n_bins+b]. May be NULL.
+ * @param cov output covariance between pairs p and q in bin b, stored in cov[(b*n_pairs+p)*n_pairs+q].
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * For specific cases see documentation for ccl_error.c
+ * @return void
+ */
+void ccl_angular_cls_gaussian_covariance(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+					 int n_tracers,CCL_ClTracer **clts,double *noise,
+					 double fsky,int n_bins,int *l_edges,
+					 double *cl_binned,double *cov,int *status);
+
 CCL_END_DECLS
 
 
@@ -114,6 +114,13 @@ typedef struct ccl_data{
   double k_min_nl;
   double k_max_lin;
   double k_max_nl;
+
+  // Multipoles of the redshift-space correlation function, stored for a few
+  // values of the scale factor (see ccl_correlation_multipole_spline)
+  struct ccl_xir_cache *xir;
+
+  // Direct-indexed distance table (see ccl_convert_distances)
+  struct ccl_distance_table *dist_table;
 } ccl_data;
 
 /**
@@ -202,6 +209,23 @@ ccl_parameters ccl_parameters_create_flat_lcdm(double Omega_c, double Omega_b, d
  */
 void ccl_parameters_free(ccl_parameters * params);
 
+/**
+ * Compare two parameters structs field by field, including the
+ * neutrino masses and the modified growth arrays.
+ * @param p1 ccl_parameters struct
+ * @param p2 ccl_parameters struct
+ * @return 1 if all parameters have the same values, 0 otherwise
+ */
+int ccl_parameters_equal(const ccl_parameters *p1, const ccl_parameters *p2);
+
+/**
+ * Compare two configuration structs.
+ * @param c1 ccl_configuration struct
+ * @param c2 ccl_configuration struct
+ * @return 1 if they select the same methods, 0 otherwise
+ */
+int ccl_configuration_equal(const ccl_configuration *c1, const ccl_configuration *c2);
+
 
 /**
  * Write a cosmology parameters object to a file in yaml format, .
@@ -11,6 +11,10 @@
 #define CCL_CORR_LP 2003
 #define CCL_CORR_LM 2004
 
+//Maximum number of scale factors for which a cosmology stores the
+//multipoles of the redshift-space correlation function
+#define CCL_CORR_XIR_CACHE_SIZE 32
+
 CCL_BEGIN_DECLS
 
 /**
@@ -27,7 +31,7 @@ CCL_BEGIN_DECLS
  * @param flag_method : method to compute the correlation function. Choose between:
  *  - CCL_CORR_FFTLOG : fast integration with FFTLog
  *  - CCL_CORR_BESSEL : direct integration over the Bessel function
- *  - CCL_CORR_LGNDRE : brute-force sum over legendre polynomials
+ *  - CCL_CORR_LGNDRE : full-sky sum over Legendre polynomials (Wigner d-functions for xi+-)
  * @param corr_type : type of correlation function. Choose between:
  *  - CCL_CORR_GG : spin0-spin0
  *  - CCL_CORR_GL : spin0-spin2
@@ -41,6 +45,35 @@ void ccl_correlation(ccl_cosmology *cosmo,
 		     int corr_type,int do_taper_cl,double *taper_cl_limits,int flag_method,
 		     int *status);
 
+/**
+ * Computes several correlation functions for a set of power spectra sampled at the
+ * same multipoles, e.g. xi+ and xi- for all the pairs of redshift bins.
+ * With CCL_CORR_FFTLOG, the power spectra are transformed together for each distinct
+ * Bessel order, sharing the FFTs of the inputs and the FFTLog coefficients.
+ * Other methods compute each correlation function as in ccl_correlation.
+ * @param cosmo :Cosmological parameters
+ * @param n_ell : number of multipoles in the input power spectra
+ * @param ell : multipoles at which the power spectra are evaluated
+ * @param n_cls : number of input power spectra
+ * @param cls : input power spectra, with n_cls*n_ell elements. Spectrum i at ell[j] is cls[i*n_ell+j].
+ * @param n_theta : number of output values of the separation angle (theta)
+ * @param theta : values of the separation angle in degrees.
+ * @param n_types : number of correlation types
+ * @param corr_types : types of correlation function (see ccl_correlation)
+ * @param wtheta : output array with n_types*n_cls*n_theta elements, which should be pre-allocated.
+ * Correlation type t of spectrum i at theta[k] is stored in wtheta[(t*n_cls+i)*n_theta+k].
+ * @param do_taper_cl : key for tapering
+ * @param taper_cl_limits : limits of tapering
+ * @param flag_method : method to compute the correlation functions (see ccl_correlation)
+ * @param status : Status flag. 0 if there are no errors, nonzero otherwise.
+ */
+void ccl_correlation_multi(ccl_cosmology *cosmo,
+			   int n_ell,double *ell,int n_cls,double *cls,
+			   int n_theta,double *theta,
+			   int n_types,int *corr_types,double *wtheta,
+			   int do_taper_cl,double *taper_cl_limits,int flag_method,
+			   int *status);
+
 /**
  * Computes the 3dcorrelation function (wrapper)
  * @param cosmo :Cosmological parameters
@@ -56,13 +89,57 @@ void ccl_correlation_3d(ccl_cosmology *cosmo,double a,
 		     int do_taper_pk,double *taper_pk_limits,
 		     int *status);
 
+/**
+ * Computes the 3d correlation function at several scale factors.
+ * If use_growth is nonzero, the correlation function of the linear power spectrum is
+ * computed once at a=1 and rescaled by the square of the growth factor, which is exact
+ * for the linear power spectrum. Otherwise the non-linear correlation function is computed
+ * for each scale factor as in ccl_correlation_3d, in parallel.
+ * @param cosmo :Cosmological parameters
+ * @param n_a : number of scale factors
+ * @param a : scale factors
+ * @param n_r : number of output values of distance r
+ * @param r : values of the distance in Mpc
+ * @param xi : output array with n_a*n_r elements, which should be pre-allocated.
+ * The correlation function at a[i] and r[j] is stored in xi[i*n_r+j].
+ * @param use_growth : key for the linear growth rescaling
+ * @param do_taper_pk : key for tapering (using cosine tapering by default)
+ * @param taper_pk_limits: limits of tapering
+ * @param status : Status flag. 0 if there are no errors, nonzero otherwise.
+ */
+void ccl_correlation_3d_multi(ccl_cosmology *cosmo,int n_a,double *a,
+			      int n_r,double *r,double *xi,int use_growth,
+			      int do_taper_pk,double *taper_pk_limits,
+			      int *status);
+
 void ccl_correlation_multipole(ccl_cosmology *cosmo,double a,double beta,
 			   int l,int n_s,double *s,double *xi,
 			   int *status);
 
+/**
+ * Computes the multipoles l=0,2,4 of the redshift-space correlation function at
+ * scale factor a and stores their splines in the cosmology, where they are used
+ * by ccl_correlation_3dRsd and ccl_correlation_pi_sigma with use_spline=1.
+ * Splines are stored for up to CCL_CORR_XIR_CACHE_SIZE values of a, replacing the
+ * least recently used ones. Nothing is done if the splines for a are already stored.
+ * The stored splines may be used from several threads at the same time.
+ * @param cosmo : Cosmological parameters
+ * @param a : scale factor
+ * @param status : Status flag. 0 if there are no errors, nonzero otherwise.
+ */
 void ccl_correlation_multipole_spline(ccl_cosmology *cosmo,double a,int *status);
 
-void ccl_correlation_multipole_spline_free();
+/**
+ * Frees all the multipole splines stored in a cosmology. They are also freed
+ * with the cosmology. Must not be called while other threads use them.
+ * The stored splines are discarded automatically when the cosmological parameters
+ * or the 3D correlation settings in ccl_splines change.
+ * Note that, unlike in previous versions (where it took no arguments and freed
+ * splines shared by all cosmologies), this function takes the cosmology whose
+ * splines should be freed. Nothing is done if cosmo is NULL.
+ * @param cosmo : Cosmological parameters
+ */
+void ccl_correlation_multipole_spline_free(ccl_cosmology *cosmo);
 
 void ccl_correlation_3dRsd(ccl_cosmology *cosmo,double a,
 			   int n_s,double *s,double mu,double beta,double *xi,
@@ -76,6 +153,45 @@ void ccl_correlation_pi_sigma(ccl_cosmology *cosmo,double a,double beta,
 			   double pi,int n_sig,double *sig,double *xi,
 			   int use_spline,int *status);
 
+/**
+ * Computes the redshift-space correlation function on a grid of line-of-sight (pi)
+ * and transverse (sigma) separations in one call.
+ * @param cosmo : Cosmological parameters
+ * @param a : scale factor
+ * @param beta : growth rate divided by galaxy bias
+ * @param n_pi : number of values of pi
+ * @param pi : values of pi in Mpc
+ * @param n_sig : number of values of sigma
+ * @param sig : values of sigma in Mpc
+ * @param xi : output array with n_pi*n_sig elements, which should be pre-allocated.
+ * The correlation function at pi[i] and sig[j] is stored in xi[i*n_sig+j].
+ * @param use_spline : if nonzero, use the multipole splines stored in the cosmology
+ * (see ccl_correlation_multipole_spline)
+ * @param status : Status flag. 0 if there are no errors, nonzero otherwise.
+ */
+void ccl_correlation_pi_sigma_grid(ccl_cosmology *cosmo,double a,double beta,
+				   int n_pi,double *pi,int n_sig,double *sig,double *xi,
+				   int use_spline,int *status);
+
+/**
+ * Computes the projected correlation function
+ * w_p(r_p) = 2 \int_0^{pi_max} dpi xi(pi, r_p)
+ * of the linear redshift-space correlation function, using fixed-order quadrature
+ * over pi. The multipoles of the correlation function are computed once and stored
+ * in the cosmology as in ccl_correlation_multipole_spline.
+ * @param cosmo : Cosmological parameters
+ * @param a : scale factor
+ * @param beta : growth rate divided by galaxy bias
+ * @param pi_max : maximum line-of-sight separation in Mpc
+ * @param n_rp : number of output values of r_p
+ * @param rp : values of the transverse separation r_p in Mpc
+ * @param wp : the values of w_p at the separations above (in Mpc) will be returned in this array, which should be pre-allocated
+ * @param status : Status flag. 0 if there are no errors, nonzero otherwise.
+ */
+void ccl_correlation_wp(ccl_cosmology *cosmo,double a,double beta,
+			double pi_max,int n_rp,double *rp,double *wp,
+			int *status);
+
 CCL_END_DECLS
 
 #endif
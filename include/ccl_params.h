@@ -35,6 +35,9 @@ typedef struct ccl_spline_params {
   double K_MIN;
   int N_K;
   int N_K_3DCOR;
+  int N_K_3DCOR_LEAN;
+  double K_EXTRAP_3DCOR;
+  double ZEROPAD_3DCOR;
 
   //Correlation function parameters
   double ELL_MIN_CORR;
@@ -12,7 +12,43 @@
 #define Z_MIN_SOURCES 0.
 #define Z_MAX_SOURCES 5.0
 
+/**
+ * Tabulation methods for photo-z models (see ccl_photoz_info_tabulate).
+ */
+#define CCL_PZ_TABLE_GRID 0 // P(z_ph|z) on a (z_true, z_ph) grid
+#define CCL_PZ_TABLE_SHIFT_Z 1 // P(z_ph|z) depends only on z_ph-z
+#define CCL_PZ_TABLE_SHIFT_LOGZ 2 // P(z_ph|z) (1+z_ph) depends only on ln((1+z_ph)/(1+z))
+
 CCL_BEGIN_DECLS
+/**
+ * Tabulated photo-z model.
+ * Holds a photo-z pdf sampled on uniform grids, together with its cumulative
+ * integral over photo-z, so that the probability of a galaxy lying in a bin is
+ * found by direct lookup.
+ */
+typedef struct {
+        int method; /*< One of the CCL_PZ_TABLE_* methods */
+        int n_zt; /*< Number of true-redshift nodes (1 for shift-invariant kernels) */
+        double zt_min, dzt; /*< First true-redshift node and grid spacing */
+        int n_x; /*< Number of photo-z (or photo-z offset) nodes */
+        double x_min, dx; /*< First photo-z (or offset) node and grid spacing */
+        double *pz; /*< Kernel, pz[i_zt*n_x+i_x] */
+        double *cdf; /*< Cumulative integral of the kernel over x, same layout as pz */
+} pz_table;
+
+/**
+ * Redshift sampler.
+ * Cumulative distribution of a redshift distribution on a uniform grid, together
+ * with a guide table used to invert it in constant time.
+ */
+typedef struct {
+        int n_z; /*< Number of redshift nodes */
+        double z_min, dz; /*< First redshift node and grid spacing */
+        double *pdf; /*< Normalized distribution at the nodes */
+        double *cdf; /*< Cumulative distribution at the nodes, from 0 to 1 */
+        int *guide; /*< guide[k] is the last node with cdf <= k/n_z */
+} dNdz_sampler;
+
 /** 
  * P(z) function.
  * This is a P(z) function (which can be user defined) 
@@ -22,6 +58,7 @@ typedef struct {
         double (* your_pz_func)(double, double, void *, int*); /*< Function returns the likelihood of measuring a z_ph
         * (first double) given a z_spec (second double), with a pointer to additonal arguments and a status flag.*/
         void *  your_pz_params; /*< Additional parameters to be passed into your_pz_func */
+        pz_table * your_pz_table; /*< If not NULL, tabulated version of your_pz_func used for bin probabilities */
 } pz_info;
 
 /** 
@@ -60,6 +97,64 @@ typedef struct {
  */
 void ccl_dNdz_tomog(double z, double bin_zmin, double bin_zmax, pz_info * photo_info,  dNdz_info * dN_info, double *tomoout, int *status);
 
+/** 
+ * Return dNdz in several tomographic bins, convolved with a photo-z model and normalized,
+ * for an array of redshifts. The normalization of each bin is computed only once, and the
+ * probability of the photo-z lying in a bin is computed in closed form for the built-in
+ * Gaussian photo-z model.
+ * @param n_z number of redshifts
+ * @param z redshifts
+ * @param n_bins number of tomographic bins
+ * @param bin_edges array of n_bins+1 photo-z bin edges. Bin i is [bin_edges[i],bin_edges[i+1]].
+ * @param photo_info the P(z) info struct
+ * @param dN_info the true dNdz info struct
+ * @param tomoout the output dN/dz, with n_bins*n_z elements. Bin i at z[j] is stored in tomoout[i*n_z+j].
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * @return void 
+ */
+void ccl_dNdz_tomog_multi(int n_z, double *z, int n_bins, double *bin_edges,
+			  pz_info * photo_info, dNdz_info * dN_info, double *tomoout, int *status);
+
+/**
+ * Create a sampler for a redshift distribution. If photo_info is NULL, this is the true
+ * dNdz. Otherwise it is the true dNdz of the photometric bin [bin_zmin,bin_zmax], as in
+ * ccl_dNdz_tomog. The distribution is evaluated once at n_z uniformly spaced redshifts
+ * in [z_min,z_max], interpolated linearly between them and taken to vanish outside.
+ * @param dN_info the true dNdz info struct
+ * @param photo_info the P(z) info struct, or NULL
+ * @param bin_zmin the minimum photo-z of the tomographic bin (unused if photo_info is NULL)
+ * @param bin_zmax the maximum photo-z of the tomographic bin (unused if photo_info is NULL)
+ * @param n_z number of redshift nodes
+ * @param z_min minimum redshift
+ * @param z_max maximum redshift
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * @return the sampler, to be freed with ccl_dNdz_sampler_free, or NULL on errors
+ */
+dNdz_sampler *ccl_dNdz_sampler_new(dNdz_info *dN_info, pz_info *photo_info,
+				   double bin_zmin, double bin_zmax,
+				   int n_z, double z_min, double z_max, int *status);
+
+/**
+ * Draw redshifts by inverting the cumulative distribution of a sampler.
+ * Each output redshift is a deterministic function of the corresponding uniform deviate,
+ * so the random stream is fully controlled by the caller. Deviates are processed in parallel.
+ * @param sampler the redshift sampler
+ * @param n number of redshifts to draw
+ * @param u n uniform deviates in [0,1]
+ * @param z_out output array of n redshifts
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * Deviates outside [0,1] (or NaN) are clamped to the nearest end of the range (NaN to 0),
+ * and status is set to CCL_ERROR_INCONSISTENT.
+ * @return void
+ */
+void ccl_dNdz_sampler_draw(dNdz_sampler *sampler, int n, double *u, double *z_out, int *status);
+
+/** Free a redshift sampler.
+ * @param sampler the redshift sampler
+ * @return void
+ */
+void ccl_dNdz_sampler_free(dNdz_sampler *sampler);
+
 /** 
  * This function creates a structure amalgamating the information on an analytic true dNdz, plus some parameters.
  * @param params parameters for the analytic dNdz form
@@ -103,6 +198,29 @@ pz_info* ccl_create_photoz_info(void * params, double(*pz_func)(double, double,v
 pz_info* ccl_create_gaussian_photoz_info(double sigma_z0);
 
 
+/**
+ * Tabulate a photo-z model, so that later calls to ccl_dNdz_tomog and ccl_dNdz_tomog_multi
+ * evaluate your_pz_func once per node instead of integrating it for each redshift and bin.
+ * For CCL_PZ_TABLE_GRID the pdf is sampled at n_zt true redshifts in [Z_MIN_SOURCES,zt_max]
+ * and n_x photo-z values in [x_min,x_max]; outside [Z_MIN_SOURCES,zt_max] the pdf at the
+ * closest true redshift is used. For the shift-invariant methods, the pdf is sampled once
+ * at z=0, as a function of the offset x=z_ph-z (CCL_PZ_TABLE_SHIFT_Z) or
+ * x=ln((1+z_ph)/(1+z)) (CCL_PZ_TABLE_SHIFT_LOGZ), for n_x values of x in [x_min,x_max];
+ * n_zt and zt_max are ignored. In all cases the pdf is taken to vanish outside [x_min,x_max].
+ * Calling this function again replaces the previous table.
+ * @param photo_info the P(z) info struct
+ * @param method one of CCL_PZ_TABLE_GRID, CCL_PZ_TABLE_SHIFT_Z or CCL_PZ_TABLE_SHIFT_LOGZ
+ * @param n_zt number of true-redshift nodes (CCL_PZ_TABLE_GRID only)
+ * @param zt_max maximum true redshift (CCL_PZ_TABLE_GRID only)
+ * @param n_x number of photo-z (or offset) nodes
+ * @param x_min minimum photo-z (or offset)
+ * @param x_max maximum photo-z (or offset)
+ * @param status Status flag. 0 if there are no errors, nonzero otherwise.
+ * @return void
+ */
+void ccl_photoz_info_tabulate(pz_info *photo_info, int method, int n_zt, double zt_max,
+			      int n_x, double x_min, double x_max, int *status);
+
 /** Free memory holding the structure containing user-input photoz information.
  * @param my_photoz_info that holds user-defined P(z) and parameters
  * @return void
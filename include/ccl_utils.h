@@ -44,11 +44,12 @@ double ccl_j_bessel(int l,double x);
 
 /**
  * Spline wrapper
- * Used to take care of evaluations outside the supported range
+ * Used to take care of evaluations outside the supported range.
+ * Evaluations do not modify the spline, so they are thread-safe.
  */
 typedef struct {
-  gsl_interp_accel *intacc; //GSL spline
-  gsl_spline *spline;
+  gsl_interp_accel *intacc; //Unused, always NULL. Kept so that the layout of SplPar doesn't change
+  gsl_spline *spline; //GSL spline
   double x0,xf; //Interpolation limits
   double y0,yf; //Constant values to use beyond interpolation limit
 } SplPar;
@@ -27,28 +27,40 @@ These are the C++ bindings
 
 /* Compute the correlation function xi(r) from a power spectrum P(k), sampled
  * at logarithmically spaced points k[j]. */
-void pk2xi(int N,  const double k[],  const double pk[], double r[], double xi[]);
+int pk2xi(int N,  const double k[],  const double pk[], double r[], double xi[]);
 
 /* Compute the power spectrum P(k) from a correlation function xi(r), sampled
  * at logarithmically spaced points r[i]. */
-void xi2pk(int N,  const double r[],  const double xi[], double k[], double pk[]);
+int xi2pk(int N,  const double r[],  const double xi[], double k[], double pk[]);
 
 /* Compute the function
  *   \xi_l^m(r) = \int_0^\infty \frac{dk}{2\pi^2} k^m j_l(kr) P(k)
  * Note that the usual 2-point correlation function xi(r) is just xi_0^2(r)
  * in this notation.  The input k-values must be logarithmically spaced.  The
  * resulting xi_l^m(r) will be evaluated at the dual r-values
- *   r[0] = 1/k[N-1], ..., r[N-1] = 1/k[0]. */
-void fftlog_ComputeXiLM(double l, double m, int N, const double k[],  const double pk[],
+ *   r[0] = 1/k[N-1], ..., r[N-1] = 1/k[0].
+ * The transform is done with a cached plan (see fftlog_plan_get).
+ * Returns 0 on success and 1 if memory could not be allocated. */
+int fftlog_ComputeXiLM(double l, double m, int N, const double k[],  const double pk[],
 			double r[], double xi[]);
 
 /* Compute the function
  *   \xi_\alpha(\theta) = \int_0^\infty \frac{d\ell}{2\pi} \ell J_\alpha(\ell\theta) C_\ell
  * The input l-values must be logarithmically spaced.  The
  * resulting xi_alpha(th) will be evaluated at the dual th-values
- *   th[0] = 1/l[N-1], ..., th[N-1] = 1/l[0]. */
-void fftlog_ComputeXi2D(double bessel_order,int N,const double l[],const double cl[],
+ *   th[0] = 1/l[N-1], ..., th[N-1] = 1/l[0].
+ * Returns 0 on success and 1 if memory could not be allocated. */
+int fftlog_ComputeXi2D(double bessel_order,int N,const double l[],const double cl[],
 			double th[], double xi[]);
+
+/* Same as fftlog_ComputeXi2D for n_cl power spectra cl[i*N+j] (all sampled at
+ * the same l[j]) and n_orders Bessel orders at once. The forward FFTs of all
+ * the spectra are done in a single multi-transform and shared by all orders.
+ * The dual th-values for bessel_order[o] are returned in th[o*N+j] and
+ * xi_o for spectrum i in xi[(o*n_cl+i)*N+j].
+ * Returns 0 on success and 1 if memory could not be allocated. */
+int fftlog_ComputeXi2D_many(int n_orders, const double bessel_order[], int n_cl, int N,
+                            const double l[], const double cl[], double th[], double xi[]);
 #include <complex.h>
 
 /* Compute the discrete Hankel transform of the function a(r).  See the FFTLog
@@ -68,6 +80,41 @@ void fht(int N,  const double r[],  const double complex a[], double k[], double
  *   L = N * log(r[N-1]/r[0])/(N-1) */
 void compute_u_coefficients(int N, double mu, double q, double L, double kcrc, double complex u[]);
 
+/* A reusable version of fht() for real input arrays. It stores the FFTW plans
+ * (real-to-complex and back), the u coefficients and aligned work buffers for
+ * a given transform size N, order mu, bias q and log-range L (defined as in
+ * compute_u_coefficients).  kcrc and noring have the same meaning as in fht().
+ * A plan may be used for any input array with the same N and L, but not by
+ * several threads at the same time.  If FFTW was built with OpenMP support
+ * (HAVE_FFTW_OMP), large transforms planned outside parallel regions are
+ * multi-threaded. */
+typedef struct fftlog_plan_s fftlog_plan;
+
+/* Create a plan. Returns NULL if memory could not be allocated. */
+fftlog_plan* fftlog_plan_new(int N, double mu, double q, double L, double kcrc, int noring);
+
+/* Free a plan created with fftlog_plan_new. */
+void fftlog_plan_free(fftlog_plan* p);
+
+/* Same as fht() for the plan's parameters, with real input a(r) and output b(k). */
+void fftlog_plan_execute(fftlog_plan* p, const double r[], const double a[], double k[], double b[]);
+
+/* Return a plan with the given parameters from a small per-thread cache,
+ * creating it if needed.  The plan is owned by the cache and must not be freed,
+ * and is only valid until the next call to fftlog_plan_get or
+ * fftlog_plan_cache_clear from the same thread. Returns NULL on memory errors. */
+fftlog_plan* fftlog_plan_get(int N, double mu, double q, double L, double kcrc, int noring);
+
+/* Free all the plans cached by the calling thread. The cache holds at most
+ * 8 plans per thread, each with buffers of about 3*N doubles, so large
+ * transforms should not be left in it for the life of the process. */
+void fftlog_plan_cache_clear(void);
+
+/* Free the plans cached by all the threads of a parallel region with the
+ * default number of threads (only those of the calling thread if called from
+ * within a parallel region). Called by ccl_cosmology_free. */
+void fftlog_plan_cache_clear_all(void);
+
 
 #endif // FFTLOG_H
 
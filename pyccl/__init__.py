@@ -28,7 +28,7 @@ from .core import Cosmology
 from .background import growth_factor, growth_factor_unnorm, \
     growth_rate, comoving_radial_distance, comoving_angular_distance, \
     h_over_h0, luminosity_distance, distance_modulus, scale_factor_of_chi, \
-    omega_x, rho_x
+    omega_x, rho_x, convert_distances
 
 # Power spectrum calculations and sigma8
 from .power import linear_matter_power, nonlin_matter_power, sigmaR, \
@@ -40,13 +40,13 @@ from .massfunction import massfunc, massfunc_m2r, sigmaM, halo_bias
 # Cl's and tracers
 from .cls import angular_cl, NumberCountsTracer, WeakLensingTracer, CMBLensingTracer
 
-from .redshifts import  dNdz_tomog, PhotoZFunction, PhotoZGaussian, dNdzFunction, dNdzSmail
+from .redshifts import  dNdz_tomog, dNdz_tomog_multi, PhotoZFunction, PhotoZGaussian, dNdzFunction, dNdzSmail, dNdzSampler
 
 # Useful constants and unit conversions
 from .constants import CLIGHT_HMPC, MPC_TO_METER, PC_TO_METER, \
                       GNEWT, RHO_CRITICAL, SOLAR_MASS
 
-from .correlation import correlation, correlation_3d, correlation_multipole, correlation_3dRsd, correlation_3dRsd_avgmu, correlation_spline_free, correlation_pi_sigma
+from .correlation import correlation, correlation_3d, correlation_multipole, correlation_3dRsd, correlation_3dRsd_avgmu, correlation_spline_free, correlation_pi_sigma, correlation_wp
 
 # Properties of haloes
 from .halomodel import halomodel_matter_power, halo_concentration
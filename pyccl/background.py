@@ -13,7 +13,19 @@ CCL defines seven species types:
 These strings define the `species` inputs to the functions below.
 """
 from . import ccllib as lib
+from .core import check
 from .pyutils import _vectorize_fn, _vectorize_fn3, _vectorize_fn4
+import numpy as np
+
+distance_conversions = {
+    'comoving_radial':      lib.CCL_DIST_CHI,
+    'comoving_angular':     lib.CCL_DIST_DM,
+    'angular_diameter':     lib.CCL_DIST_DA,
+    'luminosity':           lib.CCL_DIST_DL,
+    'distance_modulus':     lib.CCL_DIST_MU,
+    'z_of_comoving_radial': lib.CCL_DIST_Z_OF_CHI,
+    'z_of_luminosity':      lib.CCL_DIST_Z_OF_DL,
+}
 
 species_types = {
     'critical':                   lib.species_crit_label,
@@ -167,6 +179,42 @@ def scale_factor_of_chi(cosmo, chi):
                          lib.scale_factor_of_chi_vec, cosmo, chi)
 
 
+def convert_distances(cosmo, x, kind):
+    """Convert redshifts into distances, or distances into redshifts, for
+    large catalogues. This uses tables computed once per cosmology, which
+    are interpolated in parallel without searching, so the input does not
+    need to be sorted.
+
+    Args:
+        cosmo (:obj:`Cosmology`): Cosmological parameters.
+        x (float or array_like): Redshift(s), or distance(s) in Mpc for
+            'z_of_comoving_radial' and 'z_of_luminosity'.
+        kind (string): conversion type. Available:
+            'comoving_radial', 'comoving_angular', 'angular_diameter',
+            'luminosity', 'distance_modulus' (from redshift),
+            'z_of_comoving_radial', 'z_of_luminosity' (to redshift).
+
+    Returns:
+        float or array_like: Distance(s) in Mpc, distance modulus or
+        redshift(s).
+    """
+    if kind not in distance_conversions.keys():
+        raise ValueError("'%s' is not a valid conversion type. "
+                         "Available options are: %s"
+                         % (kind, distance_conversions.keys()))
+
+    scalar = np.ndim(x) == 0
+    x = np.atleast_1d(np.asarray(x, dtype=float))
+    status = 0
+    out, status = lib.convert_distances_vec(cosmo.cosmo,
+                                            distance_conversions[kind],
+                                            x, x.size, status)
+    check(status, cosmo)
+    if scalar:
+        return out[0]
+    return out
+
+
 def omega_x(cosmo, a, species):
     """Density fraction of a given species at a redshift different than z=0.
 
@@ -7,6 +7,7 @@
 // Enable vectorised arguments for arrays
 %apply (double* IN_ARRAY1, int DIM1) {(double* a, int na)};
 %apply (double* IN_ARRAY1, int DIM1) {(double* chi, int nchi)};
+%apply (double* IN_ARRAY1, int DIM1) {(double* input, int ninput)};
 %apply (int DIM1, double* ARGOUT_ARRAY1) {(int nout, double* output)};
 
 %include "../include/ccl_background.h"
@@ -91,5 +92,20 @@ void scale_factor_of_chi_vec(ccl_cosmology * cosmo, double* chi, int nchi,
 
 %}
 
+%feature("pythonprepend") convert_distances_vec %{
+    if numpy.shape(input) != (nout,):
+        raise CCLError("Input shape for `input` must match `(nout,)`!")
+%}
+
+%inline %{
+
+void convert_distances_vec(ccl_cosmology * cosmo, int dist_type,
+                           double* input, int ninput,
+                           int nout, double* output, int *status) {
+    ccl_convert_distances(cosmo, dist_type, ninput, input, output, status);
+}
+
+%}
+
 /* The directive gets carried between files, so we reset it at the end. */
 %feature("pythonprepend") %{ %}
@@ -76,6 +76,7 @@ CCL_ClTracer* cl_tracer_new_wrapper(ccl_cosmology *cosmo, int tracer_type,
 
 void angular_cl_vec(ccl_cosmology * cosmo, CCL_ClTracer *clt1, CCL_ClTracer *clt2,
                     double l_limber, double l_logstep, double l_linstep,
+                    int limber_method, CCL_ClCache *cache,
                     double* ell, int nell, int nout, double* output, int *status) {
   //Cast ells as integers
   int *ell_int = malloc(nell * sizeof(int));
@@ -85,12 +86,23 @@ void angular_cl_vec(ccl_cosmology * cosmo, CCL_ClTracer *clt1, CCL_ClTracer *clt
 					    l_logstep,
 					    (int)l_linstep,
 					    status);
+  if((w == NULL) || (ell_int == NULL) || (*status)) {
+    if((*status == 0) && (ell_int == NULL))
+      *status = CCL_ERROR_MEMORY;
+    free(ell_int);
+    ccl_cl_workspace_free(w);
+    return;
+  }
+  w->limber_method = limber_method;
 
   for(int i=0; i < nell; i++)
     ell_int[i] = (int)(ell[i]);
 
   //Compute C_ells
-  ccl_angular_cls(cosmo, w, clt1, clt2, nell, ell_int, output, status);
+  if(cache == NULL)
+    ccl_angular_cls(cosmo, w, clt1, clt2, nell, ell_int, output, status);
+  else
+    ccl_angular_cls_cached(cosmo, w, cache, clt1, clt2, nell, ell_int, output, status);
 
   free(ell_int);
   ccl_cl_workspace_free(w);
@@ -12,12 +12,16 @@
     (double* clarr, int nclarr),
     (double* theta, int nt),
     (double* r, int nr),
+    (double* aarr, int naarr),
     (double* s, int ns),
-    (double* sig, int nsig)}
+    (double* sig, int nsig),
+    (double* pie, int npie),
+    (double* rp, int nrp)}
 %apply (int DIM1, double* ARGOUT_ARRAY1) {
     (int nout, double* output),
     (int nxi, double* xi),
-    (int nxis, double* xis)};
+    (int nxis, double* xis),
+    (int nwp, double* wp)};
 
 %feature("pythonprepend") correlation_vec %{
     if numpy.shape(larr) != numpy.shape(clarr):
@@ -32,6 +36,11 @@
         raise CCLError("Input shape for `r` must match `(nxi,)`!")
 %}
 
+%feature("pythonprepend") correlation_3d_multi_vec %{
+    if numpy.shape(aarr)[0] * numpy.shape(r)[0] != nxi:
+        raise CCLError("Input shape for `nxi` must match `len(aarr) * len(r)`!")
+%}
+
 %feature("pythonprepend") correlation_multipole_vec %{
     if numpy.shape(s) != (nxis,):
         raise CCLError("Input shape for `s` must match `(nxis,)`!")
@@ -52,6 +61,16 @@
         raise CCLError("Input shape for `sig` must match `(nxis,)`!")
 %}
 
+%feature("pythonprepend") correlation_pi_sigma_grid_vec %{
+    if numpy.shape(pie)[0] * numpy.shape(sig)[0] != nxis:
+        raise CCLError("Input shape for `nxis` must match `len(pie) * len(sig)`!")
+%}
+
+%feature("pythonprepend") correlation_wp_vec %{
+    if numpy.shape(rp) != (nwp,):
+        raise CCLError("Input shape for `rp` must match `(nwp,)`!")
+%}
+
 %inline %{
 
 void correlation_vec(ccl_cosmology *cosmo, double* larr, int nlarr,
@@ -68,6 +87,13 @@ void correlation_3d_vec(ccl_cosmology *cosmo,double a, double* r, int nr,
   ccl_correlation_3d(cosmo, a, nr, r, xi, 0, NULL, status);
 }
 
+void correlation_3d_multi_vec(ccl_cosmology *cosmo, double* aarr, int naarr,
+                              double* r, int nr, int use_growth,
+                              int nxi, double* xi, int *status) {
+  ccl_correlation_3d_multi(cosmo, naarr, aarr, nr, r, xi, use_growth,
+                           0, NULL, status);
+}
+
 void correlation_multipole_vec(ccl_cosmology *cosmo,double a,double beta,
 			       int l,double *s,int ns,
                                int nxis,double *xis,
@@ -95,7 +121,21 @@ void correlation_pi_sigma_vec(ccl_cosmology *cosmo,double a,double beta,
     ccl_correlation_pi_sigma(cosmo,a,beta,pie,nsig,sig,xis,use_spline,status);
 }
 
-void correlation_multipole_spline_free_vec(){
-    ccl_correlation_multipole_spline_free();
+void correlation_pi_sigma_grid_vec(ccl_cosmology *cosmo,double a,double beta,
+				   double *pie,int npie,double *sig,int nsig,
+				   int use_spline,int nxis,double* xis,
+				   int *status){
+    ccl_correlation_pi_sigma_grid(cosmo,a,beta,npie,pie,nsig,sig,xis,
+				  use_spline,status);
+}
+
+void correlation_wp_vec(ccl_cosmology *cosmo,double a,double beta,
+			double pi_max,double *rp,int nrp,int nwp,double* wp,
+			int *status){
+    ccl_correlation_wp(cosmo,a,beta,pi_max,nrp,rp,wp,status);
+}
+
+void correlation_multipole_spline_free_vec(ccl_cosmology *cosmo){
+    ccl_correlation_multipole_spline_free(cosmo);
 }
 %}
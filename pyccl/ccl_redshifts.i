@@ -9,7 +9,9 @@
 // Enable vectorised arguments for arrays
 %apply (double* IN_ARRAY1, int DIM1) {
         (double* a, int na),
-        (double* z, int nz)
+        (double* z, int nz),
+        (double* bin_edges, int nedges),
+        (double* u, int nu)
 };
 %apply (int DIM1, double* ARGOUT_ARRAY1) {(int nout, double* output)};
 
@@ -53,6 +55,38 @@ void dNdz_tomog_vec(double bin_zmin, double bin_zmax,
 
 %}
 
+%feature("pythonprepend") dNdz_tomog_multi_vec %{
+    if numpy.shape(z)[0] * (numpy.shape(bin_edges)[0] - 1) != nout:
+        raise CCLError("Input shape for `nout` must match `len(z) * (len(bin_edges) - 1)`!")
+%}
+
+%inline %{
+
+// Vectorised version of ccl_dNdz_tomog_multi()
+void dNdz_tomog_multi_vec(double* bin_edges, int nedges,
+                          pz_info* user_pz_info, dNdz_info* user_dN_info,
+                          double* z, int nz, int nout, double* output, int *status) {
+    ccl_dNdz_tomog_multi(nz, z, nedges-1, bin_edges, user_pz_info, user_dN_info,
+                         output, status);
+}
+
+%}
+
+%feature("pythonprepend") dNdz_sampler_draw_vec %{
+    if numpy.shape(u) != (nout,):
+        raise CCLError("Input shape for `u` must match `(nout,)`!")
+%}
+
+%inline %{
+
+// Vectorised version of ccl_dNdz_sampler_draw()
+void dNdz_sampler_draw_vec(dNdz_sampler *sampler, double* u, int nu,
+                           int nout, double* output, int *status) {
+    ccl_dNdz_sampler_draw(sampler, nu, u, output, status);
+}
+
+%}
+
 /* The directive gets carried between files, so we reset it at the end. */
 %feature("pythonprepend") %{ %}
 
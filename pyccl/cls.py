@@ -13,6 +13,11 @@ function_types = {
     'mag_win': lib.trf_wM,
 }
 
+limber_integration_types = {
+    'qag_logk': lib.limber_qag_logk,
+    'gl_chi': lib.limber_gl_chi,
+}
+
 # Define symbolic 'None' type for arrays, to allow proper handling by swig
 # wrapper
 NoneArr = np.array([])
@@ -187,6 +192,24 @@ class Tracer(object):
         else:
             return farr
 
+    def set_photoz(self, cosmo, shift, stretch=1.):
+        """
+        Shift and stretch the redshift distribution of this tracer, as
+        N(z) -> N_0(<z> + (z - <z> - shift) / stretch) / stretch, where N_0
+        is the input N(z) and <z> its mean. The parameters are always
+        relative to the input N(z). Only valid for number counts and weak
+        lensing tracers.
+
+        Args:
+            cosmo (:obj:`Cosmology`): Cosmology object.
+            shift (float): shift in redshift.
+            stretch (float): stretch factor around the mean redshift.
+        """
+        status = 0
+        status = lib.cl_tracer_set_photoz(cosmo.cosmo, self.cltracer,
+                                          shift, stretch, status)
+        check(status, cosmo)
+
     def __del__(self):
         """Free memory associated with CCL_ClTracer object.
         """
@@ -284,7 +307,8 @@ def _check_array_params(f_arg):
 
 
 def angular_cl(cosmo, cltracer1, cltracer2, ell,
-               l_limber=-1., l_logstep=1.05, l_linstep=20.):
+               l_limber=-1., l_logstep=1.05, l_linstep=20.,
+               limber_integration='qag_logk'):
     """Calculate the angular (cross-)power spectrum for a pair of tracers.
 
     Args:
@@ -298,36 +322,54 @@ def angular_cl(cosmo, cltracer1, cltracer2, ell,
             Defaults to 1.05.
         l_linstep (float) : linear step in ell at high multipoles.
             Defaults to 20.
+        limber_integration (str) : method used to compute the Limber
+            integrals. 'qag_logk' uses adaptive quadrature in log(k),
+            while 'gl_chi' uses a fixed Gauss-Legendre quadrature in
+            comoving distance, which has the same cost for all
+            multipoles. Defaults to 'qag_logk'.
+
+    .. note:: If the cache of `cosmo` has been enabled (see
+        :meth:`Cosmology.enable_cl_cache`), the power spectrum is only
+        computed the first time it's requested for a given pair of
+        tracers and set of sampling parameters.
 
     Returns:
         float or array_like: Angular (cross-)power spectrum values,
             :math:`C_\\ell`, for the pair of tracers, as a function of
             :math:`\\ell`.
     """
-    # Access ccl_cosmology object
+    # Access ccl_cosmology object and its power spectrum cache
+    cache = getattr(cosmo, '_cl_cache', None)
     cosmo = cosmo.cosmo
 
     # Access CCL_ClTracer objects
     clt1 = cltracer1.cltracer
     clt2 = cltracer2.cltracer
 
+    if limber_integration not in limber_integration_types.keys():
+        raise ValueError("'%s' is not a valid Limber integration method. "
+                         "Available options are: %s"
+                         % (limber_integration,
+                            limber_integration_types.keys()))
+    limber_method = limber_integration_types[limber_integration]
+
     status = 0
     # Return Cl values, according to whether ell is an array or not
     if isinstance(ell, float) or isinstance(ell, int):
         # Use single-value function
         cl_one, status = lib.angular_cl_vec(
             cosmo, clt1, clt2, l_limber, l_logstep,
-            l_linstep, [ell], 1, status)
+            l_linstep, limber_method, cache, [ell], 1, status)
         cl = cl_one[0]
     elif isinstance(ell, np.ndarray):
         # Use vectorised function
         cl, status = lib.angular_cl_vec(
             cosmo, clt1, clt2, l_limber, l_logstep,
-            l_linstep, ell, ell.size, status)
+            l_linstep, limber_method, cache, ell, ell.size, status)
     else:
         # Use vectorised function
         cl, status = lib.angular_cl_vec(
             cosmo, clt1, clt2, l_limber, l_logstep,
-            l_linstep, ell, len(ell), status)
+            l_linstep, limber_method, cache, ell, len(ell), status)
     check(status)
     return cl
@@ -7,4 +7,7 @@ from .ccllib import (
     EPS_SCALEFAC_GROWTH, GNEWT,
     K_PIVOT, MPC_TO_METER, PC_TO_METER, RHO_CRITICAL, SOLAR_MASS, Z_MAX_SOURCES,
     Z_MIN_SOURCES, CCL_CORR_FFTLOG, CCL_CORR_BESSEL, CCL_CORR_LGNDRE,
-    CCL_CORR_GG, CCL_CORR_GL, CCL_CORR_LP, CCL_CORR_LM)
+    CCL_CORR_GG, CCL_CORR_GL, CCL_CORR_LP, CCL_CORR_LM,
+    CCL_PZ_TABLE_GRID, CCL_PZ_TABLE_SHIFT_Z, CCL_PZ_TABLE_SHIFT_LOGZ,
+    CCL_DIST_CHI, CCL_DIST_DM, CCL_DIST_DA, CCL_DIST_DL, CCL_DIST_MU,
+    CCL_DIST_Z_OF_CHI, CCL_DIST_Z_OF_DL)
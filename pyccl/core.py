@@ -260,6 +260,7 @@ class Cosmology(object):
         self._build_parameters(**self._params_init_kwargs)
         self._build_config(**self._config_init_kwargs)
         self.cosmo = lib.cosmology_create(self._params, self._config)
+        self._cl_cache = None
 
         if self.cosmo.status != 0:
             raise CCLError(
@@ -515,6 +516,9 @@ class Cosmology(object):
     def __del__(self):
         """Free the C memory this object is managing as it is being garbage
         collected (hopefully)."""
+        if hasattr(self, "_cl_cache"):
+            if self._cl_cache is not None:
+                lib.cl_cache_free(self._cl_cache)
         if hasattr(self, "cosmo"):
             if self.cosmo is not None:
                 lib.cosmology_free(self.cosmo)
@@ -527,6 +531,7 @@ class Cosmology(object):
         # is pure python when pickled.
         state = self.__dict__.copy()
         state.pop('cosmo', None)
+        state.pop('_cl_cache', None)
         state.pop('_params', None)
         state.pop('_config', None)
         return state
@@ -603,6 +608,35 @@ class Cosmology(object):
         status = lib.cosmology_compute_power(self.cosmo, status)
         check(status, self.cosmo)
 
+    def enable_cl_cache(self, max_entries=64):
+        """Store the angular power spectra computed with this cosmology, so
+        that later calls to :func:`angular_cl` for the same pair of tracers
+        and multipole sampling only need to interpolate them.
+
+        Args:
+            max_entries (int): Maximum number of power spectra to store. The
+                least recently used one is dropped when this is exceeded.
+        """
+        self.disable_cl_cache()
+        status = 0
+        return_val = lib.cl_cache_new(int(max_entries), status)
+        if (isinstance(return_val, int)):
+            check(return_val)
+        else:
+            self._cl_cache, status = return_val
+
+    def clear_cl_cache(self):
+        """Drop all the angular power spectra stored by the cache enabled
+        with :meth:`enable_cl_cache`."""
+        if self._cl_cache is not None:
+            lib.cl_cache_clear(self._cl_cache)
+
+    def disable_cl_cache(self):
+        """Drop the angular power spectrum cache, if enabled."""
+        if self._cl_cache is not None:
+            lib.cl_cache_free(self._cl_cache)
+            self._cl_cache = None
+
     def has_distances(self):
         """Checks if the distances have been precomputed.
 
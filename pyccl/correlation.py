@@ -3,13 +3,17 @@
 Choices of algorithms used to compute correlation functions:
     'Bessel' is a direct integration using Bessel functions.
     'FFTLog' is fast using a fast Fourier transform.
-    'Legendre' uses a sum over Legendre polynomials.
+    'Legendre' uses a full-sky sum over Legendre polynomials.
 """
 
 from . import ccllib as lib
 from . import constants as const
 from .core import check
 import numpy as np
+import weakref
+
+# Cosmology objects that may hold RSD multipole splines (see correlation_spline_free)
+_spline_cosmologies = weakref.WeakSet()
 
 correlation_methods = {
     'fftlog':   const.CCL_CORR_FFTLOG,
@@ -44,7 +48,8 @@ def correlation(cosmo, ell, C_ell, theta, corr_type='gg', method='fftlog'):
                                    Choices: 'Bessel' (direct integration over
                                    Bessel function), 'FFTLog' (fast
                                    integration with FFTLog), 'Legendre' (
-                                   brute-force sum over Legendre polynomials).
+                                   full-sky sum over Legendre polynomials,
+                                   or Wigner d-functions for 'L+' and 'L-').
 
     Returns:
         float or array_like: Value(s) of the correlation function at the input
@@ -81,17 +86,21 @@ def correlation(cosmo, ell, C_ell, theta, corr_type='gg', method='fftlog'):
     return wth
 
 
-def correlation_3d(cosmo, a, r):
+def correlation_3d(cosmo, a, r, linear_growth=False):
     """
     Compute the 3D correlation function.
 
     Args:
         cosmo (:obj:`Cosmology`): A Cosmology object.
-        a (float): scale factor.
+        a (float or array_like): scale factor(s).
         r (float or array_like): distance(s) at which to calculate the 3D
                                  correlation function (in Mpc).
+        linear_growth (bool): if True, the correlation function of the
+            linear power spectrum is computed at a=1 and rescaled by the
+            square of the growth factor at each scale factor.
     Returns:
         Value(s) of the correlation function at the input distance(s).
+        If `a` is an array, the result has shape `(len(a), len(r))`.
     """
     cosmo_in = cosmo
     cosmo = cosmo.cosmo
@@ -103,10 +112,24 @@ def correlation_3d(cosmo, a, r):
         scalar = True
         r = np.array([r, ])
 
-    # Call 3D correlation function
-    xi, status = lib.correlation_3d_vec(cosmo, a, r, len(r), status)
+    if np.ndim(a) == 0 and not linear_growth:
+        # Call 3D correlation function
+        xi, status = lib.correlation_3d_vec(cosmo, a, r, len(r), status)
+        check(status, cosmo_in)
+        if scalar:
+            return xi[0]
+        return xi
+
+    # All scale factors are computed in a single call
+    a_arr = np.atleast_1d(np.asarray(a, dtype=float))
+    xi, status = lib.correlation_3d_multi_vec(cosmo, a_arr, r,
+                                              int(linear_growth),
+                                              len(a_arr) * len(r), status)
     check(status, cosmo_in)
+    xi = xi.reshape((len(a_arr), len(r)))
     if scalar:
+        xi = xi[:, 0]
+    if np.ndim(a) == 0:
         return xi[0]
     return xi
 
@@ -149,7 +172,8 @@ with multipoles.
 correlation function (in Radian).
         beta (float): growth rate divided by galaxy bias.
         use_spline: switch that determines whether the RSD correlation
-function is calculated using global splines of multipoles.
+function is calculated using splines of multipoles stored in the
+Cosmology object for this scale factor.
     Returns:
         Value(s) of the correlation function at the input distance(s) & angle.
 
@@ -165,6 +189,8 @@ function is calculated using global splines of multipoles.
         s = np.array([s, ])
 
     # Call 3D correlation function
+    if use_spline:
+        _spline_cosmologies.add(cosmo_in)
     xis, status = lib.correlation_3dRsd_vec(cosmo, a, mu, beta, s, len(s),
                                             int(use_spline), status)
     check(status, cosmo_in)
@@ -214,12 +240,15 @@ def correlation_pi_sigma(cosmo, a, beta, pie, sig, use_spline=True):
     Args:
         cosmo (:obj:`Cosmology`): A Cosmology object.
         a (float): scale factor.
-        pie (float): distance times cosine of the angle (in Mpc).
+        pie (float or array_like): distance(s) times cosine of the angle
+(in Mpc).
         sig (float or array_like): distance(s) times sine of the
 angle (in Mpc).
         beta (float): growth rate divided by galaxy bias.
     Returns:
         Value(s) of the correlation function at the input pi and sigma.
+        If `pie` is an array, the result is a grid with shape
+        `(len(pie), len(sig))`.
 
     """
 
@@ -233,19 +262,85 @@ angle (in Mpc).
         scalar = True
         sig = np.array([sig, ])
 
-    # Call 3D correlation function
-    xis, status = lib.correlation_pi_sigma_vec(cosmo, a, beta, pie, sig,
-                                               len(sig), int(use_spline),
-                                               status)
+    if use_spline:
+        _spline_cosmologies.add(cosmo_in)
+
+    if np.ndim(pie) == 0:
+        # Call 3D correlation function
+        xis, status = lib.correlation_pi_sigma_vec(cosmo, a, beta, pie, sig,
+                                                   len(sig), int(use_spline),
+                                                   status)
+        check(status, cosmo_in)
+        if scalar:
+            return xis[0]
+        return xis
+
+    # The whole (pi, sigma) grid is computed in a single call
+    pie = np.asarray(pie, dtype=float)
+    xis, status = lib.correlation_pi_sigma_grid_vec(cosmo, a, beta, pie, sig,
+                                                    int(use_spline),
+                                                    len(pie) * len(sig),
+                                                    status)
     check(status, cosmo_in)
+    xis = xis.reshape((len(pie), len(sig)))
     if scalar:
-        return xis[0]
+        return xis[:, 0]
     return xis
 
 
-def correlation_spline_free():
+def correlation_wp(cosmo, a, beta, rp, pi_max):
     """
-    Clear the global splines created from if 'use_spline' was set to True.
+    Compute the projected correlation function
+    w_p(r_p) = 2 int_0^pi_max dpi xi(pi, r_p), where xi(pi, sigma) is
+    the 3DRsd correlation in pi-sigma space.
+
+    Args:
+        cosmo (:obj:`Cosmology`): A Cosmology object.
+        a (float): scale factor.
+        beta (float): growth rate divided by galaxy bias.
+        rp (float or array_like): transverse separation(s) (in Mpc).
+        pi_max (float): maximum line-of-sight separation (in Mpc).
+    Returns:
+        Value(s) of w_p at the input separation(s) (in Mpc).
+
+    """
+
+    cosmo_in = cosmo
+    cosmo = cosmo.cosmo
+    status = 0
+
+    # Convert scalar input into an array
+    scalar = False
+    if isinstance(rp, float) or isinstance(rp, int):
+        scalar = True
+        rp = np.array([rp, ])
+
+    # Call projected correlation function
+    _spline_cosmologies.add(cosmo_in)
+    wp, status = lib.correlation_wp_vec(cosmo, a, beta, pi_max, rp,
+                                        len(rp), status)
+    check(status, cosmo_in)
+    if scalar:
+        return wp[0]
+    return wp
+
+
+def correlation_spline_free(cosmo=None):
+    """
+    Clear the multipole splines stored in a Cosmology object when
+    'use_spline' is set to True. They are kept for a few values of the
+    scale factor, and are also freed together with the Cosmology object.
+
+    Args:
+        cosmo (:obj:`Cosmology`, optional): A Cosmology object. If None
+            (the default), the splines stored in all Cosmology objects are
+            freed, as in previous versions.
 
     """
-    lib.correlation_multipole_spline_free_vec()
+    if cosmo is None:
+        cosmos = list(_spline_cosmologies)
+    else:
+        cosmos = [cosmo, ]
+    for c in cosmos:
+        lib.correlation_multipole_spline_free_vec(c.cosmo)
+        _spline_cosmologies.discard(c)
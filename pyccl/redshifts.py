@@ -28,8 +28,15 @@ dNdz options
 
 import numpy as np
 from . import ccllib as lib
+from . import constants as const
 from .core import check
 
+pz_table_methods = {
+    'grid':       const.CCL_PZ_TABLE_GRID,
+    'shift_z':    const.CCL_PZ_TABLE_SHIFT_Z,
+    'shift_logz': const.CCL_PZ_TABLE_SHIFT_LOGZ,
+}
+
 """A user-defined photo-z function.
 This functions allows the user to create (or
 delete) a function that returns the likelihood of measuring
@@ -57,6 +64,38 @@ class PhotoZFunction(object):
         # Create user_pz_info object
         self.pz_func = lib.create_photoz_info_from_py(_func)
 
+    def tabulate(self, method='grid', x_range=None, n_x=1001,
+                 zt_max=const.Z_MAX_SOURCES, n_zt=201):
+        """Sample the photo-z pdf once on uniform grids. The probability of
+        a galaxy lying in a photo-z bin is then found from the table, instead
+        of integrating the pdf for every redshift and bin.
+
+        Args:
+            method (str): 'grid' samples the pdf on a (z_true, z_ph) grid.
+                'shift_z' and 'shift_logz' assume that it only depends on
+                z_ph - z or ln((1+z_ph)/(1+z)), and sample it once at z=0.
+            x_range (tuple, optional): Range of z_ph ('grid') or of the
+                offset ('shift_z', 'shift_logz') outside which the pdf
+                vanishes. Defaults to (-1, 7) for 'grid' and (-1, 1)
+                otherwise.
+            n_x (int): Number of z_ph or offset nodes.
+            zt_max (float): Maximum true redshift ('grid' only).
+            n_zt (int): Number of true redshift nodes ('grid' only).
+        """
+        if method not in pz_table_methods:
+            raise ValueError("'%s' is not a valid tabulation method. "
+                             "Available options are: %s"
+                             % (method, pz_table_methods.keys()))
+        if x_range is None:
+            x_range = (-1., 7.) if method == 'grid' else (-1., 1.)
+
+        status = 0
+        status = lib.photoz_info_tabulate(self.pz_func,
+                                          pz_table_methods[method],
+                                          int(n_zt), zt_max, int(n_x),
+                                          x_range[0], x_range[1], status)
+        check(status)
+
     def __del__(self):
         """Destructor for PhotoZFunction object."""
         try:
@@ -140,6 +179,75 @@ class dNdzSmail(dNdzFunction):
             pass
 
 
+class dNdzSampler(object):
+
+    def __init__(self, dNdz_func, pz_func=None, zmin=None, zmax=None,
+                 z_range=(const.Z_MIN_SOURCES, const.Z_MAX_SOURCES),
+                 n_z=2001):
+        """Create a sampler for a redshift distribution, used to draw
+        redshifts for mock catalogues by inverting its cumulative
+        distribution.
+
+        Args:
+            dNdz_func (dNdzFunction): True dNdz.
+            pz_func (PhotoZFunction, optional): Photo-z model. If given,
+                redshifts are drawn from the true dNdz of the photo-z bin
+                [zmin, zmax], as in dNdz_tomog.
+            zmin (float, optional): Minimum photo-z of the bin.
+            zmax (float, optional): Maximum photo-z of the bin.
+            z_range (tuple): Redshift range of the distribution.
+            n_z (int): Number of redshifts at which the distribution is
+                evaluated.
+        """
+        self.has_sampler = False
+        if not isinstance(dNdz_func, dNdzFunction):
+            raise TypeError("dNdz_func must be a dNdzFunction instance.")
+        if pz_func is None:
+            pz = None
+            zmin = zmax = 0.
+        else:
+            if not isinstance(pz_func, PhotoZFunction):
+                raise TypeError("pz_func must be a PhotoZFunction instance.")
+            if zmin is None or zmax is None:
+                raise ValueError("zmin and zmax must be given with pz_func.")
+            pz = pz_func.pz_func
+
+        status = 0
+        return_val = lib.dNdz_sampler_new(dNdz_func.dN_func, pz,
+                                          float(zmin), float(zmax),
+                                          int(n_z), float(z_range[0]),
+                                          float(z_range[1]), status)
+        if (isinstance(return_val, int)):
+            check(return_val)
+        else:
+            self.has_sampler = True
+            self.sampler, status = return_val
+
+    def sample(self, u):
+        """Draw redshifts from uniform deviates.
+
+        Args:
+            u (float or array_like): Uniform deviates in [0, 1].
+
+        Return:
+            z (array_like): Redshifts, one for each deviate.
+        """
+        u = np.atleast_1d(np.asarray(u, dtype=float))
+        status = 0
+        z, status = lib.dNdz_sampler_draw_vec(self.sampler, u, u.size,
+                                              status)
+        check(status)
+        return z
+
+    def __del__(self):
+        """Destructor for dNdzSampler object."""
+        try:
+            if self.has_sampler:
+                lib.dNdz_sampler_free(self.sampler)
+        except Exception:
+            pass
+
+
 def dNdz_tomog(z, zmin, zmax, pz_func, dNdz_func):
     """Calculates dNdz in a particular tomographic bin, convolved
     with a photo-z model (defined by the user), and normalized.
@@ -173,3 +281,43 @@ def dNdz_tomog(z, zmin, zmax, pz_func, dNdz_func):
                                       status)
     check(status)
     return dNdz
+
+
+def dNdz_tomog_multi(z, bin_edges, pz_func, dNdz_func):
+    """Calculates dNdz in several contiguous tomographic bins, convolved
+    with a photo-z model (defined by the user), and normalized. The
+    normalization of each bin is only computed once, and the photo-z
+    integral is done analytically for PhotoZGaussian.
+
+    Args:
+        z (float or array_like): Spectroscopic redshifts to evaluate dNdz at.
+        bin_edges (array_like): Photo-z bin edges. Bin i spans
+            [bin_edges[i], bin_edges[i+1]].
+        pz_func (callable): User-defined photo-z function.
+        dNdz_func (callable): User-defined true dNdz function.
+
+    Return:
+        dNdz (array_like): tomographic dNdz values, with shape
+            (len(bin_edges)-1, len(z)).
+
+    """
+    z = np.atleast_1d(z)
+    bin_edges = np.atleast_1d(bin_edges)
+    if bin_edges.size < 2:
+        raise ValueError("bin_edges must contain at least two values.")
+
+    # Do type-check for pz_func argument
+    if not isinstance(pz_func, PhotoZFunction):
+        raise TypeError("pz_func must be a PhotoZFunction instance.")
+
+    # Do type-check for dNdz_func argument
+    if not isinstance(dNdz_func, dNdzFunction):
+        raise TypeError("dNdz_func must be a dNdzFunction instance.")
+
+    n_bins = bin_edges.size - 1
+    status = 0
+    dNdz, status = lib.dNdz_tomog_multi_vec(bin_edges, pz_func.pz_func,
+                                            dNdz_func.dN_func, z,
+                                            n_bins * z.size, status)
+    check(status)
+    return dNdz.reshape([n_bins, z.size])
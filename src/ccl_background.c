@@ -945,6 +945,298 @@ void ccl_scale_factor_of_chis(ccl_cosmology * cosmo, int nchi, double chi[], dou
   }
 }
 
+/* ----- Direct-indexed distance table -----
+   Distances and their inverses are tabulated on uniform grids with their
+   derivatives, so that they can be evaluated by cubic Hermite interpolation
+   without searching or a GSL accelerator. Evaluation only reads the table, so
+   that it can be done in parallel.
+*/
+typedef struct {
+  int n; // number of nodes
+  double dy; // grid spacing (the first node is at 0)
+  double *f; // function values at the nodes
+  double *df; // derivatives at the nodes
+} dist_hermite;
+
+// Inverse tables are uniform in w=ln(1+y/DIST_TABLE_Y0), with y=chi or D_L,
+// so that they keep a constant relative accuracy at low redshift
+#define DIST_TABLE_Y0 1. // Mpc
+
+struct ccl_distance_table {
+  int k_sign; // curvature sign and sqrt(|k|), copied from the cosmology
+  double sqrtk;
+  dist_hermite chi_x; // chi(x), with x=ln(1+z)
+  dist_hermite x_chi; // x(w), with w=ln(1+chi/DIST_TABLE_Y0)
+  dist_hermite x_dl; // x(w), with w=ln(1+D_L/DIST_TABLE_Y0)
+};
+
+static void dist_hermite_free(dist_hermite *h)
+{
+  free(h->f);
+  free(h->df);
+}
+
+static int dist_hermite_alloc(dist_hermite *h, int n, double y_max)
+{
+  h->n = n;
+  h->dy = y_max/(n-1);
+  h->f = malloc(n*sizeof(double));
+  h->df = malloc(n*sizeof(double));
+  return (h->f==NULL) || (h->df==NULL);
+}
+
+// Hermite interpolation (and derivative) at y in [0,y_max]. Returns NAN outside.
+static inline double dist_hermite_eval(const dist_hermite *h, double y, double *dfdy)
+{
+  double u = y/h->dy;
+  int i;
+  if(!((u>=0) && (u<=h->n-1+1E-9)))
+    return NAN;
+  i = (int)u;
+  if(i>h->n-2) i = h->n-2;
+  double t = u-i, t2 = t*t, t3 = t2*t;
+  double f0 = h->f[i], f1 = h->f[i+1];
+  double d0 = h->dy*h->df[i], d1 = h->dy*h->df[i+1];
+  if(dfdy!=NULL)
+    *dfdy = ((6*t2-6*t)*(f0-f1)+(3*t2-4*t+1)*d0+(3*t2-2*t)*d1)/h->dy;
+  return (2*t3-3*t2+1)*f0+(t3-2*t2+t)*d0+(-2*t3+3*t2)*f1+(t3-t2)*d1;
+}
+
+static inline double dist_sinn(const struct ccl_distance_table *tab, double chi)
+{
+  if(tab->k_sign==-1)
+    return sinh(tab->sqrtk*chi)/tab->sqrtk;
+  else if(tab->k_sign==1)
+    return sin(tab->sqrtk*chi)/tab->sqrtk;
+  return chi;
+}
+
+static inline double dist_cosn(const struct ccl_distance_table *tab, double chi)
+{
+  if(tab->k_sign==-1)
+    return cosh(tab->sqrtk*chi);
+  else if(tab->k_sign==1)
+    return cos(tab->sqrtk*chi);
+  return 1;
+}
+
+// chi (if use_dl==0) or D_L (otherwise) at x=ln(1+z), and its derivative wrt x
+static inline double dist_forward(const struct ccl_distance_table *tab, int use_dl, double x, double *dfdx)
+{
+  double dchi;
+  double chi = dist_hermite_eval(&(tab->chi_x), x, &dchi);
+  if(!use_dl) {
+    *dfdx = dchi;
+    return chi;
+  }
+  double ex = exp(x);
+  double dl = ex*dist_sinn(tab, chi);
+  *dfdx = dl+ex*dist_cosn(tab, chi)*dchi;
+  return dl;
+}
+
+// Solve dist_forward(x)=y for x by safeguarded Newton iterations
+static inline double dist_invert(const struct ccl_distance_table *tab, int use_dl, double y, double x)
+{
+  double x_lo = 0, x_hi = (tab->chi_x.n-1)*tab->chi_x.dy;
+  int it;
+  if(!((x>x_lo) && (x<x_hi)))
+    x = 0.5*(x_lo+x_hi);
+  for(it=0; it<100; it++) {
+    double df, f = dist_forward(tab, use_dl, x, &df)-y;
+    double x_new;
+    if(f>0) x_hi = x;
+    else x_lo = x;
+    x_new = x-f/df;
+    if(!((x_new>x_lo) && (x_new<x_hi)))
+      x_new = 0.5*(x_lo+x_hi);
+    if(fabs(x_new-x)<1E-14*(1+x))
+      return x_new;
+    x = x_new;
+  }
+  return x;
+}
+
+/* ----- ROUTINE: ccl_cosmology_compute_distance_table ------
+INPUT: cosmology
+TASK: if not already there, tabulate chi(z), z(chi) and z(D_L) on uniform grids
+*/
+static void ccl_cosmology_compute_distance_table(ccl_cosmology *cosmo, int *status)
+{
+  int i;
+  double x_max, x_inv_max;
+  struct ccl_distance_table *tab;
+
+  if(cosmo->data.dist_table!=NULL)
+    return;
+
+  if(!cosmo->computed_distances) {
+    ccl_cosmology_compute_distances(cosmo, status);
+    if(*status)
+      return;
+  }
+
+  tab = malloc(sizeof(struct ccl_distance_table));
+  if(tab==NULL) {
+    *status = CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_background.c: ccl_cosmology_compute_distance_table(): ran out of memory\n");
+    return;
+  }
+  tab->k_sign = cosmo->params.k_sign;
+  tab->sqrtk = cosmo->params.sqrtk;
+  tab->chi_x.f = tab->chi_x.df = NULL;
+  tab->x_chi.f = tab->x_chi.df = NULL;
+  tab->x_dl.f = tab->x_dl.df = NULL;
+
+  // chi(x) from the chi(a) spline, with dchi/dx = c/(H0 a E(a))
+  x_max = -log(ccl_splines->A_SPLINE_MINLOG);
+  x_inv_max = log1p(CCL_DIST_TABLE_ZMAX_INV);
+  if(x_inv_max>x_max)
+    x_inv_max = x_max;
+  if(dist_hermite_alloc(&(tab->chi_x), CCL_DIST_TABLE_NX, x_max) ||
+     dist_hermite_alloc(&(tab->x_chi), CCL_DIST_TABLE_NX, 1.) ||
+     dist_hermite_alloc(&(tab->x_dl), CCL_DIST_TABLE_NX, 1.)) {
+    *status = CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_background.c: ccl_cosmology_compute_distance_table(): ran out of memory\n");
+  }
+  for(i=0; (i<CCL_DIST_TABLE_NX) && (!*status); i++) {
+    double a = exp(-i*tab->chi_x.dy);
+    if((i==CCL_DIST_TABLE_NX-1) || (a<ccl_splines->A_SPLINE_MINLOG))
+      a = ccl_splines->A_SPLINE_MINLOG;
+    tab->chi_x.f[i] = ccl_comoving_radial_distance(cosmo, a, status);
+    tab->chi_x.df[i] = CLIGHT_HMPC/(cosmo->params.h*a*ccl_h_over_h0(cosmo, a, status));
+  }
+
+  // Inverse tables up to z=CCL_DIST_TABLE_ZMAX_INV, with dx/dw = (y+DIST_TABLE_Y0)/(dy/dx)
+  for(i=0; (i<2) && (!*status); i++) {
+    int use_dl = i, j;
+    dist_hermite *h = use_dl ? &(tab->x_dl) : &(tab->x_chi);
+    double df, y_max = dist_forward(tab, use_dl, x_inv_max, &df);
+    double x = 0;
+    h->dy = log1p(y_max/DIST_TABLE_Y0)/(h->n-1);
+    for(j=0; j<h->n; j++) {
+      double y = DIST_TABLE_Y0*expm1(j*h->dy);
+      x = (j==0) ? 0 : dist_invert(tab, use_dl, y, x);
+      dist_forward(tab, use_dl, x, &df);
+      if(!(df>0)) {
+	*status = CCL_ERROR_INCONSISTENT;
+	ccl_cosmology_set_status_message(cosmo, "ccl_background.c: ccl_cosmology_compute_distance_table(): "
+					 "distance is not monotonic in redshift\n");
+	break;
+      }
+      h->f[j] = x;
+      h->df[j] = (y+DIST_TABLE_Y0)/df;
+    }
+  }
+
+  if(*status) {
+    dist_hermite_free(&(tab->chi_x));
+    dist_hermite_free(&(tab->x_chi));
+    dist_hermite_free(&(tab->x_dl));
+    free(tab);
+    return;
+  }
+  cosmo->data.dist_table = tab;
+}
+
+/* ----- ROUTINE: ccl_cosmology_distance_table_free ------
+INPUT: cosmology
+TASK: free the distance table, if any
+*/
+void ccl_cosmology_distance_table_free(ccl_cosmology *cosmo)
+{
+  struct ccl_distance_table *tab = cosmo->data.dist_table;
+  if(tab!=NULL) {
+    dist_hermite_free(&(tab->chi_x));
+    dist_hermite_free(&(tab->x_chi));
+    dist_hermite_free(&(tab->x_dl));
+    free(tab);
+    cosmo->data.dist_table = NULL;
+  }
+}
+
+// One conversion from the distance table. Returns NAN for inputs outside its range.
+static inline double dist_table_convert(const struct ccl_distance_table *tab, int dist_type, double in)
+{
+  double d, x, chi, dm;
+
+  if(dist_type==CCL_DIST_Z_OF_CHI || dist_type==CCL_DIST_Z_OF_DL) {
+    int use_dl = (dist_type==CCL_DIST_Z_OF_DL);
+    const dist_hermite *h = use_dl ? &(tab->x_dl) : &(tab->x_chi);
+    if(!(in>=0))
+      return NAN;
+    x = dist_hermite_eval(h, log1p(in/DIST_TABLE_Y0), NULL);
+    if(isnan(x)) { // Beyond the inverse table, invert the forward table
+      double y_max = dist_forward(tab, use_dl, (tab->chi_x.n-1)*tab->chi_x.dy, &d);
+      if(in>y_max)
+	return NAN;
+      x = dist_invert(tab, use_dl, in, h->f[h->n-1]);
+    }
+    return expm1(x);
+  }
+
+  if(!(in>=0))
+    return NAN;
+  x = log1p(in);
+  chi = dist_hermite_eval(&(tab->chi_x), x, NULL);
+  switch(dist_type) {
+  case CCL_DIST_CHI:
+    return chi;
+  case CCL_DIST_DM:
+    return dist_sinn(tab, chi);
+  case CCL_DIST_DA:
+    return dist_sinn(tab, chi)/(1+in);
+  case CCL_DIST_DL:
+    return dist_sinn(tab, chi)*(1+in);
+  case CCL_DIST_MU:
+    dm = dist_sinn(tab, chi);
+    if(!(dm>0))
+      return NAN;
+    return 5*log10(dm*(1+in))+25;
+  default:
+    return NAN;
+  }
+}
+
+/* ----- ROUTINE: ccl_convert_distances ------
+INPUT: cosmology, conversion type, n inputs
+TASK: convert redshifts into distances, or distances into redshifts, using the distance table
+*/
+void ccl_convert_distances(ccl_cosmology *cosmo, int dist_type, int n, double *input,
+			   double *output, int *status)
+{
+  int i, bad = 0;
+  const struct ccl_distance_table *tab;
+
+  if((dist_type<CCL_DIST_CHI) || (dist_type>CCL_DIST_Z_OF_DL)) {
+    *status = CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_background.c: ccl_convert_distances(): unknown conversion type %d\n",
+				     dist_type);
+    ccl_check_status(cosmo, status);
+    return;
+  }
+
+  ccl_cosmology_compute_distance_table(cosmo, status);
+  if(*status) {
+    ccl_check_status(cosmo, status);
+    return;
+  }
+  tab = cosmo->data.dist_table;
+
+#pragma omp parallel for simd default(none) shared(tab,dist_type,n,input,output) reduction(|:bad) schedule(static)
+  for(i=0; i<n; i++) {
+    output[i] = dist_table_convert(tab, dist_type, input[i]);
+    bad |= isnan(output[i]) ? 1 : 0;
+  }
+
+  if(bad) {
+    *status = CCL_ERROR_COMPUTECHI;
+    ccl_cosmology_set_status_message(cosmo, "ccl_background.c: ccl_convert_distances(): "
+				     "input outside the range of the distance table\n");
+    ccl_check_status(cosmo, status);
+  }
+}
+
 double ccl_growth_factor(ccl_cosmology * cosmo, double a, int * status)
 {
   if(a==1.){
@@ -963,7 +1255,9 @@ double ccl_growth_factor(ccl_cosmology * cosmo, double a, int * status)
     }
     if (*status!= CCL_ERROR_NOT_IMPLEMENTED) {
       double D;
-      int gslstatus = gsl_spline_eval_e(cosmo->data.growth, a, cosmo->data.accelerator,&D);
+      // The growth factor is evaluated without the shared accelerator so that
+      // the power spectrum extrapolation at high redshift is thread-safe.
+      int gslstatus = gsl_spline_eval_e(cosmo->data.growth, a, NULL,&D);
       if(gslstatus != GSL_SUCCESS) {
         ccl_raise_gsl_warning(gslstatus, "ccl_background.c: ccl_growth_factor():");
         *status |= gslstatus;
@@ -6,6 +6,14 @@
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_integration.h>
 
+#include <fftw3.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "fftlog.h"
+
 #include "ccl.h"
 
 #ifdef HAVE_ANGPOW
@@ -56,19 +64,328 @@ static double speval_bis(double x,void *params)
 }
 
 
+//Chi interval (in Mpc) used to tabulate the lensing and magnification kernels
+#define CCL_DCHI_KERNEL 5.
+//Maximum number of nodes of the background table used to update the kernels of a tracer
+//(see ccl_cl_tracer_set_photoz)
+#define CCL_CL_RADIAL_NMAX 20000
+//Gauss-Legendre points per panel and maximum relative panel width at low chi
+//used by the fixed-node Limber quadrature in chi
+#define CCL_LIMBER_NGL 4
+#define CCL_LIMBER_DLNCHI 0.1
+//Number of logarithmically-spaced comoving distances used by the non-Limber integrator.
+//The grid spans [1/K_MAX,1/K_MIN], so that its dual wavenumbers cover the power spectrum splines.
+#define CCL_NONLIMBER_NCHI 4096
+
+//Scratch space of the native non-Limber integrator (see angular_cls_nonlimber_nodes)
+struct cl_nonlimber_scratch_s {
+  int n_threads; //Number of threads for which per-thread buffers have been allocated
+  double *chi; //Log-spaced comoving distances
+  double *growth; //Growth factor at chi
+  double *pk; //Linear power spectrum today at the wavenumbers dual to chi
+  double complex *src; //Fourier transforms of the sources of two tracers (6*CCL_NONLIMBER_NCHI elements)
+  fftw_plan plan_f; //In-place forward FFT of one source
+  double complex *u; //Per-thread transform coefficients (3*CCL_NONLIMBER_NCHI elements each)
+  double complex *bk; //Per-thread transform buffers (CCL_NONLIMBER_NCHI elements each)
+  double *tk; //Per-thread transfer functions of two tracers (2*CCL_NONLIMBER_NCHI elements each)
+  fftw_plan *plan_b; //Per-thread in-place backward FFTs of bk
+};
+
+//Frees the fixed-node Limber quadrature stored in a workspace
+static void cl_workspace_free_quadrature(CCL_ClWorkspace *w)
+{
+  free(w->chi);
+  free(w->wchi);
+  free(w->chi_new);
+  free(w->wchi_new);
+  free(w->achi);
+  free(w->pw);
+  w->chi=NULL;
+  w->wchi=NULL;
+  w->chi_new=NULL;
+  w->wchi_new=NULL;
+  w->achi=NULL;
+  w->pw=NULL;
+  w->n_chi_alloc=0;
+  w->n_chi=0;
+  w->pw_cosmo=NULL;
+}
+
+//Frees the integration workspaces stored in a workspace
+static void cl_workspace_free_threads(CCL_ClWorkspace *w)
+{
+  int ii;
+
+  if(w->w_integ!=NULL) {
+    for(ii=0;ii<w->n_threads;ii++) {
+      if(w->w_integ[ii]!=NULL)
+	gsl_integration_workspace_free(w->w_integ[ii]);
+    }
+    free(w->w_integ);
+  }
+  w->w_integ=NULL;
+  w->n_threads=0;
+}
+
+static void cl_nonlimber_scratch_free(cl_nonlimber_scratch *s)
+{
+  int ii;
+
+  if(s==NULL)
+    return;
+
+  if(s->plan_b!=NULL) {
+    for(ii=0;ii<s->n_threads;ii++) {
+      if(s->plan_b[ii]!=NULL)
+	fftw_destroy_plan(s->plan_b[ii]);
+    }
+    free(s->plan_b);
+  }
+  if(s->plan_f!=NULL)
+    fftw_destroy_plan(s->plan_f);
+  free(s->chi);
+  free(s->growth);
+  free(s->pk);
+  fftw_free(s->src);
+  fftw_free(s->u);
+  fftw_free(s->bk);
+  free(s->tk);
+  free(s);
+}
+
 void ccl_cl_workspace_free(CCL_ClWorkspace *w)
 {
+  if(w==NULL)
+    return;
+
+  cl_workspace_free_quadrature(w);
+  cl_workspace_free_threads(w);
+  cl_nonlimber_scratch_free(w->nl_scratch);
+  if(w->tgl!=NULL)
+    gsl_integration_glfixed_table_free(w->tgl);
+  if(w->spl_nodes!=NULL)
+    ccl_spline_free(w->spl_nodes);
+  free(w->l_nodes);
+  free(w->cl_nodes);
+  free(w->ref_i);
+  free(w->ref_l);
+  free(w->ref_conv);
+  free(w->ref_bad);
+  free(w->ref_cl);
+  free(w->scratch);
   free(w->l_arr);
   free(w);
 }
 
+//Makes sure that a workspace has one integration workspace for each of the
+//threads that may be used in a parallel region.
+static void cl_workspace_alloc_threads(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int *status)
+{
+  int ii,n_threads=1;
+#ifdef _OPENMP
+  n_threads=omp_get_max_threads();
+#endif //_OPENMP
+
+  if(w->n_threads>=n_threads)
+    return;
+
+  cl_workspace_free_threads(w);
+  w->w_integ=(gsl_integration_workspace **)malloc(n_threads*sizeof(gsl_integration_workspace *));
+  if(w->w_integ==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_threads(); memory allocation\n");
+    return;
+  }
+  w->n_threads=n_threads;
+  for(ii=0;ii<n_threads;ii++) {
+    w->w_integ[ii]=gsl_integration_workspace_alloc(ccl_gsl->N_ITERATION);
+    if(w->w_integ[ii]==NULL)
+      *status=CCL_ERROR_MEMORY;
+  }
+  if(*status) {
+    cl_workspace_free_threads(w);
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_threads(); memory allocation\n");
+  }
+}
+
+//Makes sure that a workspace can hold a fixed-node Limber quadrature with n_chi nodes.
+//The stored quadrature is kept if no reallocation is needed.
+static void cl_workspace_alloc_quadrature(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int n_chi,int *status)
+{
+  if(w->tgl==NULL) {
+    w->tgl=gsl_integration_glfixed_table_alloc(CCL_LIMBER_NGL);
+    if(w->tgl==NULL) {
+      *status=CCL_ERROR_MEMORY;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_quadrature(); memory allocation\n");
+      return;
+    }
+  }
+
+  if(w->n_chi_alloc>=n_chi)
+    return;
+
+  cl_workspace_free_quadrature(w);
+  w->chi=(double *)malloc(n_chi*sizeof(double));
+  w->wchi=(double *)malloc(n_chi*sizeof(double));
+  w->chi_new=(double *)malloc(n_chi*sizeof(double));
+  w->wchi_new=(double *)malloc(n_chi*sizeof(double));
+  w->achi=(double *)malloc(n_chi*sizeof(double));
+  w->pw=(double *)malloc(w->n_ls*n_chi*sizeof(double));
+  if((w->chi==NULL) || (w->wchi==NULL) || (w->chi_new==NULL) || (w->wchi_new==NULL) ||
+     (w->achi==NULL) || (w->pw==NULL)) {
+    cl_workspace_free_quadrature(w);
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_quadrature(); memory allocation\n");
+    return;
+  }
+  w->n_chi_alloc=n_chi;
+}
+
+//Makes sure that a workspace has n elements of scratch space for each of the
+//threads that may be used in a parallel region.
+static void cl_workspace_alloc_scratch(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int n,int *status)
+{
+  int n_threads=1;
+#ifdef _OPENMP
+  n_threads=omp_get_max_threads();
+#endif //_OPENMP
+
+  if((w->n_scratch_threads>=n_threads) && (w->n_scratch>=n))
+    return;
+
+  free(w->scratch);
+  w->n_scratch=CCL_MAX(n,w->n_scratch);
+  w->n_scratch_threads=CCL_MAX(n_threads,w->n_scratch_threads);
+  w->scratch=(double *)malloc(w->n_scratch_threads*w->n_scratch*sizeof(double));
+  if(w->scratch==NULL) {
+    w->n_scratch=0;
+    w->n_scratch_threads=0;
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_scratch(); memory allocation\n");
+  }
+}
+
+//Makes sure that a workspace can hold n_spectra power spectra at its nodes.
+//The power spectra stored in it are not kept if more space is needed.
+static void cl_workspace_alloc_spectra(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int n_spectra,int *status)
+{
+  double *cl_nodes,*ref_cl;
+
+  if(w->n_spectra_alloc>=n_spectra)
+    return;
+
+  cl_nodes=(double *)malloc(n_spectra*w->n_ls*sizeof(double));
+  ref_cl=(double *)malloc(n_spectra*w->n_ls*sizeof(double));
+  if((cl_nodes==NULL) || (ref_cl==NULL)) {
+    free(cl_nodes);
+    free(ref_cl);
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_spectra(); memory allocation\n");
+    return;
+  }
+  free(w->cl_nodes);
+  free(w->ref_cl);
+  w->cl_nodes=cl_nodes;
+  w->ref_cl=ref_cl;
+  w->n_spectra_alloc=n_spectra;
+}
+
+//Makes sure that a workspace has scratch space for the native non-Limber integrator for all
+//the threads that may be used in a parallel region. The FFTW plans are created here, outside
+//any parallel region, since FFTW planning is not thread-safe.
+static void cl_workspace_alloc_nonlimber(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int *status)
+{
+  int ii,n_chi=CCL_NONLIMBER_NCHI,n_threads=1,ok=0;
+  cl_nonlimber_scratch *s;
+#ifdef _OPENMP
+  n_threads=omp_get_max_threads();
+#endif //_OPENMP
+
+  if((w->nl_scratch!=NULL) && (w->nl_scratch->n_threads>=n_threads))
+    return;
+
+  cl_nonlimber_scratch_free(w->nl_scratch);
+  w->nl_scratch=NULL;
+
+  s=(cl_nonlimber_scratch *)malloc(sizeof(cl_nonlimber_scratch));
+  if(s!=NULL) {
+    s->n_threads=n_threads;
+    s->chi=(double *)malloc(n_chi*sizeof(double));
+    s->growth=(double *)malloc(n_chi*sizeof(double));
+    s->pk=(double *)malloc(n_chi*sizeof(double));
+    s->src=(double complex *)fftw_malloc(6*n_chi*sizeof(double complex));
+    s->u=(double complex *)fftw_malloc(3*n_threads*n_chi*sizeof(double complex));
+    s->bk=(double complex *)fftw_malloc(n_threads*n_chi*sizeof(double complex));
+    s->tk=(double *)malloc(2*n_threads*n_chi*sizeof(double));
+    s->plan_f=NULL;
+    s->plan_b=(fftw_plan *)malloc(n_threads*sizeof(fftw_plan));
+    if(s->plan_b!=NULL) {
+      for(ii=0;ii<n_threads;ii++)
+	s->plan_b[ii]=NULL;
+    }
+
+    if((s->chi!=NULL) && (s->growth!=NULL) && (s->pk!=NULL) && (s->src!=NULL) &&
+       (s->u!=NULL) && (s->bk!=NULL) && (s->tk!=NULL) && (s->plan_b!=NULL)) {
+      //All the sources have the same alignment, so they can share the same plan
+      s->plan_f=fftw_plan_dft_1d(n_chi,(fftw_complex *)(s->src),(fftw_complex *)(s->src),
+				 FFTW_FORWARD,FFTW_ESTIMATE);
+      ok=(s->plan_f!=NULL);
+      for(ii=0;ii<n_threads;ii++) {
+	double complex *bk=&(s->bk[ii*n_chi]);
+	s->plan_b[ii]=fftw_plan_dft_1d(n_chi,(fftw_complex *)bk,(fftw_complex *)bk,
+				       FFTW_BACKWARD,FFTW_ESTIMATE);
+	if(s->plan_b[ii]==NULL)
+	  ok=0;
+      }
+    }
+  }
+
+  if(!ok) {
+    cl_nonlimber_scratch_free(s);
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_alloc_nonlimber(); memory allocation\n");
+    return;
+  }
+  w->nl_scratch=s;
+}
+
 CCL_ClWorkspace *ccl_cl_workspace_new(int lmax,int l_limber,
 				      double l_logstep,int l_linstep,int *status)
 {
   int i_l,l0,increment;
   CCL_ClWorkspace *w=(CCL_ClWorkspace *)malloc(sizeof(CCL_ClWorkspace));
-  if(w==NULL)
+  if(w==NULL) {
     *status=CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  //Scratch space
+  w->l_arr=NULL;
+  w->l_nodes=NULL;
+  w->n_spectra_alloc=1;
+  w->cl_nodes=NULL;
+  w->spl_nodes=NULL;
+  w->ref_i=NULL;
+  w->ref_l=NULL;
+  w->ref_conv=NULL;
+  w->ref_bad=NULL;
+  w->ref_cl=NULL;
+  w->n_scratch_threads=0;
+  w->n_scratch=0;
+  w->scratch=NULL;
+  w->nl_scratch=NULL;
+  w->n_threads=0;
+  w->w_integ=NULL;
+  w->tgl=NULL;
+  w->n_chi_alloc=0;
+  w->n_chi=0;
+  w->chi=NULL;
+  w->wchi=NULL;
+  w->chi_new=NULL;
+  w->wchi_new=NULL;
+  w->achi=NULL;
+  w->pw=NULL;
+  w->pw_cosmo=NULL;
 
   if(*status==0) {
     //Set params
@@ -76,6 +393,9 @@ CCL_ClWorkspace *ccl_cl_workspace_new(int lmax,int l_limber,
     w->l_limber=l_limber;
     w->l_logstep=l_logstep;
     w->l_linstep=l_linstep;
+    w->limber_method=ccl_limber_qag_logk;
+    w->nonlimber_method=ccl_nonlimber_angpow;
+    w->l_tol=0;
 
     //Compute number of multipoles
     i_l=0; l0=0;
@@ -117,7 +437,50 @@ CCL_ClWorkspace *ccl_cl_workspace_new(int lmax,int l_limber,
     //Don't go further than lmaw
     w->l_arr[w->n_ls-1]=w->lmax;
   }
-  
+
+  if(*status==0) {
+    //Arrays used to interpolate the power spectrum at the nodes and to refine them
+    w->l_nodes=(double *)malloc(w->n_ls*sizeof(double));
+    w->cl_nodes=(double *)malloc(w->n_ls*sizeof(double));
+    w->ref_i=(int *)malloc(w->n_ls*sizeof(int));
+    w->ref_l=(int *)malloc(w->n_ls*sizeof(int));
+    w->ref_conv=(char *)malloc(w->n_ls*sizeof(char));
+    w->ref_bad=(char *)malloc(w->n_ls*sizeof(char));
+    w->ref_cl=(double *)malloc(w->n_ls*sizeof(double));
+    w->spl_nodes=(SplPar *)malloc(sizeof(SplPar));
+    if(w->spl_nodes!=NULL) {
+      w->spl_nodes->intacc=NULL;
+      w->spl_nodes->spline=NULL;
+    }
+    if((w->l_nodes==NULL) || (w->cl_nodes==NULL) || (w->ref_i==NULL) || (w->ref_l==NULL) ||
+       (w->ref_conv==NULL) || (w->ref_bad==NULL) || (w->ref_cl==NULL) || (w->spl_nodes==NULL))
+      *status=CCL_ERROR_MEMORY;
+    else {
+      w->spl_nodes->spline=gsl_spline_alloc(gsl_interp_cspline,w->n_ls);
+      if(w->spl_nodes->spline==NULL) {
+	free(w->spl_nodes);
+	w->spl_nodes=NULL;
+	*status=CCL_ERROR_MEMORY;
+      }
+    }
+  }
+
+  if(*status==0) {
+    for(i_l=0;i_l<w->n_ls;i_l++) {
+      w->l_nodes[i_l]=(double)(w->l_arr[i_l]);
+      w->cl_nodes[i_l]=0;
+    }
+    w->spl_nodes->x0=w->l_nodes[0];
+    w->spl_nodes->xf=w->l_nodes[w->n_ls-1];
+    w->spl_nodes->y0=0;
+    w->spl_nodes->yf=0;
+  }
+
+  if(*status) {
+    ccl_cl_workspace_free(w);
+    w=NULL;
+  }
+
   return w;
 }
 
@@ -126,136 +489,188 @@ CCL_ClWorkspace *ccl_cl_workspace_new_limber(int lmax,double l_logstep,int l_lin
   return ccl_cl_workspace_new(lmax,-1,l_logstep,l_linstep,status);
 }
 
-//Params for lensing kernel integrand
+//Generalized cosine associated with ccl_sinn:
+//         { cos(x)  , if k==1
+// cosn(x)={  1      , if k==0
+//         { cosh(x) , if k==-1
+static double cosn(ccl_cosmology *cosmo,double chi)
+{
+  switch(cosmo->params.k_sign) {
+  case -1:
+    return cosh(cosmo->params.sqrtk*chi);
+  case 1:
+    return cos(cosmo->params.sqrtk*chi);
+  default:
+    return 1.;
+  }
+}
+
+//Background quantities needed by the radial kernels of a tracer at a given comoving distance
 typedef struct {
-  double chi;
-  SplPar *spl_pz;
-  ccl_cosmology *cosmo;
-  int *status;
-} IntLensPar;
+  double a; //Scale factor
+  double z; //Redshift
+  double h; //H(z)/c in 1/Mpc
+  double growth; //Growth factor (only if requested)
+  double fgrowth; //Growth rate (only if requested)
+  double cosn; //Generalized cosine
+  double sinn; //Comoving angular distance
+} ClBackground;
+
+//Computes the background quantities at chi. If tab is not NULL, they are read from
+//it instead, and chi must be one of its nodes.
+//need_growth -> if nonzero, the growth factor and rate are also computed
+static void cl_background(ccl_cosmology *cosmo,CCL_ClRadialTable *tab,double chi,int need_growth,
+			  ClBackground *bg,int *status)
+{
+  if(tab!=NULL) {
+    int j=(int)(chi/tab->dchi+0.5);
+    bg->a=tab->a[j];
+    bg->h=tab->h[j];
+    bg->cosn=tab->cosn[j];
+    bg->sinn=tab->sinn[j];
+    if(need_growth) {
+      bg->growth=tab->growth[j];
+      bg->fgrowth=tab->fgrowth[j];
+    }
+  }
+  else {
+    bg->a=ccl_scale_factor_of_chi(cosmo,chi,status);
+    bg->h=cosmo->params.h*ccl_h_over_h0(cosmo,bg->a,status)/CLIGHT_HMPC;
+    bg->cosn=cosn(cosmo,chi);
+    bg->sinn=ccl_sinn(cosmo,chi,status);
+    if(need_growth) {
+      bg->growth=ccl_growth_factor(cosmo,bg->a,status);
+      bg->fgrowth=ccl_growth_rate(cosmo,bg->a,status);
+    }
+  }
+  bg->z=1./bg->a-1;
+}
 
-//Integrand for lensing kernel
-static double integrand_wl(double chip,void *params)
+//Integrands of the cumulative integrals used to compute lensing-like kernels
+//chi     -> comoving distance
+//tab     -> tabulated background (may be NULL, see cl_background)
+//spl_pz  -> normalized N(z) spline
+//spl_sz  -> magnification bias s(z) (NULL for shear)
+//g0      -> dN/dchi * q(chi) is stored here, with q(chi)=1-5/2*s(chi) for magnification, 1 otherwise
+//g1      -> g0 * cosn(chi)/f(chi) is stored here
+static void window_integrands(double chi,ccl_cosmology *cosmo,CCL_ClRadialTable *tab,
+			      SplPar *spl_pz,SplPar *spl_sz,double *g0,double *g1,int *status)
 {
-  IntLensPar *p=(IntLensPar *)params;
-  double chi=p->chi;
-  double a=ccl_scale_factor_of_chi(p->cosmo,chip, p->status);
-  double z=1./a-1;
-  double pz=ccl_spline_eval(z,p->spl_pz);
-  double h=p->cosmo->params.h*ccl_h_over_h0(p->cosmo,a, p->status)/CLIGHT_HMPC;
+  ClBackground bg;
+  cl_background(cosmo,tab,chi,0,&bg,status);
+
+  *g0=bg.h*ccl_spline_eval(bg.z,spl_pz);
+  if(spl_sz!=NULL)
+    *g0*=(1-2.5*ccl_spline_eval(bg.z,spl_sz));
 
-  if(chi==0)
-    return h*pz;
+  //The second integrand is only used with a vanishing prefactor f(chi)=0 at chi=0
+  if(chi<=0)
+    *g1=0;
   else
-    return h*pz*ccl_sinn(p->cosmo,chip-chi,p->status)/ccl_sinn(p->cosmo,chip,p->status);
+    *g1=(*g0)*bg.cosn/bg.sinn;
 }
 
-//Integral to compute lensing window function
-//chi     -> comoving distance
-//cosmo   -> ccl_cosmology object
+//Computes a lensing-like window function on a grid of comoving distances in a single pass:
+//   w(chi) = Integral[ dN/dchi(chi') * q(chi') * f(chi'-chi)/f(chi') , chi < chi' < chi_max ]
+//Where f(chi) is the comoving angular distance (which is just chi for zero curvature)
+//and q(chi) is 1-5/2*s(chi) for magnification and 1 otherwise.
+//Since f(chi'-chi)/f(chi') = cosn(chi) - f(chi)*cosn(chi')/f(chi'), this can be written as
+//   w(chi) = cosn(chi) * S0(chi) - f(chi) * S1(chi)
+//where S0 and S1 are integrals of g0 and g1 (see window_integrands) from chi to chi_max.
+//These are accumulated from chi_max downwards using Simpson's rule on each grid interval.
+//nchi    -> number of grid points
+//x       -> grid of comoving distances, in ascending order, with x[nchi-1]=chi_max
+//tab     -> tabulated background (may be NULL). If not NULL, x and the midpoints
+//           between its elements must be nodes of tab.
 //spl_pz  -> normalized N(z) spline
-//chi_max -> maximum comoving distance to which the integral is computed
-//win     -> result is stored here
-static int window_lensing(double chi,ccl_cosmology *cosmo,SplPar *spl_pz,double chi_max,double *win)
+//spl_sz  -> magnification bias s(z) (NULL for shear)
+//y       -> result is stored here
+static void window_cumulative(ccl_cosmology *cosmo,CCL_ClRadialTable *tab,SplPar *spl_pz,SplPar *spl_sz,
+			      int nchi,double *x,double *y,int *status)
 {
-  int gslstatus =0, status =0;
-  double result,eresult;
-  IntLensPar ip;
-  gsl_function F;
-  gsl_integration_workspace *w=gsl_integration_workspace_alloc(ccl_gsl->N_ITERATION);
-
-  ip.chi=chi;
-  ip.cosmo=cosmo;
-  ip.spl_pz=spl_pz;
-  ip.status = &status;
-  F.function=&integrand_wl;
-  F.params=&ip;
-  // This conputes the lensing kernel:
-  //   w_L(chi) = Integral[ dN/dchi(chi') * f(chi'-chi)/f(chi') , chi < chi' < chi_horizon ]
-  // Where f(chi) is the comoving angular distance (which is just chi for zero curvature).
-  gslstatus=gsl_integration_qag(&F, chi, chi_max, 0,
-                                ccl_gsl->INTEGRATION_EPSREL, ccl_gsl->N_ITERATION,
-                                ccl_gsl->INTEGRATION_GAUSS_KRONROD_POINTS,
-                                w, &result, &eresult);
-  *win=result;
-  gsl_integration_workspace_free(w);
-  if(gslstatus!=GSL_SUCCESS || *ip.status) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_cls.c: window_lensing():");
-    return 1;
+  int j;
+  double s0=0,s1=0;
+  double g0_hi,g1_hi,g0_mid,g1_mid,g0_lo,g1_lo;
+
+  window_integrands(x[nchi-1],cosmo,tab,spl_pz,spl_sz,&g0_hi,&g1_hi,status);
+  y[nchi-1]=0;
+  for(j=nchi-2;j>=0;j--) {
+    double dx=x[j+1]-x[j];
+    window_integrands(0.5*(x[j]+x[j+1]),cosmo,tab,spl_pz,spl_sz,&g0_mid,&g1_mid,status);
+    window_integrands(x[j],cosmo,tab,spl_pz,spl_sz,&g0_lo,&g1_lo,status);
+    s0+=dx*(g0_lo+4*g0_mid+g0_hi)/6.;
+    s1+=dx*(g1_lo+4*g1_mid+g1_hi)/6.;
+    if(x[j]<=0)
+      y[j]=s0;
+    else if(tab!=NULL) {
+      int jt=(int)(x[j]/tab->dchi+0.5);
+      y[j]=tab->cosn[jt]*s0-tab->sinn[jt]*s1;
+    }
+    else
+      y[j]=cosn(cosmo,x[j])*s0-ccl_sinn(cosmo,x[j],status)*s1;
+    g0_hi=g0_lo;
+    g1_hi=g1_lo;
   }
-  //TODO: chi_max should be changed to chi_horizon
-  //we should precompute this quantity and store it in cosmo by default
-
-  return 0;
 }
 
-//Params for lensing kernel integrand
-typedef struct {
-  double chi;
-  SplPar *spl_pz;
-  SplPar *spl_sz;
-  ccl_cosmology *cosmo;
-  int *status;
-} IntMagPar;
-
-//Integrand for magnification kernel
-static double integrand_mag(double chip,void *params)
+//Computes a lensing-like window function (see window_cumulative) and returns its spline in chi.
+//The window is sampled every CCL_DCHI_KERNEL from chi=0 to the end of the N(z), or on every
+//other node of tab if it isn't NULL.
+//spl_sz -> magnification bias s(z) for magnification, NULL for shear
+static SplPar *clt_window_spline(CCL_ClTracer *clt,ccl_cosmology *cosmo,CCL_ClRadialTable *tab,
+				 SplPar *spl_sz,int *status)
 {
-  IntMagPar *p=(IntMagPar *)params;
-  double chi=p->chi;
-  double a=ccl_scale_factor_of_chi(p->cosmo,chip, p->status);
-  double z=1./a-1;
-  double pz=ccl_spline_eval(z,p->spl_pz);
-  double sz=ccl_spline_eval(z,p->spl_sz);
-  double h=p->cosmo->params.h*ccl_h_over_h0(p->cosmo,a, p->status)/CLIGHT_HMPC;
+  int nchi;
+  double *x=NULL,*y=NULL;
+  SplPar *spl=NULL;
+  double zmax=clt->spl_nz->xf;
+  double chimax=ccl_comoving_radial_distance(cosmo,1./(1+zmax),status);
 
-  if(chi==0)
-    return h*pz*(1-2.5*sz);
-  else
-    return h*pz*(1-2.5*sz)*ccl_sinn(p->cosmo,chip-chi,p->status)/ccl_sinn(p->cosmo,chip,p->status);
-}
+  if(tab!=NULL) {
+    int j;
+    nchi=(int)(ceil(0.5*chimax/tab->dchi))+1;
+    x=(double *)malloc(nchi*sizeof(double));
+    if(x!=NULL) {
+      for(j=0;j<nchi;j++)
+	x[j]=2*j*tab->dchi;
+    }
+  }
+  else {
+    nchi=(int)(chimax/CCL_DCHI_KERNEL)+1;
+    x=ccl_linear_spacing(0.,chimax,nchi);
+    if(x==NULL || (fabs(x[0]-0)>1E-5) || (fabs(x[nchi-1]-chimax)>1e-5)) {
+      *status=CCL_ERROR_LINSPACE;
+      ccl_cosmology_set_status_message(cosmo,
+				       "ccl_cls.c: clt_window_spline(): Error creating linear spacing in chi\n");
+    }
+  }
 
-//Integral to compute magnification window function
-//chi     -> comoving distance
-//cosmo   -> ccl_cosmology object
-//spl_pz  -> normalized N(z) spline
-//spl_pz  -> magnification bias s(z)
-//chi_max -> maximum comoving distance to which the integral is computed
-//win     -> result is stored here
-static int window_magnification(double chi,ccl_cosmology *cosmo,SplPar *spl_pz,SplPar *spl_sz,
-				double chi_max,double *win)
-{
-  int gslstatus =0, status =0;
-  double result,eresult;
-  IntMagPar ip;
-  gsl_function F;
-  gsl_integration_workspace *w=gsl_integration_workspace_alloc(ccl_gsl->N_ITERATION);
-
-  ip.chi=chi;
-  ip.cosmo=cosmo;
-  ip.spl_pz=spl_pz;
-  ip.spl_sz=spl_sz;
-  ip.status = &status;
-  F.function=&integrand_mag;
-  F.params=&ip;
-  // This conputes the magnification lensing kernel:
-  //   w_M(chi) = Integral[ dN/dchi(chi') * (1-5/2 * s(chi)) * f(chi'-chi)/f(chi') , chi < chi' < chi_horizon ]
-  // Where f(chi) is the comoving angular distance (which is just chi for zero curvature)
-  // and s(chi) is the magnification bias parameter.
-  gslstatus=gsl_integration_qag(&F, chi, chi_max, 0,
-                                ccl_gsl->INTEGRATION_EPSREL, ccl_gsl->N_ITERATION,
-                                ccl_gsl->INTEGRATION_GAUSS_KRONROD_POINTS,
-                                w, &result, &eresult);
-  *win=result;
-  gsl_integration_workspace_free(w);
-  if(gslstatus!=GSL_SUCCESS || *ip.status) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_cls.c: window_magnification():");
-    return 1;
+  if(*status==0) {
+    y=(double *)malloc(nchi*sizeof(double));
+    if((x==NULL) || (y==NULL)) {
+      *status=CCL_ERROR_MEMORY;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_window_spline(): memory allocation\n");
+    }
   }
-  //TODO: chi_max should be changed to chi_horizon
-  //we should precompute this quantity and store it in cosmo by default
 
-  return 0;
+  if(*status==0) {
+    window_cumulative(cosmo,tab,clt->spl_nz,spl_sz,nchi,x,y,status);
+    if(*status) {
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_window_spline(): error computing lensing window\n");
+    }
+  }
+
+  if(*status==0) {
+    spl=ccl_spline_init(nchi,x,y,y[0],0);
+    if(spl==NULL) {
+      *status=CCL_ERROR_SPLINE;
+      ccl_cosmology_set_status_message(cosmo,
+				       "ccl_cls.c: clt_window_spline(): error initializing spline for lensing window\n");
+    }
+  }
+  free(x); free(y);
+
+  return spl;
 }
 
 static void clt_init_nz(CCL_ClTracer *clt,ccl_cosmology *cosmo,
@@ -331,14 +746,6 @@ static void clt_init_bz(CCL_ClTracer *clt,ccl_cosmology *cosmo,
 static void clt_init_wM(CCL_ClTracer *clt,ccl_cosmology *cosmo,
 			int nz_s,double *z_s,double *s,int *status)
 {
-  //Compute magnification kernel
-  int nchi;
-  double *x,*y;
-  double dchi_here=5.;
-  double zmax=clt->spl_nz->xf;
-  double chimax=ccl_comoving_radial_distance(cosmo,1./(1+zmax),status);
-  //TODO: The interval in chi (5. Mpc) should be made a macro
-
   //In this case we need to integrate all the way to z=0. Reset zmin and chimin
   clt->zmin=0;
   clt->chimin=0;
@@ -349,44 +756,9 @@ static void clt_init_wM(CCL_ClTracer *clt,ccl_cosmology *cosmo,
 				     "ccl_cls.c: clt_init_wM(): error initializing spline for s(z)\n");
   }
 
-  if(*status==0) {
-    nchi=(int)(chimax/dchi_here)+1;
-    x=ccl_linear_spacing(0.,chimax,nchi);
-    dchi_here=chimax/nchi;
-    if(x==NULL || (fabs(x[0]-0)>1E-5) || (fabs(x[nchi-1]-chimax)>1e-5)) {
-      *status=CCL_ERROR_LINSPACE;
-      ccl_cosmology_set_status_message(cosmo,
-				       "ccl_cls.c: clt_init_wM(): Error creating linear spacing in chi\n");
-    }
-  }
-
-  if(*status==0) {
-    y=(double *)malloc(nchi*sizeof(double));
-    if(y==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_wM(): memory allocation\n");
-    }
-  }
-
-  if(*status==0) {
-    int clstatus=0;
-    for(int j=0;j<nchi;j++)
-      clstatus|=window_magnification(x[j],cosmo,clt->spl_nz,clt->spl_sz,chimax,&(y[j]));
-    if(clstatus) {
-      *status=CCL_ERROR_INTEG;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_wM(): error computing lensing window\n");
-    }
-  }
-
-  if(*status==0) {
-    clt->spl_wM=ccl_spline_init(nchi,x,y,y[0],0);
-    if(clt->spl_wM==NULL) {
-      *status=CCL_ERROR_SPLINE;
-      ccl_cosmology_set_status_message(cosmo,
-				       "ccl_cls.c: clt_init_wM(): error initializing spline for lensing window\n");
-    }
-  }
-  free(x); free(y);
+  //Compute magnification kernel
+  if(*status==0)
+    clt->spl_wM=clt_window_spline(clt,cosmo,NULL,clt->spl_sz,status);
 }
 
 //CCL_ClTracer initializer for number counts
@@ -414,53 +786,12 @@ static void clt_nc_init(CCL_ClTracer *clt,ccl_cosmology *cosmo,
 static void clt_init_wL(CCL_ClTracer *clt,ccl_cosmology *cosmo,
 			int *status)
 {
-  //Compute weak lensing kernel
-  int nchi;
-  double *x,*y;
-  double dchi_here=5.;
-  double zmax=clt->spl_nz->xf;
-  double chimax=ccl_comoving_radial_distance(cosmo,1./(1+zmax),status);
-  //TODO: The interval in chi (5. Mpc) should be made a macro
-  
   //In this case we need to integrate all the way to z=0. Reset zmin and chimin
   clt->zmin=0;
   clt->chimin=0;
-  nchi=(int)(chimax/dchi_here)+1;
-  x=ccl_linear_spacing(0.,chimax,nchi);
-  dchi_here=chimax/nchi;
-  if(x==NULL || (fabs(x[0]-0)>1E-5) || (fabs(x[nchi-1]-chimax)>1e-5)) {
-    *status=CCL_ERROR_LINSPACE;
-    ccl_cosmology_set_status_message(cosmo,
-				     "ccl_cls.c: clt_init_wL(): Error creating linear spacing in chi\n");
-  }
-  
-  if(*status==0) {
-    y=(double *)malloc(nchi*sizeof(double));
-    if(y==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_wL(): memory allocation\n");
-    }
-  }
 
-  if(*status==0) {
-    int clstatus=0;
-    for(int j=0;j<nchi;j++)
-      clstatus|=window_lensing(x[j],cosmo,clt->spl_nz,chimax,&(y[j]));
-    if(clstatus) {
-      *status=CCL_ERROR_INTEG;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_wL(): error computing lensing window\n");
-    }
-  }
-  
-  if(*status==0) {
-    clt->spl_wL=ccl_spline_init(nchi,x,y,y[0],0);
-    if(clt->spl_wL==NULL) {
-      *status=CCL_ERROR_SPLINE;
-      ccl_cosmology_set_status_message(cosmo,
-				     "ccl_cls.c: clt_init_wL(): error initializing spline for lensing window\n");
-    }
-  }
-  free(x); free(y);
+  //Compute weak lensing kernel
+  clt->spl_wL=clt_window_spline(clt,cosmo,NULL,NULL,status);
 }
 
 static void clt_init_rf(CCL_ClTracer *clt,ccl_cosmology *cosmo,
@@ -501,42 +832,197 @@ static void clt_wl_init(CCL_ClTracer *clt,ccl_cosmology *cosmo,
   }
 }
 
-//CCL_ClTracer creator
-//cosmo   -> ccl_cosmology object
-//tracer_type -> type of tracer. Supported: ccl_number_counts_tracer, ccl_weak_lensing_tracer
-//nz_n -> number of points for N(z)
-//z_n  -> array of z-values for N(z)
-//n    -> corresponding N(z)-values. Normalization is irrelevant
-//        N(z) will be set to zero outside the range covered by z_n
-//nz_b -> number of points for b(z)
-//z_b  -> array of z-values for b(z)
-//b    -> corresponding b(z)-values.
-//        b(z) will be assumed constant outside the range covered by z_n
-static CCL_ClTracer *cl_tracer(ccl_cosmology *cosmo,int tracer_type,
-			       int has_rsd,int has_magnification,int has_intrinsic_alignment,
-			       int nz_n,double *z_n,double *n,
-			       int nz_b,double *z_b,double *b,
-			       int nz_s,double *z_s,double *s,
-			       int nz_ba,double *z_ba,double *ba,
-			       int nz_rf,double *z_rf,double *rf,
-			       double z_source, int * status)
+//Initializes a spline, reusing the one in *spl if it has the same number of nodes.
+//Returns nonzero on failure.
+static int cl_spline_update(SplPar **spl,int n,double *x,double *y,double y0,double yf)
 {
-  int clstatus=0;
-  CCL_ClTracer *clt=(CCL_ClTracer *)malloc(sizeof(CCL_ClTracer));
-  if(clt==NULL) {
-    *status=CCL_ERROR_MEMORY;
-    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer(): memory allocation\n");
+  if((*spl!=NULL) && ((int)((*spl)->spline->size)==n)) {
+    if(gsl_spline_init((*spl)->spline,x,y,n))
+      return 1;
+    (*spl)->x0=x[0];
+    (*spl)->xf=x[n-1];
+    (*spl)->y0=y0;
+    (*spl)->yf=yf;
+    return 0;
   }
 
-  if(*status==0) {
-    clt->tracer_type=tracer_type;
-    
-    double hub=cosmo->params.h*ccl_h_over_h0(cosmo,1.,status)/CLIGHT_HMPC;
-    clt->prefac_lensing=1.5*hub*hub*cosmo->params.Omega_m;
+  if(*spl!=NULL)
+    ccl_spline_free(*spl);
+  *spl=ccl_spline_init(n,x,y,y0,yf);
+  return (*spl==NULL);
+}
 
-    if(tracer_type==ccl_number_counts_tracer)
-      clt_nc_init(clt,cosmo,has_rsd,has_magnification,
-		  nz_n,z_n,n,nz_b,z_b,b,nz_s,z_s,s,status);
+//Tabulates the radial kernels entering the Limber integrand (see transfer_limber).
+//All of them are functions of chi only, so that the ell- and k-dependence of the
+//transfer functions is reduced to simple prefactors:
+// - spl_kd : dN/dchi * b(z) (number counts)
+// - spl_kr : dN/dchi * f(z) * D(z) (number counts with RSD), together with spl_kg=D(z)
+// - spl_kl : chi^2 times the lensing-like terms, which in the Limber approximation
+//            are divided by k^2=(l+1/2)^2/chi^2:
+//            * number counts: 3*O_M*H_0^2/2 * chi * w_M(chi)/a
+//            * weak lensing : 3*O_M*H_0^2/2 * chi * w_L(chi)/a + dN/dchi * b_a(z) * f_red(z)
+//            * CMB lensing  : 3*O_M*H_0^2/2 * chi * (1-chi/chi_s)/a
+//If tab is not NULL, the kernels are sampled at its nodes, and the background is read from it.
+//Existing kernel splines with the same number of nodes are updated in place.
+static void clt_init_kernels(CCL_ClTracer *clt,ccl_cosmology *cosmo,CCL_ClRadialTable *tab,int *status)
+{
+  int ichi,nchi,has_kd=0,has_kr=0,has_kl=0;
+  double chi_lo=0,chi_hi=clt->chimax;
+  double *x=NULL,*yd=NULL,*yr=NULL,*yg=NULL,*yl=NULL;
+
+  if(clt->tracer_type==ccl_number_counts_tracer) {
+    has_kd=1;
+    has_kr=clt->has_rsd;
+    has_kl=clt->has_magnification;
+    //Without lensing-like terms the kernel starts where the N(z) does
+    if((!clt->has_magnification) && (!clt->has_rsd) && (clt->spl_nz->x0>0))
+      chi_lo=ccl_comoving_radial_distance(cosmo,1./(1+clt->spl_nz->x0),status);
+  }
+  else
+    has_kl=1;
+
+  //Sample at least twice per input N(z) interval so that its features are resolved
+  nchi=(int)((chi_hi-chi_lo)/CCL_DCHI_KERNEL)+1;
+  if(clt->tracer_type!=ccl_cmb_lensing_tracer)
+    nchi=CCL_MAX(nchi,2*((int)(clt->spl_nz->spline->size)));
+  nchi=CCL_MAX(nchi,3);
+
+  if((*status==0) && (tab!=NULL)) {
+    //Nodes of the table covering [chi_lo,chi_hi]
+    int j_lo=(int)(chi_lo/tab->dchi);
+    int j_hi=CCL_MIN((int)(ceil(chi_hi/tab->dchi)),tab->n-1);
+    j_lo=CCL_MAX(CCL_MIN(j_lo,j_hi-2),0);
+    nchi=j_hi-j_lo+1;
+    x=(double *)malloc(nchi*sizeof(double));
+    if(x!=NULL) {
+      for(ichi=0;ichi<nchi;ichi++)
+	x[ichi]=(j_lo+ichi)*tab->dchi;
+    }
+  }
+  else if(*status==0)
+    x=ccl_linear_spacing(chi_lo,chi_hi,nchi);
+
+  if(*status==0) {
+    yd=(double *)malloc(nchi*sizeof(double));
+    yr=(double *)malloc(nchi*sizeof(double));
+    yg=(double *)malloc(nchi*sizeof(double));
+    yl=(double *)malloc(nchi*sizeof(double));
+    if(x==NULL || yd==NULL || yr==NULL || yg==NULL || yl==NULL) {
+      *status=CCL_ERROR_MEMORY;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_kernels(): memory allocation\n");
+    }
+  }
+
+  if(*status==0) {
+    for(ichi=0;ichi<nchi;ichi++) {
+      double chi=x[ichi];
+      ClBackground bg;
+      cl_background(cosmo,tab,chi,has_kr,&bg,status);
+      double a=bg.a,z=bg.z,h=bg.h;
+
+      yd[ichi]=0; yr[ichi]=0; yg[ichi]=0; yl[ichi]=0;
+      if(clt->tracer_type==ccl_number_counts_tracer) {
+	double pz=ccl_spline_eval(z,clt->spl_nz);
+	yd[ichi]=pz*ccl_spline_eval(z,clt->spl_bz)*h;
+	if(has_kr) {
+	  yg[ichi]=bg.growth;
+	  yr[ichi]=pz*bg.fgrowth*yg[ichi]*h;
+	}
+	if(clt->has_magnification) {
+	  double wM=ccl_spline_eval(chi,clt->spl_wM);
+	  if(wM>0)
+	    yl[ichi]=clt->prefac_lensing*chi*wM/a;
+	}
+      }
+      else if(clt->tracer_type==ccl_weak_lensing_tracer) {
+	double wL=ccl_spline_eval(chi,clt->spl_wL);
+	if(wL>0)
+	  yl[ichi]=clt->prefac_lensing*chi*wL/a;
+	if(clt->has_intrinsic_alignment) {
+	  yl[ichi]+=ccl_spline_eval(z,clt->spl_nz)*ccl_spline_eval(z,clt->spl_ba)*
+	    ccl_spline_eval(z,clt->spl_rf)*h;
+	}
+      }
+      else if(chi<clt->chi_source) //CMB lensing
+	yl[ichi]=clt->prefac_lensing*chi*(1-chi/clt->chi_source)/a;
+    }
+    if(*status) {
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_kernels(): error computing radial kernels\n");
+    }
+  }
+
+  if(*status==0) {
+    int splstatus=0;
+    if(has_kd)
+      splstatus|=cl_spline_update(&(clt->spl_kd),nchi,x,yd,0,0);
+    if(has_kr) {
+      splstatus|=cl_spline_update(&(clt->spl_kr),nchi,x,yr,yr[0],0);
+      splstatus|=cl_spline_update(&(clt->spl_kg),nchi,x,yg,yg[0],yg[nchi-1]);
+    }
+    if(has_kl)
+      splstatus|=cl_spline_update(&(clt->spl_kl),nchi,x,yl,yl[0],0);
+    if(splstatus) {
+      *status=CCL_ERROR_SPLINE;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_init_kernels(): error initializing spline for radial kernels\n");
+    }
+  }
+
+  free(x); free(yd); free(yr); free(yg); free(yl);
+}
+
+//Number of tracers created so far, used to give each of them a unique identifier
+static unsigned long cl_tracer_count=0;
+
+//CCL_ClTracer creator
+//cosmo   -> ccl_cosmology object
+//tracer_type -> type of tracer. Supported: ccl_number_counts_tracer, ccl_weak_lensing_tracer
+//nz_n -> number of points for N(z)
+//z_n  -> array of z-values for N(z)
+//n    -> corresponding N(z)-values. Normalization is irrelevant
+//        N(z) will be set to zero outside the range covered by z_n
+//nz_b -> number of points for b(z)
+//z_b  -> array of z-values for b(z)
+//b    -> corresponding b(z)-values.
+//        b(z) will be assumed constant outside the range covered by z_n
+static CCL_ClTracer *cl_tracer(ccl_cosmology *cosmo,int tracer_type,
+			       int has_rsd,int has_magnification,int has_intrinsic_alignment,
+			       int nz_n,double *z_n,double *n,
+			       int nz_b,double *z_b,double *b,
+			       int nz_s,double *z_s,double *s,
+			       int nz_ba,double *z_ba,double *ba,
+			       int nz_rf,double *z_rf,double *rf,
+			       double z_source, int * status)
+{
+  int clstatus=0;
+  CCL_ClTracer *clt=(CCL_ClTracer *)malloc(sizeof(CCL_ClTracer));
+  if(clt==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer(): memory allocation\n");
+  }
+
+  if(*status==0) {
+#pragma omp atomic capture
+    clt->id=++cl_tracer_count;
+    clt->tracer_type=tracer_type;
+    clt->pz_shift=0;
+    clt->pz_stretch=1;
+    clt->pz_zmean=0;
+    clt->spl_nz0=NULL;
+    clt->pz_tab=NULL;
+    clt->spl_kd=NULL;
+    clt->spl_kr=NULL;
+    clt->spl_kg=NULL;
+    clt->spl_kl=NULL;
+    clt->has_rsd=0;
+    clt->has_magnification=0;
+    clt->has_intrinsic_alignment=0;
+    
+    double hub=cosmo->params.h*ccl_h_over_h0(cosmo,1.,status)/CLIGHT_HMPC;
+    clt->prefac_lensing=1.5*hub*hub*cosmo->params.Omega_m;
+
+    if(tracer_type==ccl_number_counts_tracer)
+      clt_nc_init(clt,cosmo,has_rsd,has_magnification,
+		  nz_n,z_n,n,nz_b,z_b,b,nz_s,z_s,s,status);
     else if(tracer_type==ccl_weak_lensing_tracer)
       clt_wl_init(clt,cosmo,has_intrinsic_alignment,
 		  nz_n,z_n,n,nz_ba,z_ba,ba,nz_rf,z_rf,rf,status);
@@ -553,6 +1039,15 @@ static CCL_ClTracer *cl_tracer(ccl_cosmology *cosmo,int tracer_type,
     }
   }
 
+  if(*status==0) {
+    clt_init_kernels(clt,cosmo,NULL,status);
+    //All the other splines exist at this point, so the tracer can be freed as a whole
+    if(*status) {
+      ccl_cl_tracer_free(clt);
+      clt=NULL;
+    }
+  }
+
   if(*status) {
     free(clt);
     clt=NULL;
@@ -588,26 +1083,313 @@ CCL_ClTracer *ccl_cl_tracer(ccl_cosmology *cosmo,int tracer_type,
   return clt;
 }
 
+//CCL_ClRadialTable destructor
+static void cl_radial_table_free(CCL_ClRadialTable *tab)
+{
+  if(tab!=NULL) {
+    free(tab->a);
+    free(tab->h);
+    free(tab->growth);
+    free(tab->fgrowth);
+    free(tab->cosn);
+    free(tab->sinn);
+    free(tab);
+  }
+}
+
+//Computes the background at the nodes of a table starting at node j0
+static void cl_radial_table_fill(ccl_cosmology *cosmo,CCL_ClRadialTable *tab,int j0,int *status)
+{
+  int j;
+  int need_growth=(tab->growth!=NULL);
+
+  for(j=j0;j<tab->n;j++) {
+    ClBackground bg;
+    cl_background(cosmo,NULL,j*tab->dchi,need_growth,&bg,status);
+    tab->a[j]=bg.a;
+    tab->h[j]=bg.h;
+    tab->cosn[j]=bg.cosn;
+    tab->sinn[j]=bg.sinn;
+    if(need_growth) {
+      tab->growth[j]=bg.growth;
+      tab->fgrowth[j]=bg.fgrowth;
+    }
+  }
+}
+
+//Resizes one of the columns of a table. The input array is kept if this fails.
+static int cl_radial_table_realloc(double **arr,int n)
+{
+  double *arr_new;
+
+  if(*arr==NULL)
+    return 0;
+  arr_new=(double *)realloc(*arr,n*sizeof(double));
+  if(arr_new==NULL)
+    return 1;
+  *arr=arr_new;
+  return 0;
+}
+
+//Tabulates the background every dchi from chi=0 to at least chi_max.
+//If this would take more than CCL_CL_RADIAL_NMAX nodes, dchi is increased.
+static CCL_ClRadialTable *cl_radial_table_new(ccl_cosmology *cosmo,double dchi,double chi_max,
+					      int need_growth,int *status)
+{
+  CCL_ClRadialTable *tab=(CCL_ClRadialTable *)malloc(sizeof(CCL_ClRadialTable));
+  if(tab==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_radial_table_new(): memory allocation\n");
+    return NULL;
+  }
+
+  if(chi_max>(CCL_CL_RADIAL_NMAX-1)*dchi)
+    dchi=chi_max/(CCL_CL_RADIAL_NMAX-1);
+  tab->n=(int)(ceil(chi_max/dchi))+1;
+  tab->dchi=dchi;
+  tab->a=(double *)malloc(tab->n*sizeof(double));
+  tab->h=(double *)malloc(tab->n*sizeof(double));
+  tab->cosn=(double *)malloc(tab->n*sizeof(double));
+  tab->sinn=(double *)malloc(tab->n*sizeof(double));
+  tab->growth=NULL;
+  tab->fgrowth=NULL;
+  if(need_growth) {
+    tab->growth=(double *)malloc(tab->n*sizeof(double));
+    tab->fgrowth=(double *)malloc(tab->n*sizeof(double));
+  }
+  if((tab->a==NULL) || (tab->h==NULL) || (tab->cosn==NULL) || (tab->sinn==NULL) ||
+     (need_growth && ((tab->growth==NULL) || (tab->fgrowth==NULL)))) {
+    cl_radial_table_free(tab);
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_radial_table_new(): memory allocation\n");
+    return NULL;
+  }
+
+  cl_radial_table_fill(cosmo,tab,0,status);
+  if(*status) {
+    cl_radial_table_free(tab);
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_radial_table_new(): error computing background\n");
+    return NULL;
+  }
+
+  return tab;
+}
+
+//Extends a table to at least chi_max keeping its spacing. Only the new nodes are computed.
+//Returns 0 without modifying the table if this would take more than CCL_CL_RADIAL_NMAX nodes,
+//1 otherwise.
+static int cl_radial_table_extend(ccl_cosmology *cosmo,CCL_ClRadialTable *tab,double chi_max,int *status)
+{
+  int n_old=tab->n;
+  int n_new=(int)(ceil(chi_max/tab->dchi))+1;
+
+  if(n_new<=n_old)
+    return 1;
+  if(n_new>CCL_CL_RADIAL_NMAX)
+    return 0;
+
+  if(cl_radial_table_realloc(&(tab->a),n_new) || cl_radial_table_realloc(&(tab->h),n_new) ||
+     cl_radial_table_realloc(&(tab->cosn),n_new) || cl_radial_table_realloc(&(tab->sinn),n_new) ||
+     cl_radial_table_realloc(&(tab->growth),n_new) || cl_radial_table_realloc(&(tab->fgrowth),n_new)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_radial_table_extend(): memory allocation\n");
+    return 1;
+  }
+
+  tab->n=n_new;
+  cl_radial_table_fill(cosmo,tab,n_old,status);
+  if(*status) {
+    tab->n=n_old;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_radial_table_extend(): error computing background\n");
+  }
+  return 1;
+}
+
+void ccl_cl_tracer_set_photoz(ccl_cosmology *cosmo,CCL_ClTracer *clt,double dz,double stretch,int *status)
+{
+  int ii,i0,n0,n_new;
+  double chi_need;
+  double *z_new=NULL,*nz_new=NULL;
+  gsl_spline *spl0;
+  SplPar *spl_nz=NULL;
+
+  if(((clt->tracer_type!=ccl_number_counts_tracer) && (clt->tracer_type!=ccl_weak_lensing_tracer)) ||
+     (stretch<=0)) {
+    *status=CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer_set_photoz(): photo-z parameters "
+				     "only apply to number counts and weak lensing tracers, and need stretch>0\n");
+    return;
+  }
+
+  //Keep the input N(z), together with its mean redshift
+  if(clt->spl_nz0==NULL) {
+    double zn=0,nn=0;
+    spl0=clt->spl_nz->spline;
+    for(ii=0;ii<(int)(spl0->size)-1;ii++) {
+      double dx=spl0->x[ii+1]-spl0->x[ii];
+      zn+=0.5*dx*(spl0->x[ii]*spl0->y[ii]+spl0->x[ii+1]*spl0->y[ii+1]);
+      nn+=0.5*dx*(spl0->y[ii]+spl0->y[ii+1]);
+    }
+    clt->pz_zmean=zn/nn;
+    clt->spl_nz0=clt->spl_nz;
+  }
+  spl0=clt->spl_nz0->spline;
+  n0=(int)(spl0->size);
+
+  //Shifted and stretched N(z) on the nodes of the input one:
+  //   N(z) = N_0(zmean+(z-zmean-dz)/stretch)/stretch
+  //Nodes that end up at z<0 are dropped.
+  for(i0=0;i0<n0;i0++) {
+    if(clt->pz_zmean+dz+stretch*(spl0->x[i0]-clt->pz_zmean)>=0)
+      break;
+  }
+  n_new=n0-i0;
+  if(n_new<3) {
+    *status=CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer_set_photoz(): "
+				     "shifted N(z) is at negative redshift\n");
+    return;
+  }
+
+  z_new=(double *)malloc(n_new*sizeof(double));
+  nz_new=(double *)malloc(n_new*sizeof(double));
+  if((z_new==NULL) || (nz_new==NULL)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer_set_photoz(): memory allocation\n");
+  }
+
+  if(*status==0) {
+    for(ii=0;ii<n_new;ii++) {
+      z_new[ii]=clt->pz_zmean+dz+stretch*(spl0->x[i0+ii]-clt->pz_zmean);
+      nz_new[ii]=spl0->y[i0+ii]/stretch;
+    }
+    spl_nz=ccl_spline_init(n_new,z_new,nz_new,0,0);
+    if(spl_nz==NULL) {
+      *status=CCL_ERROR_SPLINE;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer_set_photoz(): "
+				       "error initializing spline for N(z)\n");
+    }
+  }
+
+  if((*status==0) && (i0>0)) {
+    //Renormalize if part of the N(z) was dropped
+    double norm=gsl_spline_eval_integ(spl_nz->spline,z_new[0],z_new[n_new-1],NULL);
+    for(ii=0;ii<n_new;ii++)
+      nz_new[ii]/=norm;
+    ccl_spline_free(spl_nz);
+    spl_nz=ccl_spline_init(n_new,z_new,nz_new,0,0);
+    if(spl_nz==NULL) {
+      *status=CCL_ERROR_SPLINE;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_tracer_set_photoz(): "
+				       "error initializing spline for N(z)\n");
+    }
+  }
+
+  if(*status==0) {
+    if(clt->spl_nz!=clt->spl_nz0)
+      ccl_spline_free(clt->spl_nz);
+    clt->spl_nz=spl_nz;
+
+    //Redshift range where the new N(z) has support
+    get_support_interval(n_new,z_new,nz_new,CCL_FRAC_RELEVANT,&(clt->zmin),&(clt->zmax));
+    clt->chimax=ccl_comoving_radial_distance(cosmo,1./(1+clt->zmax),status);
+    clt->chimin=ccl_comoving_radial_distance(cosmo,1./(1+clt->zmin),status);
+    if((clt->tracer_type==ccl_weak_lensing_tracer) || clt->has_magnification) {
+      clt->zmin=0;
+      clt->chimin=0;
+    }
+
+    //Background on a grid covering the new N(z). It is built with some margin, so that
+    //it can be reused for other shifts, and extended when they need more nodes.
+    chi_need=ccl_comoving_radial_distance(cosmo,1./(1+z_new[n_new-1]),status)+CCL_DCHI_KERNEL;
+    if((*status==0) && (clt->pz_tab==NULL)) {
+      //Sample at least twice per input N(z) interval, as in clt_init_kernels
+      double chi_lo=ccl_comoving_radial_distance(cosmo,1./(1+spl0->x[0]),status);
+      double chi_hi=ccl_comoving_radial_distance(cosmo,1./(1+spl0->x[n0-1]),status);
+      double dchi=fmin(0.5*CCL_DCHI_KERNEL,(chi_hi-chi_lo)/(2*n0));
+      if(*status==0)
+	clt->pz_tab=cl_radial_table_new(cosmo,dchi,1.2*chi_need,clt->has_rsd,status);
+    }
+    else if((*status==0) && ((clt->pz_tab->n-1)*clt->pz_tab->dchi<chi_need)) {
+      //Start again with a coarser grid if the current one can't be extended
+      if(!cl_radial_table_extend(cosmo,clt->pz_tab,1.2*chi_need,status)) {
+	double dchi=clt->pz_tab->dchi;
+	cl_radial_table_free(clt->pz_tab);
+	clt->pz_tab=cl_radial_table_new(cosmo,dchi,1.2*chi_need,clt->has_rsd,status);
+      }
+    }
+  }
+
+  //Lensing-like windows
+  if(*status==0) {
+    if(clt->tracer_type==ccl_weak_lensing_tracer) {
+      ccl_spline_free(clt->spl_wL);
+      clt->spl_wL=clt_window_spline(clt,cosmo,clt->pz_tab,NULL,status);
+    }
+    else if(clt->has_magnification) {
+      ccl_spline_free(clt->spl_wM);
+      clt->spl_wM=clt_window_spline(clt,cosmo,clt->pz_tab,clt->spl_sz,status);
+    }
+  }
+
+  //Radial kernels. Their splines are updated in place.
+  if(*status==0)
+    clt_init_kernels(clt,cosmo,clt->pz_tab,status);
+
+  if(*status==0) {
+    clt->pz_shift=dz;
+    clt->pz_stretch=stretch;
+    //This is effectively a new tracer
+#pragma omp atomic capture
+    clt->id=++cl_tracer_count;
+  }
+  else if(spl_nz!=clt->spl_nz)
+    ccl_spline_free(spl_nz);
+
+  free(z_new);
+  free(nz_new);
+  ccl_check_status(cosmo,status);
+}
+
 //CCL_ClTracer destructor
 void ccl_cl_tracer_free(CCL_ClTracer *clt)
 {
-  if((clt->tracer_type==ccl_number_counts_tracer) || (clt->tracer_type==ccl_weak_lensing_tracer))
+  if(clt==NULL)
+    return;
+
+  if((clt->tracer_type==ccl_number_counts_tracer) || (clt->tracer_type==ccl_weak_lensing_tracer)) {
     ccl_spline_free(clt->spl_nz);
+    if((clt->spl_nz0!=NULL) && (clt->spl_nz0!=clt->spl_nz))
+      ccl_spline_free(clt->spl_nz0);
+  }
+  cl_radial_table_free(clt->pz_tab);
 
   if(clt->tracer_type==ccl_number_counts_tracer) {
     ccl_spline_free(clt->spl_bz);
     if(clt->has_magnification) {
       ccl_spline_free(clt->spl_sz);
-      ccl_spline_free(clt->spl_wM);
+      //May be NULL if ccl_cl_tracer_set_photoz failed
+      if(clt->spl_wM!=NULL)
+	ccl_spline_free(clt->spl_wM);
     }
   }
   else if(clt->tracer_type==ccl_weak_lensing_tracer) {
-    ccl_spline_free(clt->spl_wL);
+    if(clt->spl_wL!=NULL)
+      ccl_spline_free(clt->spl_wL);
     if(clt->has_intrinsic_alignment) {
       ccl_spline_free(clt->spl_ba);
       ccl_spline_free(clt->spl_rf);
     }
   }
+
+  if(clt->spl_kd!=NULL)
+    ccl_spline_free(clt->spl_kd);
+  if(clt->spl_kr!=NULL)
+    ccl_spline_free(clt->spl_kr);
+  if(clt->spl_kg!=NULL)
+    ccl_spline_free(clt->spl_kg);
+  if(clt->spl_kl!=NULL)
+    ccl_spline_free(clt->spl_kl);
   free(clt);
 }
 
@@ -658,182 +1440,104 @@ CCL_ClTracer *ccl_cl_tracer_lensing_simple(ccl_cosmology *cosmo,
 			   -1,NULL,NULL,-1,NULL,NULL,0, status);
 }
 
-static double f_dens(double a,ccl_cosmology *cosmo,CCL_ClTracer *clt, int * status)
-{
-  double z=1./a-1;
-  double pz=ccl_spline_eval(z,clt->spl_nz);
-  double bz=ccl_spline_eval(z,clt->spl_bz);
-  double h=cosmo->params.h*ccl_h_over_h0(cosmo,a,status)/CLIGHT_HMPC;
-
-  return pz*bz*h;
-}
-
-static double f_rsd(double a,ccl_cosmology *cosmo,CCL_ClTracer *clt, int * status)
-{
-  double z=1./a-1;
-  double pz=ccl_spline_eval(z,clt->spl_nz);
-  double fg=ccl_growth_rate(cosmo,a,status);
-  double h=cosmo->params.h*ccl_h_over_h0(cosmo,a,status)/CLIGHT_HMPC;
-
-  return pz*fg*h;
-}
-
-static double f_mag(double a,double chi,ccl_cosmology *cosmo,CCL_ClTracer *clt, int * status)
+//ell-dependent prefactor of the lensing-like kernel of a tracer
+//l -> angular multipole
+//clt -> CCL_ClTracer object
+static double clt_ell_prefactor(int l,CCL_ClTracer *clt)
 {
-  double wM=ccl_spline_eval(chi,clt->spl_wM);
-
-  if(wM<=0)
-    return 0;
-  else
-    return wM/(a*chi);
+  if(clt->tracer_type==ccl_number_counts_tracer) //Magnification
+    return -2*l*(l+1.);
+  else if(clt->tracer_type==ccl_weak_lensing_tracer) //Shear
+    return sqrt((l+2.)*(l+1.)*l*(l-1.));
+  else //CMB lensing convergence
+    return l*(l+1.);
 }
 
-//Transfer function for number counts
+//Limber transfer function, built from the kernels tabulated in clt_init_kernels
 //l -> angular multipole
 //k -> wavenumber modulus
-//cosmo -> ccl_cosmology object
-//w -> CCL_ClWorskpace object
-//clt -> CCL_ClTracer object (must be of the ccl_number_counts_tracer type)
-static double transfer_nc(int l,double k,
-			  ccl_cosmology *cosmo,CCL_ClWorkspace *w,CCL_ClTracer *clt, int * status)
+//clt -> CCL_ClTracer object
+static double transfer_limber(int l,double k,CCL_ClTracer *clt)
 {
   double ret=0;
   double x0=(l+0.5);
   double chi0=x0/k;
-  if(chi0<=clt->chimax) {
-    double a0=ccl_scale_factor_of_chi(cosmo,chi0,status);
-    double f_all=f_dens(a0,cosmo,clt,status);
-    if(clt->has_rsd) {
-      double x1=(l+1.5);
-      double chi1=x1/k;
-      if(chi1<=clt->chimax) {
-	double a1=ccl_scale_factor_of_chi(cosmo,chi1,status);
-	double pk0=ccl_nonlin_matter_power(cosmo,k,a0,status);
-	double pk1=ccl_nonlin_matter_power(cosmo,k,a1,status);
-	double fg0=f_rsd(a0,cosmo,clt,status);
-	double fg1=f_rsd(a1,cosmo,clt,status);
-	f_all+=fg0*(1.-l*(l-1.)/(x0*x0))-fg1*2.*sqrt((l+0.5)*pk1/((l+1.5)*pk0))/x1;
-      }
-    }
-    if(clt->has_magnification)
-      f_all+=-2*clt->prefac_lensing*l*(l+1)*f_mag(a0,chi0,cosmo,clt,status)/(k*k);
-    ret=f_all;
-  }
-
-  return ret;
-}
-
-static double f_lensing(double a,double chi,ccl_cosmology *cosmo,CCL_ClTracer *clt, int * status)
-{
-  double wL=ccl_spline_eval(chi,clt->spl_wL);
-
-  if(wL<=0)
-    return 0;
-  else
-    return clt->prefac_lensing*wL/(a*chi);
-}
 
-static double f_IA_NLA(double a,double chi,ccl_cosmology *cosmo,CCL_ClTracer *clt, int * status)
-{
-  if(chi<=1E-10)
+  if(chi0>clt->chimax)
     return 0;
-  else {
-    double a=ccl_scale_factor_of_chi(cosmo,chi, status);
-    double z=1./a-1;
-    double pz=ccl_spline_eval(z,clt->spl_nz);
-    double ba=ccl_spline_eval(z,clt->spl_ba);
-    double rf=ccl_spline_eval(z,clt->spl_rf);
-    double h=cosmo->params.h*ccl_h_over_h0(cosmo,a,status)/CLIGHT_HMPC;
 
-    return pz*ba*rf*h/(chi*chi);
-  }
-}
+  if(clt->spl_kd!=NULL)
+    ret+=ccl_spline_eval(chi0,clt->spl_kd);
 
-//Transfer function for shear
-//l -> angular multipole
-//k -> wavenumber modulus
-//cosmo -> ccl_cosmology object
-//w -> CCL_ClWorskpace object
-//clt -> CCL_ClTracer object (must be of the ccl_weak_lensing_tracer type)
-static double transfer_wl(int l,double k,
-			  ccl_cosmology *cosmo,CCL_ClWorkspace *w,CCL_ClTracer *clt, int * status)
-{
-  double ret=0;
-  double chi=(l+0.5)/k;
-  if(chi<=clt->chimax) {
-    double a=ccl_scale_factor_of_chi(cosmo,chi,status);
-    double f_all=f_lensing(a,chi,cosmo,clt,status);
-    if(clt->has_intrinsic_alignment)
-      f_all+=f_IA_NLA(a,chi,cosmo,clt,status);
-    
-    ret=f_all;
+  if(clt->spl_kr!=NULL) {
+    //The ratio of power spectra at chi1 and chi0 is given by the growth factor
+    double x1=(l+1.5);
+    double chi1=x1/k;
+    double fg0=ccl_spline_eval(chi0,clt->spl_kr);
+    double fg1=ccl_spline_eval(chi1,clt->spl_kr);
+    ret+=(fg0*(1.-l*(l-1.)/(x0*x0))-fg1*2.*sqrt(x0/x1)/x1)/ccl_spline_eval(chi0,clt->spl_kg);
   }
 
-  return sqrt((l+2.)*(l+1.)*l*(l-1.))*ret/(k*k);
-  //return (l+1.)*l*ret/(k*k);
-}
-
-static double transfer_cmblens(int l,double k,ccl_cosmology *cosmo,CCL_ClTracer *clt,int *status)
-{
-  double chi=(l+0.5)/k;
-  if(chi>=clt->chi_source)
-    return 0;
+  if(clt->spl_kl!=NULL)
+    ret+=clt_ell_prefactor(l,clt)*ccl_spline_eval(chi0,clt->spl_kl)/(x0*x0);
 
-  if(chi<=clt->chimax) {
-    double a=ccl_scale_factor_of_chi(cosmo,chi,status);
-    double w=1-chi/clt->chi_source;
-    return clt->prefac_lensing*l*(l+1.)*w/(a*chi*k*k);
-  }
-  return 0;
+  return ret;
 }
 
 //Wrapper for transfer function
 //l -> angular multipole
-//k -> wavenumber modulus
-//cosmo -> ccl_cosmology object
+//lk -> log10 of the wavenumber modulus
 //clt -> CCL_ClTracer object
-static double transfer_wrap(int il,double lk,ccl_cosmology *cosmo,
-			    CCL_ClWorkspace *w,CCL_ClTracer *clt, int * status)
+static double transfer_wrap(int l,double lk,CCL_ClTracer *clt)
 {
-  double transfer_out=0;
-  double k=pow(10.,lk);
-
-  if(clt->tracer_type==ccl_number_counts_tracer)
-    transfer_out=transfer_nc(w->l_arr[il],k,cosmo,w,clt,status);
-  else if(clt->tracer_type==ccl_weak_lensing_tracer)
-    transfer_out=transfer_wl(w->l_arr[il],k,cosmo,w,clt,status);
-  else if(clt->tracer_type==ccl_cmb_lensing_tracer)
-    transfer_out=transfer_cmblens(w->l_arr[il],k,cosmo,clt,status);
-  else
-    transfer_out=-1;
-  return transfer_out;
+  return transfer_limber(l,pow(10.,lk),clt);
 }
 
 //Params for power spectrum integrand
 typedef struct {
-  int il;
+  int l;
   ccl_cosmology *cosmo;
-  CCL_ClWorkspace *w;
   CCL_ClTracer *clt1;
   CCL_ClTracer *clt2;
   int *status;
 } IntClPar;
 
+//Scale factor at a given comoving distance. Unlike ccl_scale_factor_of_chi, this doesn't use
+//the accelerator stored in the cosmology, so it can be called from several threads at once.
+//Distances must have been computed beforehand (see cls_compute_splines).
+static double cls_a_of_chi(ccl_cosmology *cosmo,double chi,int *status)
+{
+  double a;
+  if((chi<1.e-8) && (chi>=0.))
+    return 1.;
+  if(chi<0.) {
+    *status=CCL_ERROR_COMPUTECHI;
+    return NAN;
+  }
+
+  int gslstatus=gsl_spline_eval_e(cosmo->data.achi,chi,NULL,&a);
+  if(gslstatus!=GSL_SUCCESS) {
+    ccl_raise_gsl_warning(gslstatus,"ccl_cls.c: cls_a_of_chi():");
+    *status|=gslstatus;
+  }
+  return a;
+}
+
 //Integrand for integral power spectrum
 static double cl_integrand(double lk,void *params)
 {
   double d1,d2;
   IntClPar *p=(IntClPar *)params;
-  d1=transfer_wrap(p->il,lk,p->cosmo,p->w,p->clt1,p->status);
+  d1=transfer_wrap(p->l,lk,p->clt1);
   if(d1==0)
     return 0;
-  d2=transfer_wrap(p->il,lk,p->cosmo,p->w,p->clt2,p->status);
+  d2=transfer_wrap(p->l,lk,p->clt2);
   if(d2==0)
     return 0;
 
   double k=pow(10.,lk);
-  double chi=(p->w->l_arr[p->il]+0.5)/k;
-  double a=ccl_scale_factor_of_chi(p->cosmo,chi,p->status);
+  double chi=(p->l+0.5)/k;
+  double a=cls_a_of_chi(p->cosmo,chi,p->status);
   double pk=ccl_nonlin_matter_power(p->cosmo,k,a,p->status);
   
   return k*pk*d1*d2;
@@ -881,73 +1585,810 @@ static void get_k_interval(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
   *lkmin=log10(fmax( ccl_splines->K_MIN  ,0.5*(l+0.5)/chimax));
 }
 
-//Compute angular power spectrum between two bins
-//cosmo -> ccl_cosmology object
-//il -> index in angular multipole array
-//clt1 -> tracer #1
-//clt2 -> tracer #2
-static double ccl_angular_cl_native(ccl_cosmology *cosmo,CCL_ClWorkspace *cw,int il,
-				    CCL_ClTracer *clt1,CCL_ClTracer *clt2,int * status)
+//Kernel spline of a tracer, used to figure out where it has support and how finely it's sampled
+static SplPar *clt_kernel_spline(CCL_ClTracer *clt)
 {
-  int clastatus=0, gslstatus;
-  IntClPar ipar;
-  double result=0,eresult;
-  double lkmin,lkmax;
-  gsl_function F;
-  gsl_integration_workspace *w=gsl_integration_workspace_alloc(ccl_gsl->N_ITERATION);
+  if(clt->spl_kd!=NULL)
+    return clt->spl_kd;
+  else
+    return clt->spl_kl;
+}
 
-  ipar.il=il;
-  ipar.cosmo=cosmo;
-  ipar.w=cw;
-  ipar.clt1=clt1;
-  ipar.clt2=clt2;
-  ipar.status = &clastatus;
-  F.function=&cl_integrand;
-  F.params=&ipar;
-  get_k_interval(cosmo,cw,clt1,clt2,cw->l_arr[il],&lkmin,&lkmax);
-  // This computes the angular power spectra in the Limber approximation between two quantities a and b:
-  //  C_ell^ab = 2/(2*ell+1) * Integral[ Delta^a_ell(k) Delta^b_ell(k) * P(k) , k_min < k < k_max ]
-  // Note that we use log10(k) as an integration variable, and the ell-dependent prefactor is included
-  // at the end of this function.
-  gslstatus=gsl_integration_qag(&F, lkmin, lkmax, 0,
-                                ccl_gsl->INTEGRATION_LIMBER_EPSREL, ccl_gsl->N_ITERATION,
-                                ccl_gsl->INTEGRATION_LIMBER_GAUSS_KRONROD_POINTS,
-                                w, &result, &eresult);
-  gsl_integration_workspace_free(w);
+//Width of the quadrature panel starting at chi. Panels span two kernel grid intervals
+//of the most finely sampled tracer covering chi (and at most 2*CCL_DCHI_KERNEL).
+//At low chi the width is limited to a fraction CCL_LIMBER_DLNCHI of chi, so that
+//the rapid variation of P((l+1/2)/chi) is resolved.
+static double limber_panel_width(double chi,int n_tracers,CCL_ClTracer **clts)
+{
+  int it;
+  double dchi=2*CCL_DCHI_KERNEL;
 
-  // Test if a round-off error occured in the evaluation of the integral
-  // If so, try another integration function, more robust but potentially slower
-  if(gslstatus == GSL_EROUND) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_cls.c: ccl_angular_cl_native(): Default GSL integration failure, attempting backup method.");
-    gsl_integration_cquad_workspace *w_cquad= gsl_integration_cquad_workspace_alloc (ccl_gsl->N_ITERATION);
-    size_t nevals=0;
-    gslstatus=gsl_integration_cquad(&F, lkmin, lkmax, 0,
-				    ccl_gsl->INTEGRATION_LIMBER_EPSREL,
-				    w_cquad, &result, &eresult, &nevals);
+  for(it=0;it<n_tracers;it++) {
+    SplPar *spl=clt_kernel_spline(clts[it]);
+    if((chi>=spl->x0) && (chi<spl->xf))
+      dchi=fmin(dchi,2*(spl->xf-spl->x0)/(spl->spline->size-1));
+  }
+
+  return fmin(dchi,CCL_LIMBER_DLNCHI*chi);
+}
+
+//Range of comoving distances where a set of tracers have support.
+//If do_union is zero, only the range where all of them have support is returned
+//(i.e. the range where the Limber integrand of a single pair is non-zero).
+static void limber_chi_range(int n_tracers,CCL_ClTracer **clts,int do_union,
+			     double *chi_lo,double *chi_hi)
+{
+  int it;
+
+  *chi_lo=clt_kernel_spline(clts[0])->x0;
+  *chi_hi=clts[0]->chimax;
+  for(it=1;it<n_tracers;it++) {
+    double x0=clt_kernel_spline(clts[it])->x0;
+    if(do_union) {
+      *chi_lo=fmin(*chi_lo,x0);
+      *chi_hi=fmax(*chi_hi,clts[it]->chimax);
+    }
+    else {
+      *chi_lo=fmax(*chi_lo,x0);
+      *chi_hi=fmin(*chi_hi,clts[it]->chimax);
+    }
+  }
+  //k=(l+1/2)/chi never goes above K_MAX for l>=0
+  *chi_lo=fmax(*chi_lo,0.5/ccl_splines->K_MAX);
+}
+
+//Number of panels of the composite Gauss-Legendre quadrature in chi used for a set of tracers
+//n_tracers -> number of tracers
+//clts -> tracers, used to set the panel widths
+//chi_lo, chi_hi -> integration range
+static int limber_chi_npanels(int n_tracers,CCL_ClTracer **clts,double chi_lo,double chi_hi)
+{
+  int n_panels=0;
+  double chi=chi_lo;
+
+  while(chi<chi_hi) {
+    chi+=limber_panel_width(chi,n_tracers,clts);
+    n_panels++;
+  }
+
+  return n_panels;
+}
+
+//Nodes and weights of a composite Gauss-Legendre quadrature in chi,
+//with CCL_LIMBER_NGL points per panel.
+//n_tracers -> number of tracers
+//clts -> tracers, used to set the panel widths
+//chi_lo, chi_hi -> integration range
+//n_panels -> number of panels (see limber_chi_npanels)
+//tgl -> Gauss-Legendre table with CCL_LIMBER_NGL points
+//chi_q, w_q -> nodes and weights, with n_panels*CCL_LIMBER_NGL elements
+static void limber_chi_nodes(int n_tracers,CCL_ClTracer **clts,double chi_lo,double chi_hi,
+			     int n_panels,gsl_integration_glfixed_table *tgl,double *chi_q,double *w_q)
+{
+  int ip,ig;
+  double chi=chi_lo;
+
+  for(ip=0;ip<n_panels;ip++) {
+    double chi_next=fmin(chi+limber_panel_width(chi,n_tracers,clts),chi_hi);
+    for(ig=0;ig<CCL_LIMBER_NGL;ig++)
+      gsl_integration_glfixed_point(chi,chi_next,ig,&(chi_q[ip*CCL_LIMBER_NGL+ig]),
+				    &(w_q[ip*CCL_LIMBER_NGL+ig]),tgl);
+    chi=chi_next;
+  }
+}
+
+//Scale factor at the nodes of a Limber quadrature. This is called once, outside any parallel
+//region, so that the power spectrum weights can then be computed by several threads.
+static void limber_scale_factors(ccl_cosmology *cosmo,int n_chi,double *chi,double *a,int *status)
+{
+  int ic;
+
+  for(ic=0;ic<n_chi;ic++) {
+    a[ic]=ccl_scale_factor_of_chi(cosmo,chi[ic],status);
+    if(*status)
+      break;
+  }
+}
+
+//Weights of the Limber integral over chi at a given ell:
+//   C_ell = Sum_i pw_i * Delta^a_ell(chi_i) * Delta^b_ell(chi_i), pw_i = w_i * P((l+1/2)/chi_i,a(chi_i))/chi_i^2
+//Nodes with k outside [K_MIN,K_MAX] are given zero weight.
+//a -> scale factor at the nodes (see limber_scale_factors)
+static void limber_power_weights(ccl_cosmology *cosmo,int l,int n_chi,double *chi,double *w,
+				 double *a,double *pw,int *status)
+{
+  int ic;
+
+  for(ic=0;ic<n_chi;ic++) {
+    double k=(l+0.5)/chi[ic];
+    if((k<ccl_splines->K_MIN) || (k>ccl_splines->K_MAX))
+      pw[ic]=0;
+    else {
+      pw[ic]=w[ic]*ccl_nonlin_matter_power(cosmo,k,a[ic],status)/(chi[ic]*chi[ic]);
+    }
+  }
+}
+
+//Compute angular power spectrum between two bins
+//cosmo -> ccl_cosmology object
+//cw -> CCL_ClWorkspace object
+//l -> angular multipole
+//clt1 -> tracer #1
+//clt2 -> tracer #2
+//w -> integration workspace (this function is called from several threads, each with its own workspace)
+static double ccl_angular_cl_native(ccl_cosmology *cosmo,CCL_ClWorkspace *cw,int l,
+				    CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+				    gsl_integration_workspace *w,int * status)
+{
+  int clastatus=0, gslstatus;
+  IntClPar ipar;
+  double result=0,eresult;
+  double lkmin,lkmax;
+  gsl_function F;
+
+  ipar.l=l;
+  ipar.cosmo=cosmo;
+  ipar.clt1=clt1;
+  ipar.clt2=clt2;
+  ipar.status = &clastatus;
+  F.function=&cl_integrand;
+  F.params=&ipar;
+  get_k_interval(cosmo,cw,clt1,clt2,l,&lkmin,&lkmax);
+  // This computes the angular power spectra in the Limber approximation between two quantities a and b:
+  //  C_ell^ab = 2/(2*ell+1) * Integral[ Delta^a_ell(k) Delta^b_ell(k) * P(k) , k_min < k < k_max ]
+  // Note that we use log10(k) as an integration variable, and the ell-dependent prefactor is included
+  // at the end of this function.
+  gslstatus=gsl_integration_qag(&F, lkmin, lkmax, 0,
+                                ccl_gsl->INTEGRATION_LIMBER_EPSREL, ccl_gsl->N_ITERATION,
+                                ccl_gsl->INTEGRATION_LIMBER_GAUSS_KRONROD_POINTS,
+                                w, &result, &eresult);
+
+  // Test if a round-off error occured in the evaluation of the integral
+  // If so, try another integration function, more robust but potentially slower
+  if(gslstatus == GSL_EROUND) {
+    ccl_raise_gsl_warning(gslstatus, "ccl_cls.c: ccl_angular_cl_native(): Default GSL integration failure, attempting backup method.");
+    gsl_integration_cquad_workspace *w_cquad= gsl_integration_cquad_workspace_alloc (ccl_gsl->N_ITERATION);
+    size_t nevals=0;
+    gslstatus=gsl_integration_cquad(&F, lkmin, lkmax, 0,
+				    ccl_gsl->INTEGRATION_LIMBER_EPSREL,
+				    w_cquad, &result, &eresult, &nevals);
     gsl_integration_cquad_workspace_free(w_cquad);
   }
   if(gslstatus!=GSL_SUCCESS || *ipar.status) {
     ccl_raise_gsl_warning(gslstatus, "ccl_cls.c: ccl_angular_cl_native():");
     // If an error status was already set, don't overwrite it.
-    if(*status == 0){
-        *status=CCL_ERROR_INTEG;
-        ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cl_native(): error integrating over k\n");
-    }
+    // Since this is called from several threads, the status message is set by the caller
+    // once the parallel region is over.
+    if(*status == 0)
+      *status=CCL_ERROR_INTEG;
     return -1;
   }
-  ccl_check_status(cosmo,status);
 
-  return result*M_LN10/(cw->l_arr[il]+0.5);
+  return result*M_LN10/(l+0.5);
+}
+
+//Make sure all the splines needed by the Limber integrand are computed before
+//entering a parallel region, since only their evaluation is thread-safe.
+static void cls_compute_splines(ccl_cosmology *cosmo,int *status)
+{
+  if(!cosmo->computed_distances)
+    ccl_cosmology_compute_distances(cosmo,status);
+  if((*status==0) && (!cosmo->computed_growth) && (cosmo->params.N_nu_mass<=0))
+    ccl_cosmology_compute_growth(cosmo,status);
+  if((*status==0) && (!cosmo->computed_power))
+    ccl_cosmology_compute_power(cosmo,status);
+}
+
+//Compute angular power spectrum between two bins using a fixed quadrature in chi.
+//Unlike ccl_angular_cl_native, the cost of this is the same for all multipoles.
+//l -> angular multipole
+//clt1 -> tracer #1
+//clt2 -> tracer #2
+//n_chi, chi -> quadrature nodes (see limber_chi_nodes)
+//pw -> quadrature weights times the power spectrum at this multipole (see limber_power_weights)
+static double ccl_angular_cl_fixed(int l,CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+				   int n_chi,double *chi,double *pw)
+{
+  int ic;
+  double result=0;
+
+  for(ic=0;ic<n_chi;ic++) {
+    if(pw[ic]!=0) {
+      double k=(l+0.5)/chi[ic];
+      result+=pw[ic]*transfer_limber(l,k,clt1)*transfer_limber(l,k,clt2);
+    }
+  }
+
+  return result;
+}
+
+//Sets up the fixed-node Limber quadrature for a pair of tracers in a workspace, together
+//with the power spectrum at its nodes for all multipoles. The latter is only recomputed if
+//the cosmology or the quadrature nodes differ from the ones stored in the workspace.
+//Per-thread space for the power spectrum at other multipoles (see angular_cls_limber_ells)
+//is also set up here.
+static void cl_workspace_limber_quadrature(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+					   CCL_ClTracer *clt1,CCL_ClTracer *clt2,int *status)
+{
+  int n_panels,n_chi;
+  double chi_lo,chi_hi;
+  CCL_ClTracer *clts[2]={clt1,clt2};
+
+  limber_chi_range(2,clts,0,&chi_lo,&chi_hi);
+  n_panels=limber_chi_npanels(2,clts,chi_lo,chi_hi);
+  n_chi=n_panels*CCL_LIMBER_NGL;
+  cl_workspace_alloc_quadrature(cosmo,w,CCL_MAX(n_chi,1),status);
+  if(*status==0)
+    cl_workspace_alloc_scratch(cosmo,w,CCL_MAX(n_chi,1),status);
+  if(*status)
+    return;
+
+  limber_chi_nodes(2,clts,chi_lo,chi_hi,n_panels,w->tgl,w->chi_new,w->wchi_new);
+  if((w->pw_cosmo==cosmo) && (n_chi==w->n_chi) &&
+     ccl_parameters_equal(&(w->pw_params),&(cosmo->params)) &&
+     ccl_configuration_equal(&(w->pw_config),&(cosmo->config)) &&
+     (!memcmp(w->chi,w->chi_new,n_chi*sizeof(double))) &&
+     (!memcmp(w->wchi,w->wchi_new,n_chi*sizeof(double))))
+    return;
+
+  //Swap the new quadrature in
+  double *tmp;
+  tmp=w->chi; w->chi=w->chi_new; w->chi_new=tmp;
+  tmp=w->wchi; w->wchi=w->wchi_new; w->wchi_new=tmp;
+  w->n_chi=n_chi;
+  w->pw_cosmo=NULL;
+  limber_scale_factors(cosmo,n_chi,w->chi,w->achi,status);
+  if(*status)
+    return;
+
+#pragma omp parallel default(none) shared(cosmo,w,n_chi,status)
+  {
+    int ii,status_this=0;
+
+#pragma omp for schedule(dynamic)
+    for(ii=0;ii<w->n_ls;ii++) {
+      if(status_this==0)
+	limber_power_weights(cosmo,w->l_arr[ii],n_chi,w->chi,w->wchi,w->achi,&(w->pw[ii*n_chi]),&status_this);
+    } //end omp for
+
+    if(status_this) {
+#pragma omp critical
+      {
+	*status=status_this;
+      }
+    }
+  } //end omp parallel
+
+  if(*status) {
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_limber_quadrature(); "
+				     "error computing power spectrum\n");
+    return;
+  }
+  w->pw_cosmo=cosmo;
+  w->pw_params=cosmo->params;
+  w->pw_config=cosmo->config;
+}
+
+//Compute the Limber power spectrum at all the nodes of a workspace that are not
+//already covered by a non-Limber calculation. Nodes are distributed among threads,
+//each of which uses its own integration workspace. Since every node is computed
+//independently, the result does not depend on the number of threads.
+//cosmo -> ccl_cosmology object
+//w -> CCL_ClWorkspace object
+//clt1, clt2 -> tracers
+//do_nonlimber -> if nonzero, nodes with l<=w->l_limber are skipped
+//cl_nodes -> output power spectrum at the workspace nodes
+static void angular_cls_limber_nodes(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+				     CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+				     int do_nonlimber,double *cl_nodes,int *status)
+{
+  cls_compute_splines(cosmo,status);
+  if(*status)
+    return;
+
+  if(w->limber_method==ccl_limber_gl_chi)
+    cl_workspace_limber_quadrature(cosmo,w,clt1,clt2,status);
+  else if(w->limber_method==ccl_limber_qag_logk)
+    cl_workspace_alloc_threads(cosmo,w,status);
+  else {
+    *status=CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: angular_cls_limber_nodes(); unknown Limber integration method\n");
+  }
+  if(*status)
+    return;
+
+#pragma omp parallel default(none) \
+                     shared(cosmo,w,clt1,clt2,do_nonlimber,cl_nodes,status)
+  {
+    int ii,status_this=0;
+    gsl_integration_workspace *wsp=NULL;
+
+    if(w->limber_method==ccl_limber_qag_logk) {
+#ifdef _OPENMP
+      wsp=w->w_integ[omp_get_thread_num()];
+#else //_OPENMP
+      wsp=w->w_integ[0];
+#endif //_OPENMP
+    }
+
+#pragma omp for schedule(dynamic)
+    for(ii=0;ii<w->n_ls;ii++) {
+      if((status_this==0) && ((!do_nonlimber) || (w->l_arr[ii]>w->l_limber))) {
+	if(w->limber_method==ccl_limber_gl_chi)
+	  cl_nodes[ii]=ccl_angular_cl_fixed(w->l_arr[ii],clt1,clt2,w->n_chi,w->chi,&(w->pw[ii*w->n_chi]));
+	else
+	  cl_nodes[ii]=ccl_angular_cl_native(cosmo,w,w->l_arr[ii],clt1,clt2,wsp,&status_this);
+      }
+    } //end omp for
+
+    if(status_this) {
+#pragma omp critical
+      {
+	*status=status_this;
+      }
+    }
+  } //end omp parallel
+
+  if(*status) {
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: angular_cls_limber_nodes(); "
+				     "error computing Limber power spectrum\n");
+  }
+}
+
+//Params for angular_cls_limber_ells
+typedef struct {
+  CCL_ClWorkspace *w;
+  CCL_ClTracer *clt1;
+  CCL_ClTracer *clt2;
+} ClPairPar;
+
+//Compute the Limber power spectrum between two tracers at arbitrary multipoles, using
+//the integration method and scratch space set up by angular_cls_limber_nodes.
+//Multipoles are distributed among threads.
+//cosmo -> ccl_cosmology object
+//n_l, l -> multipoles
+//cl -> output power spectrum
+//params -> ClPairPar
+static void angular_cls_limber_ells(ccl_cosmology *cosmo,int n_l,int *l,double *cl,
+				    void *params,int *status)
+{
+  ClPairPar *p=(ClPairPar *)params;
+  CCL_ClWorkspace *w=p->w;
+
+#pragma omp parallel default(none) shared(cosmo,n_l,l,cl,p,w,status)
+  {
+    int ii,status_this=0;
+    double *pw=NULL;
+    gsl_integration_workspace *wsp=NULL;
+
+    if(w->limber_method==ccl_limber_gl_chi) {
+      //Per-thread space set up by cl_workspace_limber_quadrature
+#ifdef _OPENMP
+      pw=&(w->scratch[omp_get_thread_num()*w->n_scratch]);
+#else //_OPENMP
+      pw=w->scratch;
+#endif //_OPENMP
+    }
+    else {
+#ifdef _OPENMP
+      wsp=w->w_integ[omp_get_thread_num()];
+#else //_OPENMP
+      wsp=w->w_integ[0];
+#endif //_OPENMP
+    }
+
+#pragma omp for schedule(dynamic)
+    for(ii=0;ii<n_l;ii++) {
+      if(status_this==0) {
+	if(w->limber_method==ccl_limber_gl_chi) {
+	  limber_power_weights(cosmo,l[ii],w->n_chi,w->chi,w->wchi,w->achi,pw,&status_this);
+	  cl[ii]=ccl_angular_cl_fixed(l[ii],p->clt1,p->clt2,w->n_chi,w->chi,pw);
+	}
+	else
+	  cl[ii]=ccl_angular_cl_native(cosmo,w,l[ii],p->clt1,p->clt2,wsp,&status_this);
+      }
+    } //end omp for
+
+    if(status_this) {
+#pragma omp critical
+      {
+	*status=status_this;
+      }
+    }
+  } //end omp parallel
+}
+
+//Function computing n_spectra power spectra at n_l multipoles l, storing spectrum s at l[i]
+//in cl[s*n_l+i]. Used to place multipole nodes adaptively.
+typedef void (*cl_evaluator_t)(ccl_cosmology *cosmo,int n_l,int *l,double *cl,
+			       void *params,int *status);
+
+//Replaces the multipole nodes of a workspace by the n_ls multipoles in l_arr, the power spectra
+//at the nodes by cl_nodes (w->n_spectra_alloc*n_ls elements) and the convergence flags of the
+//intervals between nodes by conv (n_ls elements). These arrays are taken over by the workspace.
+//All other per-node scratch space is resized.
+static void cl_workspace_set_nodes(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int n_ls,int *l_arr,
+				   double *cl_nodes,char *conv,int *status)
+{
+  int ii;
+  double *l_nodes=(double *)malloc(n_ls*sizeof(double));
+  int *ref_i=(int *)malloc(n_ls*sizeof(int));
+  int *ref_l=(int *)malloc(n_ls*sizeof(int));
+  char *ref_bad=(char *)malloc(n_ls*sizeof(char));
+  double *ref_cl=(double *)malloc(w->n_spectra_alloc*n_ls*sizeof(double));
+  double *pw=NULL;
+  gsl_spline *spl=gsl_spline_alloc(gsl_interp_cspline,n_ls);
+
+  if(w->n_chi_alloc>0)
+    pw=(double *)malloc(n_ls*w->n_chi_alloc*sizeof(double));
+  if((l_nodes==NULL) || (ref_i==NULL) || (ref_l==NULL) || (ref_bad==NULL) || (ref_cl==NULL) ||
+     ((w->n_chi_alloc>0) && (pw==NULL)) || (spl==NULL)) {
+    free(l_arr);
+    free(cl_nodes);
+    free(conv);
+    free(l_nodes);
+    free(ref_i);
+    free(ref_l);
+    free(ref_bad);
+    free(ref_cl);
+    free(pw);
+    if(spl!=NULL)
+      gsl_spline_free(spl);
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_set_nodes(); memory allocation\n");
+    return;
+  }
+
+  for(ii=0;ii<n_ls;ii++)
+    l_nodes[ii]=(double)(l_arr[ii]);
+
+  free(w->l_arr);
+  free(w->l_nodes);
+  free(w->cl_nodes);
+  free(w->ref_i);
+  free(w->ref_l);
+  free(w->ref_conv);
+  free(w->ref_bad);
+  free(w->ref_cl);
+  free(w->pw);
+  gsl_spline_free(w->spl_nodes->spline);
+  w->n_ls=n_ls;
+  w->l_arr=l_arr;
+  w->l_nodes=l_nodes;
+  w->cl_nodes=cl_nodes;
+  w->ref_i=ref_i;
+  w->ref_l=ref_l;
+  w->ref_conv=conv;
+  w->ref_bad=ref_bad;
+  w->ref_cl=ref_cl;
+  w->pw=pw;
+  w->spl_nodes->spline=spl;
+  //The power spectrum table of the fixed-node quadrature must be recomputed for the new nodes
+  w->pw_cosmo=NULL;
+}
+
+//Adaptively adds multipole nodes to a workspace. Each interval between consecutive nodes
+//is bisected, and the midpoint is kept as a new node if the spline through the current nodes
+//misses the power spectrum there by more than w->l_tol times its local amplitude for any of
+//the spectra. This is repeated until all intervals have converged or are one multipole wide.
+//Since the new nodes are stored in the workspace, they are reused by later calls, and memory
+//is only allocated when nodes are added.
+//cosmo -> ccl_cosmology object
+//w -> CCL_ClWorkspace object
+//n_spectra -> number of power spectra, stored at the current nodes in w->cl_nodes
+//l_min -> only intervals starting at l>=l_min are refined
+//eval, params -> function used to compute the power spectra at new multipoles
+static void cl_workspace_refine_nodes(ccl_cosmology *cosmo,CCL_ClWorkspace *w,int n_spectra,
+				      int l_min,cl_evaluator_t eval,void *params,int *status)
+{
+  int ii;
+
+  for(ii=0;ii<w->n_ls-1;ii++)
+    w->ref_conv[ii]=0;
+
+  while(*status==0) {
+    int jj,ic,is,nc=0,n_bad=0;
+    //Scratch space owned by the workspace. It is replaced when nodes are added.
+    int *i_c=w->ref_i,*l_c=w->ref_l;
+    char *conv=w->ref_conv,*bad=w->ref_bad;
+    double *cl_c=w->ref_cl;
+
+    //Intervals that still need to be checked
+    for(ii=0;ii<w->n_ls-1;ii++) {
+      if((!conv[ii]) && (w->l_arr[ii]>=l_min) && (w->l_arr[ii+1]-w->l_arr[ii]>1))
+	nc++;
+      else
+	conv[ii]=1;
+    }
+    if(nc==0)
+      break;
+
+    //Power spectra at the midpoints
+    ic=0;
+    for(ii=0;ii<w->n_ls-1;ii++) {
+      if(!conv[ii]) {
+	i_c[ic]=ii;
+	l_c[ic]=(w->l_arr[ii]+w->l_arr[ii+1])/2;
+	bad[ic]=0;
+	ic++;
+      }
+    }
+    eval(cosmo,nc,l_c,cl_c,params,status);
+    if(*status) {
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_refine_nodes(); "
+				       "error computing power spectra at new nodes\n");
+      break;
+    }
+
+    //Compare them with the interpolation from the current nodes
+    for(is=0;is<n_spectra;is++) {
+      double *cl_s=&(w->cl_nodes[is*w->n_ls]);
+      if(gsl_spline_init(w->spl_nodes->spline,w->l_nodes,cl_s,w->n_ls)) {
+	*status=CCL_ERROR_SPLINE;
+	ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_refine_nodes(); "
+					 "error initializing spline for power spectrum nodes\n");
+	break;
+      }
+      for(ic=0;ic<nc;ic++) {
+	double cl_true=cl_c[is*nc+ic];
+	double cl_int=ccl_spline_eval((double)(l_c[ic]),w->spl_nodes);
+	double amp=fmax(fabs(cl_true),fmax(fabs(cl_s[i_c[ic]]),fabs(cl_s[i_c[ic]+1])));
+	if(fabs(cl_int-cl_true)>w->l_tol*amp)
+	  bad[ic]=1;
+      }
+    }
+    if(*status)
+      break;
+
+    for(ic=0;ic<nc;ic++) {
+      if(bad[ic])
+	n_bad++;
+      else
+	conv[i_c[ic]]=1;
+    }
+
+    if(n_bad>0) {
+      //Insert the midpoints that failed as new nodes
+      int n_new=w->n_ls+n_bad;
+      int *l_new=(int *)malloc(n_new*sizeof(int));
+      double *cl_new=(double *)malloc(w->n_spectra_alloc*n_new*sizeof(double));
+      char *conv_new=(char *)calloc(n_new,sizeof(char));
+      if((l_new==NULL) || (cl_new==NULL) || (conv_new==NULL)) {
+	free(l_new);
+	free(cl_new);
+	free(conv_new);
+	*status=CCL_ERROR_MEMORY;
+	ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: cl_workspace_refine_nodes(); memory allocation\n");
+	break;
+      }
+
+      jj=0; ic=0;
+      for(ii=0;ii<w->n_ls;ii++) {
+	l_new[jj]=w->l_arr[ii];
+	for(is=0;is<n_spectra;is++)
+	  cl_new[is*n_new+jj]=w->cl_nodes[is*w->n_ls+ii];
+	if(ii<w->n_ls-1)
+	  conv_new[jj]=conv[ii];
+	jj++;
+	if((ic<nc) && (i_c[ic]==ii)) {
+	  if(bad[ic]) {
+	    l_new[jj]=l_c[ic];
+	    for(is=0;is<n_spectra;is++)
+	      cl_new[is*n_new+jj]=cl_c[is*nc+ic];
+	    conv_new[jj]=0;
+	    jj++;
+	  }
+	  ic++;
+	}
+      }
+      cl_workspace_set_nodes(cosmo,w,n_new,l_new,cl_new,conv_new,status);
+    }
+  }
+}
+
+//Fourier transforms (in log(chi)) of the radial sources of a tracer used by the non-Limber integrator:
+//  s_0 = kd(chi)*D(chi), s_1 = kr(chi), s_2 = kl(chi)*D(chi),
+//each multiplied by chi^(-1/2) as required by the Hankel transform (see angular_cls_nonlimber_nodes).
+//clt -> CCL_ClTracer object
+//n_chi, chi -> log-spaced grid in chi
+//growth -> growth factor on that grid
+//plan -> in-place forward FFT plan of size n_chi
+//src -> output transforms. Source i is stored in src[i*n_chi].
+//has_src -> has_src[i] is set to 0 if the tracer doesn't have source i, which is then not computed.
+static void nonlimber_sources(CCL_ClTracer *clt,int n_chi,double *chi,double *growth,
+			      fftw_plan plan,double complex *src,int *has_src)
+{
+  int is,ic;
+  SplPar *spl[3]={clt->spl_kd,clt->spl_kr,clt->spl_kl};
+
+  for(is=0;is<3;is++) {
+    double complex *s_i=&(src[is*n_chi]);
+    has_src[is]=(spl[is]!=NULL);
+    if(!has_src[is])
+      continue;
+
+    for(ic=0;ic<n_chi;ic++) {
+      double s=0;
+      if((chi[ic]>=spl[is]->x0) && (chi[ic]<=clt->chimax)) {
+	s=ccl_spline_eval(chi[ic],spl[is])/sqrt(chi[ic]);
+	if(is!=1) //The RSD kernel already contains the growth factor
+	  s*=growth[ic];
+      }
+      s_i[ic]=s;
+    }
+    fftw_execute_dft(plan,(fftw_complex *)s_i,(fftw_complex *)s_i);
+  }
+}
+
+//Coefficients c[i][m] multiplying source s_i (see nonlimber_sources) in the spherical Bessel
+//transform of order l-2+2*m that contributes to the non-Limber transfer function of a tracer:
+//   Delta_l(k) = Sum_{i,m} c[i][m] Int dchi s_i(chi) j_{l-2+2m}(k*chi) (times chi^(1/2), see above).
+//The RSD and lensing-like terms are written in terms of j_{l-2}, j_l and j_{l+2} using
+//   -j''_l(x) = -l(l-1)/((2l-1)(2l+1)) j_{l-2} + (2l^2+2l-1)/((2l-1)(2l+3)) j_l - (l+1)(l+2)/((2l+1)(2l+3)) j_{l+2}
+//   j_l(x)/x^2 = j_{l-2}/((2l-1)(2l+1)) + 2 j_l/((2l-1)(2l+3)) + j_{l+2}/((2l+1)(2l+3))
+//so that no additional powers of chi are needed.
+static void nonlimber_coefficients(int l,CCL_ClTracer *clt,double c[3][3])
+{
+  double pf=clt_ell_prefactor(l,clt);
+  double am=(2*l-1.)*(2*l+1.);
+  double a0=(2*l-1.)*(2*l+3.);
+  double ap=(2*l+1.)*(2*l+3.);
+
+  //Density
+  c[0][0]=0;
+  c[0][1]=1;
+  c[0][2]=0;
+
+  //RSD
+  c[1][0]=-l*(l-1.)/am;
+  c[1][1]=(2.*l*l+2*l-1)/a0;
+  c[1][2]=-(l+1.)*(l+2.)/ap;
+
+  //Lensing-like terms (magnification, shear, intrinsic alignments and CMB lensing)
+  c[2][0]=pf/am;
+  c[2][1]=2*pf/a0;
+  c[2][2]=pf/ap;
+}
+
+//Compute the non-Limber power spectrum at all the nodes of a workspace with l<=w->l_limber.
+//Each tracer's transfer function is
+//   Delta_l(k) = Int dchi s(chi) j_l(k*chi) = sqrt(pi/2k) * (1/k) * Int dchi [s(chi)/sqrt(chi)] J_{l+1/2}(k*chi) k
+//which is computed with FFTLog on a log-spaced grid in chi, and the power spectrum is
+//   C_l = 2/pi Int dk k^2 P_L(k,z=0) Delta^1_l(k) Delta^2_l(k)
+//where the time evolution of the linear power spectrum is absorbed in the sources through
+//the growth factor. Since all transforms share the same grid, the sources are Fourier-transformed
+//once, and each multipole only requires one inverse FFT per tracer. Multipoles are
+//distributed among threads. All buffers and FFTW plans are owned by the workspace.
+//cosmo -> ccl_cosmology object
+//w -> CCL_ClWorkspace object
+//clt1, clt2 -> tracers
+//cl_nodes -> output power spectrum at the workspace nodes
+static void angular_cls_nonlimber_nodes(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+					CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+					double *cl_nodes,int *status)
+{
+  int ic,it,n_chi=CCL_NONLIMBER_NCHI;
+  int has_src[2][3];
+  double lnk_range,k0,chi_hi,chi_ratio;
+  double *chi,*growth,*pk;
+  double complex *src;
+  cl_nonlimber_scratch *s;
+  CCL_ClTracer *clts[2]={clt1,clt2};
+  int n_clts=(clt1==clt2) ? 1 : 2;
+
+  cls_compute_splines(cosmo,status);
+  if(*status==0)
+    cl_workspace_alloc_nonlimber(cosmo,w,status);
+  if(*status)
+    return;
+  s=w->nl_scratch;
+  chi=s->chi;
+  growth=s->growth;
+  pk=s->pk;
+  src=s->src;
+
+  //Log-spaced grid in chi, same as ccl_log_spacing
+  chi_ratio=exp(log(ccl_splines->K_MAX/ccl_splines->K_MIN)/(n_chi-1.));
+  chi[0]=1./ccl_splines->K_MAX;
+  for(ic=1;ic<n_chi-1;ic++)
+    chi[ic]=chi[ic-1]*chi_ratio;
+  chi[n_chi-1]=1./ccl_splines->K_MIN;
+
+  //Wavenumbers dual to the chi grid (FFTLog with kc*rc=1)
+  lnk_range=n_chi*log(chi[n_chi-1]/chi[0])/(n_chi-1.);
+  k0=exp(-lnk_range)/chi[0];
+
+  chi_hi=fmax(clt1->chimax,clt2->chimax);
+  for(ic=0;ic<n_chi;ic++) {
+    double k=k0*exp(ic*lnk_range/n_chi);
+    growth[ic]=0;
+    if(chi[ic]<=chi_hi)
+      growth[ic]=ccl_growth_factor(cosmo,ccl_scale_factor_of_chi(cosmo,chi[ic],status),status);
+    pk[ic]=0;
+    if((k>=ccl_splines->K_MIN) && (k<=ccl_splines->K_MAX))
+      pk[ic]=ccl_linear_matter_power(cosmo,k,1.,status);
+  }
+  if(*status) {
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: angular_cls_nonlimber_nodes(); "
+				     "error computing growth factor or linear power spectrum\n");
+    return;
+  }
+
+  for(it=0;it<n_clts;it++)
+    nonlimber_sources(clts[it],n_chi,chi,growth,s->plan_f,&(src[3*it*n_chi]),has_src[it]);
+
+#pragma omp parallel default(none) \
+                     shared(w,s,clts,n_clts,n_chi,lnk_range,pk,src,has_src,cl_nodes)
+  {
+    int ii,ith=0;
+#ifdef _OPENMP
+    ith=omp_get_thread_num();
+#endif //_OPENMP
+    double complex *u=&(s->u[3*ith*n_chi]);
+    double complex *bk=&(s->bk[ith*n_chi]);
+    double *tk=&(s->tk[2*ith*n_chi]);
+
+#pragma omp for schedule(dynamic)
+    for(ii=0;ii<w->n_ls;ii++) {
+      int l=w->l_arr[ii],jt,js,im,jc;
+      int need_u[3]={0,0,0};
+      double c[2][3][3],cl=0;
+      double *tk2=(n_clts==1) ? tk : tk+n_chi;
+
+      if(l>w->l_limber)
+	continue;
+
+      //Only compute the transform coefficients for the orders that are needed
+      for(jt=0;jt<n_clts;jt++) {
+	nonlimber_coefficients(l,clts[jt],c[jt]);
+	for(js=0;js<3;js++) {
+	  for(im=0;im<3;im++) {
+	    if(has_src[jt][js] && (c[jt][js][im]!=0))
+	      need_u[im]=1;
+	  }
+	}
+      }
+      for(im=0;im<3;im++) {
+	if(need_u[im])
+	  compute_u_coefficients(n_chi,l-1.5+2*im,0,lnk_range,1.,&(u[im*n_chi]));
+      }
+
+      for(jt=0;jt<n_clts;jt++) {
+	for(jc=0;jc<n_chi;jc++)
+	  bk[jc]=0;
+	for(js=0;js<3;js++) {
+	  double complex *s_j=&(src[(3*jt+js)*n_chi]);
+	  if(!has_src[jt][js])
+	    continue;
+	  for(im=0;im<3;im++) {
+	    //Normalize by n_chi, since FFTW doesn't normalize the inverse FFT
+	    double cc=c[jt][js][im]/n_chi;
+	    if(cc==0)
+	      continue;
+	    for(jc=0;jc<n_chi;jc++)
+	      bk[jc]+=cc*s_j[jc]*u[im*n_chi+jc];
+	  }
+	}
+	fftw_execute(s->plan_b[ith]);
+	//The transform at the n-th wavenumber is stored in element (N-n)%N
+	for(jc=0;jc<n_chi;jc++)
+	  tk[jt*n_chi+jc]=creal(bk[(n_chi-jc)%n_chi]);
+      }
+
+      //Integrate in log(k)
+      for(jc=0;jc<n_chi;jc++)
+	cl+=pk[jc]*tk[jc]*tk2[jc];
+      cl_nodes[ii]=cl*lnk_range/n_chi;
+    } //end omp for
+  } //end omp parallel
 }
 
 void ccl_angular_cls(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
 		     CCL_ClTracer *clt1,CCL_ClTracer *clt2,
 		     int nl_out,int *l_out,double *cl_out,int *status)
 {
-  int ii,do_angpow;
-  double *l_nodes,*cl_nodes;
-  SplPar *spcl_nodes;
-  
+  int ii,do_angpow=0,do_nonlimber=0;
+
   //First check if ell range is within workspace
   for(ii=0;ii<nl_out;ii++) {
     if(l_out[ii]>w->lmax) {
@@ -959,74 +2400,738 @@ void ccl_angular_cls(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
   }
 
   if(*status==0) {
-    //Allocate array for power spectrum at interpolation nodes
-    l_nodes=(double *)malloc(w->n_ls*sizeof(double));
-    if(l_nodes==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls(); memory allocation\n");
+    //Now check if non-Limber is needed at all
+    if(w->l_limber>0) {
+      for(ii=0;ii<w->n_ls;ii++) {
+	if(w->l_arr[ii]<=w->l_limber)
+	  do_nonlimber=1;
+      }
+    }
+
+    //Angpow can only be used for number counts without magnification
+    if(do_nonlimber && (w->nonlimber_method==ccl_nonlimber_angpow)) {
+#ifdef HAVE_ANGPOW
+      if((clt1->tracer_type==ccl_number_counts_tracer) && (clt2->tracer_type==ccl_number_counts_tracer) &&
+	 (!clt1->has_magnification) && (!clt2->has_magnification))
+	do_angpow=1;
+#endif //HAVE_ANGPOW
+      //Resort to Limber for everything else, unless the native method was requested
+      if(!do_angpow)
+	do_nonlimber=0;
     }
+
+    if(do_angpow) {
+#ifdef HAVE_ANGPOW
+      ccl_angular_cls_angpow(cosmo,w,clt1,clt2,w->cl_nodes,status);
+#endif //HAVE_ANGPOW
+    }
+    else if(do_nonlimber)
+      angular_cls_nonlimber_nodes(cosmo,w,clt1,clt2,w->cl_nodes,status);
+    ccl_check_status(cosmo,status);
   }
 
   if(*status==0) {
-    cl_nodes=(double *)malloc(w->n_ls*sizeof(double));
-    if(cl_nodes==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_angular_cls(); memory allocation\n");
+    //Compute limber nodes
+    angular_cls_limber_nodes(cosmo,w,clt1,clt2,do_nonlimber,w->cl_nodes,status);
+    ccl_check_status(cosmo,status);
+  }
+
+  if((*status==0) && (w->l_tol>0)) {
+    //Add Limber nodes where the interpolation isn't accurate enough
+    ClPairPar par={w,clt1,clt2};
+    cl_workspace_refine_nodes(cosmo,w,1,do_nonlimber ? w->l_limber+1 : 0,
+			      angular_cls_limber_ells,&par,status);
+    ccl_check_status(cosmo,status);
+  }
+
+  if(*status==0) {
+    //Interpolate into ells requested by user. The spline owned by the workspace is reused.
+    if(gsl_spline_init(w->spl_nodes->spline,w->l_nodes,w->cl_nodes,w->n_ls)) {
+      *status=CCL_ERROR_SPLINE;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls(); "
+				       "error initializing spline for power spectrum nodes\n");
+      ccl_check_status(cosmo,status);
     }
   }
 
   if(*status==0) {
-    for(ii=0;ii<w->n_ls;ii++)
-      l_nodes[ii]=(double)(w->l_arr[ii]);
+    for(ii=0;ii<nl_out;ii++)
+      cl_out[ii]=ccl_spline_eval((double)(l_out[ii]),w->spl_nodes);
+  }
+}
 
-    do_angpow=0;
-    //Now check if angpow is needed at all
-    if(w->l_limber>0) {
-      for(ii=0;ii<w->n_ls;ii++) {
-	if(w->l_arr[ii]<=w->l_limber)
-	  do_angpow=1;
+CCL_ClCache *ccl_cl_cache_new(int max_entries,int *status)
+{
+  CCL_ClCache *c=(CCL_ClCache *)malloc(sizeof(CCL_ClCache));
+  if(c==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  c->max_entries=CCL_MAX(max_entries,1);
+  c->n_entries=0;
+  c->n_calls=0;
+  c->n_hits=0;
+  c->cosmo=NULL;
+  c->entries=(CCL_ClCacheEntry *)malloc(c->max_entries*sizeof(CCL_ClCacheEntry));
+  if(c->entries==NULL) {
+    free(c);
+    *status=CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  return c;
+}
+
+void ccl_cl_cache_clear(CCL_ClCache *c)
+{
+  int ii;
+
+  for(ii=0;ii<c->n_entries;ii++)
+    ccl_spline_free(c->entries[ii].spl);
+  c->n_entries=0;
+  c->cosmo=NULL;
+}
+
+void ccl_cl_cache_free(CCL_ClCache *c)
+{
+  if(c!=NULL) {
+    ccl_cl_cache_clear(c);
+    free(c->entries);
+    free(c);
+  }
+}
+
+//Returns the entry of a cache holding the power spectrum between two tracers computed with
+//the nodes defined by a workspace (whatever its lmax), or NULL if there is none.
+static CCL_ClCacheEntry *cl_cache_find(CCL_ClCache *c,CCL_ClWorkspace *w,
+				       CCL_ClTracer *clt1,CCL_ClTracer *clt2)
+{
+  int ii;
+
+  for(ii=0;ii<c->n_entries;ii++) {
+    CCL_ClCacheEntry *e=&(c->entries[ii]);
+    if((((e->id1==clt1->id) && (e->id2==clt2->id)) || ((e->id1==clt2->id) && (e->id2==clt1->id))) &&
+       (e->l_limber==w->l_limber) && (e->l_logstep==w->l_logstep) && (e->l_linstep==w->l_linstep) &&
+       (e->limber_method==w->limber_method) && (e->nonlimber_method==w->nonlimber_method) &&
+       (e->l_tol==w->l_tol))
+      return e;
+  }
+
+  return NULL;
+}
+
+void ccl_angular_cls_cached(ccl_cosmology *cosmo,CCL_ClWorkspace *w,CCL_ClCache *cache,
+			    CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+			    int nl_out,int *l_out,double *cl_out,int *status)
+{
+  int ii,l_top=0;
+  CCL_ClCacheEntry *e;
+
+  for(ii=0;ii<nl_out;ii++)
+    l_top=CCL_MAX(l_top,l_out[ii]);
+  if(l_top>w->lmax) {
+    *status=CCL_ERROR_SPLINE_EV;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_cached(); "
+				     "requested l beyond range allowed by workspace\n");
+    return;
+  }
+
+  //Entries computed for a different cosmology are no longer valid
+  if((cache->cosmo!=cosmo) ||
+     (!ccl_parameters_equal(&(cache->params),&(cosmo->params))) ||
+     (!ccl_configuration_equal(&(cache->config),&(cosmo->config)))) {
+    ccl_cl_cache_clear(cache);
+    cache->cosmo=cosmo;
+    cache->params=cosmo->params;
+    cache->config=cosmo->config;
+  }
+
+  cache->n_calls++;
+  e=cl_cache_find(cache,w,clt1,clt2);
+  if((e!=NULL) && (e->lmax>=l_top)) {
+    //Only interpolation is needed
+    cache->n_hits++;
+    e->last_used=cache->n_calls;
+    for(ii=0;ii<nl_out;ii++)
+      cl_out[ii]=ccl_spline_eval((double)(l_out[ii]),e->spl);
+    return;
+  }
+
+  ccl_angular_cls(cosmo,w,clt1,clt2,nl_out,l_out,cl_out,status);
+  if(*status)
+    return;
+
+  //Store the power spectrum at the nodes, replacing the entry for the same tracers
+  //computed with a lower lmax or, if the cache is full, the least recently used one.
+  if(e==NULL) {
+    if(cache->n_entries<cache->max_entries)
+      e=&(cache->entries[cache->n_entries++]);
+    else {
+      e=&(cache->entries[0]);
+      for(ii=1;ii<cache->n_entries;ii++) {
+	if(cache->entries[ii].last_used<e->last_used)
+	  e=&(cache->entries[ii]);
       }
+      ccl_spline_free(e->spl);
     }
-#ifndef HAVE_ANGPOW
-    do_angpow=0;
-#endif //HAVE_ANGPOW
-  
-    //Resort to Limber if we have lensing (this will hopefully only be temporary)
-    if(clt1->tracer_type==ccl_weak_lensing_tracer || clt2->tracer_type==ccl_weak_lensing_tracer ||
-       clt1->has_magnification || clt2->has_magnification) {
-      do_angpow=0;
-    }
+  }
+  else
+    ccl_spline_free(e->spl);
 
-    //Use angpow if non-limber is needed
-    if(do_angpow)
-      ccl_angular_cls_angpow(cosmo,w,clt1,clt2,cl_nodes,status);
+  e->spl=ccl_spline_init(w->n_ls,w->l_nodes,w->cl_nodes,0,0);
+  if(e->spl==NULL) {
+    //Drop the entry
+    *e=cache->entries[--cache->n_entries];
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_cached(); memory allocation\n");
     ccl_check_status(cosmo,status);
+    return;
   }
+  e->id1=clt1->id;
+  e->id2=clt2->id;
+  e->lmax=w->lmax;
+  e->l_limber=w->l_limber;
+  e->l_logstep=w->l_logstep;
+  e->l_linstep=w->l_linstep;
+  e->limber_method=w->limber_method;
+  e->nonlimber_method=w->nonlimber_method;
+  e->l_tol=w->l_tol;
+  e->last_used=cache->n_calls;
+}
+
+//Sets up a fixed-node Limber quadrature in a workspace for a set of tracers, replacing the one
+//stored by ccl_angular_cls for a pair of tracers, together with the per-thread scratch space
+//used by angular_cls_multi_ells.
+static void cl_workspace_multi_quadrature(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+					  int n_tracers,CCL_ClTracer **clts,int *status)
+{
+  int n_panels,n_chi;
+  double chi_lo,chi_hi;
+
+  limber_chi_range(n_tracers,clts,1,&chi_lo,&chi_hi);
+  n_panels=limber_chi_npanels(n_tracers,clts,chi_lo,chi_hi);
+  n_chi=n_panels*CCL_LIMBER_NGL;
+  cl_workspace_alloc_quadrature(cosmo,w,CCL_MAX(n_chi,1),status);
+  if(*status==0)
+    cl_workspace_alloc_scratch(cosmo,w,(n_tracers+2)*CCL_MAX(n_chi,1),status);
+  if(*status)
+    return;
+
+  //An empty range (e.g. two non-overlapping redshift bins) yields no nodes
+  w->pw_cosmo=NULL;
+  w->n_chi=n_chi;
+  limber_chi_nodes(n_tracers,clts,chi_lo,chi_hi,n_panels,w->tgl,w->chi,w->wchi);
+  limber_scale_factors(cosmo,n_chi,w->chi,w->achi,status);
+}
+
+//Params for angular_cls_multi_ells
+typedef struct {
+  CCL_ClWorkspace *w;
+  int n_tracers;
+  CCL_ClTracer **clts;
+} ClMultiPar;
+
+//Compute the Limber power spectra between all pairs of a set of tracers at arbitrary
+//multipoles using the quadrature set up by cl_workspace_multi_quadrature. Multipoles
+//are distributed among threads.
+//cosmo -> ccl_cosmology object
+//n_l, l -> multipoles
+//cl -> output power spectra. C_ell between tracers i and j at l[k] is stored in cl[(i*n_tracers+j)*n_l+k]
+//params -> ClMultiPar
+static void angular_cls_multi_ells(ccl_cosmology *cosmo,int n_l,int *l_arr,double *cl_arr,
+				   void *params,int *status)
+{
+  ClMultiPar *p=(ClMultiPar *)params;
+  CCL_ClWorkspace *w=p->w;
+  int n_tracers=p->n_tracers,n_chi=w->n_chi;
+  CCL_ClTracer **clts=p->clts;
+  double *chi=w->chi,*wchi=w->wchi,*achi=w->achi;
+
+#pragma omp parallel default(none) \
+                     shared(cosmo,n_l,l_arr,cl_arr,w,n_tracers,clts,n_chi,chi,wchi,achi,status)
+  {
+    int il,it1,it2,ic,status_this=0;
+    double *pw,*u,*tr;
+
+    //Per-thread space set up by cl_workspace_multi_quadrature
+#ifdef _OPENMP
+    pw=&(w->scratch[omp_get_thread_num()*w->n_scratch]);
+#else //_OPENMP
+    pw=w->scratch;
+#endif //_OPENMP
+    u=&(pw[n_chi]);
+    tr=&(pw[2*n_chi]);
+
+#pragma omp for schedule(dynamic)
+    for(il=0;il<n_l;il++) {
+      int l=l_arr[il];
+      if(status_this)
+	continue;
+
+      //P(k,a) along the Limber path, shared by all pairs
+      limber_power_weights(cosmo,l,n_chi,chi,wchi,achi,pw,&status_this);
+
+      //Transfer functions of all tracers
+      for(it1=0;it1<n_tracers;it1++) {
+	double *tr1=&(tr[it1*n_chi]);
+	for(ic=0;ic<n_chi;ic++) {
+	  if(pw[ic]==0)
+	    tr1[ic]=0;
+	  else
+	    tr1[ic]=transfer_limber(l,(l+0.5)/chi[ic],clts[it1]);
+	}
+      }
+
+      //All the power spectra as inner products over the chi nodes
+      for(it1=0;it1<n_tracers;it1++) {
+	double *tr1=&(tr[it1*n_chi]);
+#pragma omp simd
+	for(ic=0;ic<n_chi;ic++)
+	  u[ic]=pw[ic]*tr1[ic];
+
+	for(it2=it1;it2<n_tracers;it2++) {
+	  double *tr2=&(tr[it2*n_chi]);
+	  double cl=0;
+#pragma omp simd reduction(+:cl)
+	  for(ic=0;ic<n_chi;ic++)
+	    cl+=u[ic]*tr2[ic];
+	  cl_arr[(it1*n_tracers+it2)*n_l+il]=cl;
+	  cl_arr[(it2*n_tracers+it1)*n_l+il]=cl;
+	}
+      }
+    } //end omp for
+
+    if(status_this) {
+#pragma omp critical
+      {
+	*status=status_this;
+      }
+    }
+  } //end omp parallel
+}
+
+void ccl_angular_cls_multi(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+			   int n_tracers,CCL_ClTracer **clts,
+			   int nl_out,int *l_out,double *cl_out,int *status)
+{
+  int ii;
+  ClMultiPar par={w,n_tracers,clts};
+
+  //First check if ell range is within workspace
+  for(ii=0;ii<nl_out;ii++) {
+    if(l_out[ii]>w->lmax) {
+      *status=CCL_ERROR_SPLINE_EV;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_multi(); "
+				       "requested l beyond range allowed by workspace\n");
+      return;
+    }
+  }
+
+  cls_compute_splines(cosmo,status);
+
+  //Space for all the power spectra at the nodes, and quadrature nodes shared by all
+  //tracers and multipoles
+  if(*status==0)
+    cl_workspace_alloc_spectra(cosmo,w,n_tracers*n_tracers,status);
+  if(*status==0)
+    cl_workspace_multi_quadrature(cosmo,w,n_tracers,clts,status);
 
   if(*status==0) {
-    //Compute limber nodes
-    for(ii=0;ii<w->n_ls;ii++) {
-      if((!do_angpow) || (w->l_arr[ii]>w->l_limber))
-	cl_nodes[ii]=ccl_angular_cl_native(cosmo,w,ii,clt1,clt2,status);
+    angular_cls_multi_ells(cosmo,w->n_ls,w->l_arr,w->cl_nodes,&par,status);
+    if(*status) {
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_multi(); "
+				       "error computing power spectra at interpolation nodes\n");
     }
+  }
 
-    //Interpolate into ells requested by user
-    spcl_nodes=ccl_spline_init(w->n_ls,l_nodes,cl_nodes,0,0);
-    if(spcl_nodes==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_angular_cls(); memory allocation\n");
+  if((*status==0) && (w->l_tol>0)) {
+    //Add nodes where the interpolation of any of the power spectra isn't accurate enough
+    cl_workspace_refine_nodes(cosmo,w,n_tracers*n_tracers,0,angular_cls_multi_ells,&par,status);
+  }
+
+  if(*status==0) {
+    //Interpolate into ells requested by user. The spline owned by the workspace is reused.
+    int it1,it2;
+    for(it1=0;it1<n_tracers;it1++) {
+      for(it2=it1;it2<n_tracers;it2++) {
+	double *cl_12=&(cl_out[(it1*n_tracers+it2)*nl_out]);
+	double *cl_21=&(cl_out[(it2*n_tracers+it1)*nl_out]);
+	if(gsl_spline_init(w->spl_nodes->spline,w->l_nodes,
+			   &(w->cl_nodes[(it1*n_tracers+it2)*w->n_ls]),w->n_ls)) {
+	  *status=CCL_ERROR_SPLINE;
+	  ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_multi(); "
+					   "error initializing spline for power spectrum nodes\n");
+	  break;
+	}
+	for(ii=0;ii<nl_out;ii++) {
+	  cl_12[ii]=ccl_spline_eval((double)(l_out[ii]),w->spl_nodes);
+	  cl_21[ii]=cl_12[ii];
+	}
+      }
+      if(*status)
+	break;
     }
   }
-  
+
+  ccl_check_status(cosmo,status);
+}
+
+//Number of nuisance parameters (see CCL_ClTemplates) a tracer depends on
+static int clt_n_nuisance(CCL_ClTracer *clt)
+{
+  int n_par=0;
+
+  if(clt->tracer_type==ccl_number_counts_tracer) {
+    n_par+=(int)(clt->spl_bz->spline->size);
+    if(clt->has_magnification)
+      n_par+=(int)(clt->spl_sz->spline->size);
+  }
+  else if((clt->tracer_type==ccl_weak_lensing_tracer) && (clt->has_intrinsic_alignment))
+    n_par+=(int)(clt->spl_ba->spline->size);
+
+  return n_par;
+}
+
+//Copy of a tracer where all nuisance parameters are set to zero except for the
+//i_par-th one, which is set to 1 (all of them are zero if i_par<0).
+//The redshift distribution and all other functions are the same as in clt.
+static CCL_ClTracer *clt_nuisance_basis(ccl_cosmology *cosmo,CCL_ClTracer *clt,int i_par,int *status)
+{
+  int ii,n_par=clt_n_nuisance(clt);
+  double *par=NULL;
+  CCL_ClTracer *clt_out=NULL;
+  gsl_spline *nz=clt->spl_nz->spline;
+
+  par=(double *)malloc((n_par+1)*sizeof(double));
+  if(par==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_nuisance_basis(): memory allocation\n");
+    return NULL;
+  }
+  for(ii=0;ii<n_par;ii++)
+    par[ii]=0;
+  if(i_par>=0)
+    par[i_par]=1;
+
+  if(clt->tracer_type==ccl_number_counts_tracer) {
+    gsl_spline *bz=clt->spl_bz->spline;
+    gsl_spline *sz=NULL;
+    int nz_s=-1;
+    if(clt->has_magnification) {
+      sz=clt->spl_sz->spline;
+      nz_s=(int)(sz->size);
+    }
+    clt_out=cl_tracer(cosmo,ccl_number_counts_tracer,clt->has_rsd,clt->has_magnification,0,
+		      (int)(nz->size),nz->x,nz->y,
+		      (int)(bz->size),bz->x,par,
+		      nz_s,(sz==NULL) ? NULL : sz->x,&(par[bz->size]),
+		      -1,NULL,NULL,-1,NULL,NULL,0,status);
+  }
+  else if(clt->tracer_type==ccl_weak_lensing_tracer) {
+    gsl_spline *ba=NULL,*rf=NULL;
+    int nz_ba=-1,nz_rf=-1;
+    if(clt->has_intrinsic_alignment) {
+      ba=clt->spl_ba->spline;
+      rf=clt->spl_rf->spline;
+      nz_ba=(int)(ba->size);
+      nz_rf=(int)(rf->size);
+    }
+    clt_out=cl_tracer(cosmo,ccl_weak_lensing_tracer,0,0,clt->has_intrinsic_alignment,
+		      (int)(nz->size),nz->x,nz->y,
+		      -1,NULL,NULL,-1,NULL,NULL,
+		      nz_ba,(ba==NULL) ? NULL : ba->x,par,
+		      nz_rf,(rf==NULL) ? NULL : rf->x,(rf==NULL) ? NULL : rf->y,0,status);
+  }
+  else {
+    *status=CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: clt_nuisance_basis(): tracer has no nuisance parameters\n");
+  }
+
+  free(par);
+  return clt_out;
+}
+
+CCL_ClTemplates *ccl_cl_templates_new(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+				      CCL_ClTracer *clt1,CCL_ClTracer *clt2,
+				      int nl_out,int *l_out,int *status)
+{
+  int ia,ib,il,it,n_basis1,n_basis2,n_basis;
+  double *cl_basis=NULL;
+  CCL_ClTracer **basis=NULL;
+  CCL_ClTemplates *t=NULL;
+  int same=(clt1==clt2);
+
+  //The power spectrum is bilinear in the nuisance parameters of both tracers, so it is fully
+  //determined by the spectra between tracers with all parameters set to zero (basis element 0)
+  //and tracers with a single parameter set to one (basis element i+1).
+  n_basis1=clt_n_nuisance(clt1)+1;
+  n_basis2=clt_n_nuisance(clt2)+1;
+  n_basis=same ? n_basis1 : n_basis1+n_basis2;
+
+  t=(CCL_ClTemplates *)malloc(sizeof(CCL_ClTemplates));
+  basis=(CCL_ClTracer **)malloc(n_basis*sizeof(CCL_ClTracer *));
+  if((t==NULL) || (basis==NULL)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_templates_new(): memory allocation\n");
+    free(t);
+    free(basis);
+    return NULL;
+  }
+  t->n_par1=n_basis1-1;
+  t->n_par2=n_basis2-1;
+  t->nl=nl_out;
+  t->l=(int *)malloc(nl_out*sizeof(int));
+  t->cl=(double *)malloc(n_basis1*n_basis2*nl_out*sizeof(double));
+  cl_basis=(double *)malloc(n_basis1*n_basis2*nl_out*sizeof(double));
+  if((t->l==NULL) || (t->cl==NULL) || (cl_basis==NULL)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_templates_new(): memory allocation\n");
+  }
+
+  //Tracers without nuisance parameters are their own basis
+  for(it=0;it<n_basis;it++) {
+    CCL_ClTracer *clt=(it<n_basis1) ? clt1 : clt2;
+    int i_par=(it<n_basis1) ? it-1 : it-n_basis1-1;
+    basis[it]=NULL;
+    if(*status==0) {
+      if(clt_n_nuisance(clt)==0)
+	basis[it]=clt;
+      else
+	basis[it]=clt_nuisance_basis(cosmo,clt,i_par,status);
+    }
+  }
+
   if(*status==0) {
-    for(ii=0;ii<nl_out;ii++)
-      cl_out[ii]=ccl_spline_eval((double)(l_out[ii]),spcl_nodes);
+    int i_off2=same ? 0 : n_basis1;
+
+    for(il=0;il<nl_out;il++)
+      t->l[il]=l_out[il];
+
+    if(w->l_limber<=0) {
+      //All spectra in one go
+      double *cl_all=(double *)malloc(n_basis*n_basis*nl_out*sizeof(double));
+      if(cl_all==NULL) {
+	*status=CCL_ERROR_MEMORY;
+	ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_cl_templates_new(): memory allocation\n");
+      }
+      else {
+	ccl_angular_cls_multi(cosmo,w,n_basis,basis,nl_out,l_out,cl_all,status);
+	for(ia=0;ia<n_basis1;ia++) {
+	  for(ib=0;ib<n_basis2;ib++) {
+	    for(il=0;il<nl_out;il++)
+	      cl_basis[(ia*n_basis2+ib)*nl_out+il]=cl_all[(ia*n_basis+i_off2+ib)*nl_out+il];
+	  }
+	}
+	free(cl_all);
+      }
+    }
+    else {
+      for(ia=0;ia<n_basis1;ia++) {
+	for(ib=0;ib<n_basis2;ib++) {
+	  if(*status==0)
+	    ccl_angular_cls(cosmo,w,basis[ia],basis[i_off2+ib],nl_out,l_out,
+			    &(cl_basis[(ia*n_basis2+ib)*nl_out]),status);
+	}
+      }
+    }
   }
-  
-  //Cleanup
-  ccl_spline_free(spcl_nodes);
-  free(cl_nodes);
-  free(l_nodes);
+
+  if(*status==0) {
+    //Turn the basis spectra into the coefficients of the bilinear form
+    for(ia=0;ia<n_basis1;ia++) {
+      for(ib=0;ib<n_basis2;ib++) {
+	for(il=0;il<nl_out;il++) {
+	  double c=cl_basis[(ia*n_basis2+ib)*nl_out+il];
+	  if(ia>0)
+	    c-=cl_basis[ib*nl_out+il];
+	  if(ib>0)
+	    c-=cl_basis[ia*n_basis2*nl_out+il];
+	  if((ia>0) && (ib>0))
+	    c+=cl_basis[il];
+	  t->cl[(ia*n_basis2+ib)*nl_out+il]=c;
+	}
+      }
+    }
+  }
+
+  for(it=0;it<n_basis;it++) {
+    if((basis[it]!=NULL) && (basis[it]!=clt1) && (basis[it]!=clt2))
+      ccl_cl_tracer_free(basis[it]);
+  }
+  free(basis);
+  free(cl_basis);
+
+  if(*status) {
+    ccl_cl_templates_free(t);
+    t=NULL;
+  }
+  ccl_check_status(cosmo,status);
+  return t;
+}
+
+void ccl_cl_templates_eval(CCL_ClTemplates *t,double *p1,double *p2,double *cl_out)
+{
+  int ia,ib,il;
+
+  for(il=0;il<t->nl;il++)
+    cl_out[il]=0;
+
+  for(ia=0;ia<=t->n_par1;ia++) {
+    double pa=(ia==0) ? 1 : p1[ia-1];
+    for(ib=0;ib<=t->n_par2;ib++) {
+      double pab=pa*((ib==0) ? 1 : p2[ib-1]);
+      double *cl=&(t->cl[(ia*(t->n_par2+1)+ib)*t->nl]);
+      if(pab==0)
+	continue;
+      for(il=0;il<t->nl;il++)
+	cl_out[il]+=pab*cl[il];
+    }
+  }
+}
+
+void ccl_cl_templates_free(CCL_ClTemplates *t)
+{
+  if(t!=NULL) {
+    free(t->l);
+    free(t->cl);
+    free(t);
+  }
+}
+
+void ccl_angular_cls_gaussian_covariance(ccl_cosmology *cosmo,CCL_ClWorkspace *w,
+					 int n_tracers,CCL_ClTracer **clts,double *noise,
+					 double fsky,int n_bins,int *l_edges,
+					 double *cl_binned,double *cov,int *status)
+{
+  int ib,ii,it1,it2,nl,lmin;
+  int n_pairs=n_tracers*(n_tracers+1)/2;
+  int *l_all=NULL,*pair_1=NULL,*pair_2=NULL;
+  double *cl_all=NULL;
+
+  if((fsky<=0) || (fsky>1) || (n_bins<=0) || (l_edges[0]<0)) {
+    *status=CCL_ERROR_INCONSISTENT;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_gaussian_covariance(); "
+				     "fsky must be in (0,1] and ell bins must be non-empty\n");
+    return;
+  }
+  for(ib=0;ib<n_bins;ib++) {
+    if(l_edges[ib+1]<=l_edges[ib]) {
+      *status=CCL_ERROR_INCONSISTENT;
+      ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_gaussian_covariance(); "
+				       "ell bin edges must be strictly increasing\n");
+      return;
+    }
+  }
+
+  //Power spectra at all multipoles spanned by the bins
+  lmin=l_edges[0];
+  nl=l_edges[n_bins]-lmin;
+  l_all=(int *)malloc(nl*sizeof(int));
+  cl_all=(double *)malloc(n_tracers*n_tracers*nl*sizeof(double));
+  pair_1=(int *)malloc(n_pairs*sizeof(int));
+  pair_2=(int *)malloc(n_pairs*sizeof(int));
+  if((l_all==NULL) || (cl_all==NULL) || (pair_1==NULL) || (pair_2==NULL)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_cls.c: ccl_angular_cls_gaussian_covariance(); "
+				     "memory allocation\n");
+  }
+
+  if(*status==0) {
+    for(ii=0;ii<nl;ii++)
+      l_all[ii]=lmin+ii;
+
+    ii=0;
+    for(it1=0;it1<n_tracers;it1++) {
+      for(it2=it1;it2<n_tracers;it2++) {
+	pair_1[ii]=it1;
+	pair_2[ii]=it2;
+	ii++;
+      }
+    }
+
+    if(w->l_limber<=0)
+      ccl_angular_cls_multi(cosmo,w,n_tracers,clts,nl,l_all,cl_all,status);
+    else {
+      for(it1=0;it1<n_tracers;it1++) {
+	for(it2=it1;it2<n_tracers;it2++) {
+	  if(*status==0) {
+	    ccl_angular_cls(cosmo,w,clts[it1],clts[it2],nl,l_all,
+			    &(cl_all[(it1*n_tracers+it2)*nl]),status);
+	    if(it2!=it1)
+	      memcpy(&(cl_all[(it2*n_tracers+it1)*nl]),&(cl_all[(it1*n_tracers+it2)*nl]),nl*sizeof(double));
+	  }
+	}
+      }
+    }
+  }
+
+  if((*status==0) && (cl_binned!=NULL)) {
+    //Bandpowers, weighted by the number of modes (2l+1) in each multipole
+    for(ib=0;ib<n_bins;ib++) {
+      int l;
+      double nmodes=0;
+      for(l=l_edges[ib];l<l_edges[ib+1];l++)
+	nmodes+=2*l+1;
+      for(ii=0;ii<n_pairs;ii++) {
+	double *cl=&(cl_all[(pair_1[ii]*n_tracers+pair_2[ii])*nl]);
+	double cb=0;
+	for(l=l_edges[ib];l<l_edges[ib+1];l++)
+	  cb+=(2*l+1)*cl[l-lmin];
+	cl_binned[ii*n_bins+ib]=cb/nmodes;
+      }
+    }
+  }
+
+  if(*status==0) {
+    //Add noise to the power spectra entering the covariance
+    if(noise!=NULL) {
+      for(it1=0;it1<n_tracers;it1++) {
+	for(it2=0;it2<n_tracers;it2++) {
+	  double nl_12=noise[it1*n_tracers+it2];
+	  double *cl=&(cl_all[(it1*n_tracers+it2)*nl]);
+	  for(ii=0;ii<nl;ii++)
+	    cl[ii]+=nl_12;
+	}
+      }
+    }
+
+    //The Gaussian covariance doesn't couple different bins, so each bin is an independent
+    //n_pairs x n_pairs block:
+    //Cov_b[(ij),(mn)] = sum_{l in b} (2l+1) (C_im C_jn + C_in C_jm) / (fsky (sum_{l in b} (2l+1))^2)
+#pragma omp parallel for default(none) schedule(dynamic) \
+                         shared(n_bins,l_edges,n_pairs,pair_1,pair_2,n_tracers,nl,lmin,cl_all,fsky,cov)
+    for(ib=0;ib<n_bins;ib++) {
+      int l,ip,iq;
+      double nmodes=0;
+      double *cov_b=&(cov[ib*n_pairs*n_pairs]);
+      for(l=l_edges[ib];l<l_edges[ib+1];l++)
+	nmodes+=2*l+1;
+
+      for(ip=0;ip<n_pairs;ip++) {
+	int i=pair_1[ip],j=pair_2[ip];
+	for(iq=ip;iq<n_pairs;iq++) {
+	  int m=pair_1[iq],n=pair_2[iq];
+	  double *cl_im=&(cl_all[(i*n_tracers+m)*nl]);
+	  double *cl_jn=&(cl_all[(j*n_tracers+n)*nl]);
+	  double *cl_in=&(cl_all[(i*n_tracers+n)*nl]);
+	  double *cl_jm=&(cl_all[(j*n_tracers+m)*nl]);
+	  double c=0;
+	  for(l=l_edges[ib];l<l_edges[ib+1];l++)
+	    c+=(2*l+1)*(cl_im[l-lmin]*cl_jn[l-lmin]+cl_in[l-lmin]*cl_jm[l-lmin]);
+	  c/=fsky*nmodes*nmodes;
+	  cov_b[ip*n_pairs+iq]=c;
+	  cov_b[iq*n_pairs+ip]=c;
+	}
+      }
+    } //end omp parallel for
+  }
+
+  free(l_all);
+  free(cl_all);
+  free(pair_1);
+  free(pair_2);
+  ccl_check_status(cosmo,status);
 }
 
 static int check_clt_fa_inconsistency(CCL_ClTracer *clt,int func_code)
@@ -11,6 +11,7 @@
 
 #include "ccl.h"
 #include "ccl_params.h"
+#include "fftlog.h"
 
 //
 // Macros for replacing relative paths
@@ -74,7 +75,8 @@ void ccl_cosmology_read_config(void)
   }
 
   if(ccl_splines == NULL) {
-    ccl_splines = malloc(sizeof(ccl_spline_params));
+    // Parameters missing from the file are zero
+    ccl_splines = calloc(1, sizeof(ccl_spline_params));
   }
   if(ccl_gsl == NULL) {
     ccl_gsl = malloc(sizeof(ccl_gsl_params));
@@ -121,6 +123,9 @@ void ccl_cosmology_read_config(void)
 
       // 3dcorr parameters
       MATCH("N_K_3DCOR", ccl_splines->N_K_3DCOR=(int) var_dbl);
+      MATCH("N_K_3DCOR_LEAN", ccl_splines->N_K_3DCOR_LEAN=(int) var_dbl);
+      MATCH("K_EXTRAP_3DCOR", ccl_splines->K_EXTRAP_3DCOR=var_dbl);
+      MATCH("ZEROPAD_3DCOR", ccl_splines->ZEROPAD_3DCOR=var_dbl);
 
       // Angular correlation function params
       MATCH("ELL_MIN_CORR",ccl_splines->ELL_MIN_CORR=(double) var_dbl);
@@ -200,6 +205,8 @@ ccl_cosmology * ccl_cosmology_create(ccl_parameters params, ccl_configuration co
 
   cosmo->data.p_lin = NULL;
   cosmo->data.p_nl = NULL;
+  cosmo->data.xir = NULL;
+  cosmo->data.dist_table = NULL;
   //cosmo->data.nu_pspace_int = NULL;
   cosmo->computed_distances = false;
   cosmo->computed_growth = false;
@@ -821,6 +828,68 @@ void ccl_parameters_free(ccl_parameters * params)
   }
 }
 
+/* ------- ROUTINE: ccl_parameters_equal --------
+INPUT: two ccl_parameters structs
+TASK: return 1 if all their parameters (including neutrino masses and modified
+growth arrays) have the same values, 0 otherwise. Padding bytes are not compared.
+*/
+int ccl_parameters_equal(const ccl_parameters *p1, const ccl_parameters *p2)
+{
+  int i;
+
+  if ((p1->Omega_c != p2->Omega_c) || (p1->Omega_b != p2->Omega_b) ||
+      (p1->Omega_m != p2->Omega_m) || (p1->Omega_k != p2->Omega_k) ||
+      (p1->sqrtk != p2->sqrtk) || (p1->k_sign != p2->k_sign) ||
+      (p1->w0 != p2->w0) || (p1->wa != p2->wa) ||
+      (p1->H0 != p2->H0) || (p1->h != p2->h) ||
+      (p1->Neff != p2->Neff) || (p1->N_nu_mass != p2->N_nu_mass) ||
+      (p1->N_nu_rel != p2->N_nu_rel) || (p1->sum_nu_masses != p2->sum_nu_masses) ||
+      (p1->Omega_n_mass != p2->Omega_n_mass) || (p1->Omega_n_rel != p2->Omega_n_rel) ||
+      (p1->n_s != p2->n_s) || (p1->Omega_g != p2->Omega_g) || (p1->T_CMB != p2->T_CMB) ||
+      (p1->bcm_log10Mc != p2->bcm_log10Mc) || (p1->bcm_etab != p2->bcm_etab) ||
+      (p1->bcm_ks != p2->bcm_ks) || (p1->Omega_l != p2->Omega_l) ||
+      (p1->has_mgrowth != p2->has_mgrowth) || (p1->nz_mgrowth != p2->nz_mgrowth))
+    return 0;
+
+  // A_s, sigma8 and z_star may be NaN when not set
+  if (!((p1->A_s == p2->A_s) || (isnan(p1->A_s) && isnan(p2->A_s))) ||
+      !((p1->sigma8 == p2->sigma8) || (isnan(p1->sigma8) && isnan(p2->sigma8))) ||
+      !((p1->z_star == p2->z_star) || (isnan(p1->z_star) && isnan(p2->z_star))))
+    return 0;
+
+  if (p1->mnu != p2->mnu) {
+    if ((p1->mnu == NULL) || (p2->mnu == NULL))
+      return 0;
+    for (i = 0; i < p1->N_nu_mass; i++) {
+      if (p1->mnu[i] != p2->mnu[i])
+        return 0;
+    }
+  }
+
+  if (p1->has_mgrowth) {
+    for (i = 0; i < p1->nz_mgrowth; i++) {
+      if ((p1->z_mgrowth[i] != p2->z_mgrowth[i]) || (p1->df_mgrowth[i] != p2->df_mgrowth[i]))
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* ------- ROUTINE: ccl_configuration_equal --------
+INPUT: two ccl_configuration structs
+TASK: return 1 if they select the same methods, 0 otherwise
+*/
+int ccl_configuration_equal(const ccl_configuration *c1, const ccl_configuration *c2)
+{
+  return (c1->transfer_function_method == c2->transfer_function_method) &&
+    (c1->matter_power_spectrum_method == c2->matter_power_spectrum_method) &&
+    (c1->baryons_power_spectrum_method == c2->baryons_power_spectrum_method) &&
+    (c1->mass_function_method == c2->mass_function_method) &&
+    (c1->halo_concentration_method == c2->halo_concentration_method) &&
+    (c1->emulator_neutrinos_method == c2->emulator_neutrinos_method);
+}
+
 
 /* ------- ROUTINE: ccl_cosmology_free --------
 INPUT: ccl_cosmology struct
@@ -828,6 +897,10 @@ TASK: free the input data and the cosmology struct
 */
 void ccl_cosmology_free(ccl_cosmology * cosmo)
 {
+  ccl_correlation_multipole_spline_free(cosmo);
+  ccl_cosmology_distance_table_free(cosmo);
+  //FFTLog plans can be large (e.g. for the dense 3D correlation), so release them with the cosmology
+  fftlog_plan_cache_clear_all();
   ccl_data_free(&cosmo->data);
   free(cosmo);
 }
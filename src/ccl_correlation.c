@@ -10,13 +10,36 @@
 #include <gsl/gsl_sf_bessel.h>
 #include <gsl/gsl_sf_legendre.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "fftlog.h"
 
 #include "ccl.h"
 #include "ccl_params.h"
 
-// Global variable to hold the redshift space correlation multipole function spline
-SplPar* xir_spline[3]={NULL,NULL,NULL};
+// Splines of the multipoles of the redshift-space correlation function at a given scale factor.
+// Entries are reference-counted, so that one can be evicted from the cache while other threads
+// are still using it. It is then freed by the last one of them.
+typedef struct {
+  double a;
+  SplPar *spl[3]; //l=0,2,4
+  int n_users;
+  int in_cache;
+  unsigned long last_used;
+} xir_entry;
+
+// The entries are only valid for the cosmological parameters and the 3D correlation
+// settings of ccl_splines they were computed with. They are flushed when these change.
+struct ccl_xir_cache {
+  int n_entries;
+  xir_entry *entries[CCL_CORR_XIR_CACHE_SIZE];
+  unsigned long n_calls;
+  ccl_parameters params;
+  ccl_configuration config;
+  ccl_spline_params splines;
+};
 
 /*--------ROUTINE: taper_cl ------
 TASK:n Apply cosine tapering to Cls to reduce aliasing
@@ -44,6 +67,83 @@ static int taper_cl(int n_ell,double *ell,double *cl, double *ell_limits)
   return 0;
 }
 
+/*--------ROUTINE: corr_bessel_order ------
+TASK: Order of the Bessel function J_n used in the flat-sky transform of each correlation type.
+      Returns -1 for unknown types.
+ */
+static int corr_bessel_order(int corr_type)
+{
+  switch(corr_type) {
+  case CCL_CORR_GG :
+    return 0;
+  case CCL_CORR_GL :
+    return 2;
+  case CCL_CORR_LP :
+    return 0;
+  case CCL_CORR_LM :
+    return 4;
+  default :
+    return -1;
+  }
+}
+
+/*--------ROUTINE: corr_fftlog_cl_grid ------
+TASK: Interpolate the input Cl onto the logarithmic grid l_arr used by FFTLog, extrapolating
+      as a power law beyond the last multipole, and apply the tapering if needed.
+      Returns 1 if out of memory.
+INPUT: number of ell bins for Cl, ell vector, C_ell vector, FFTLog grid,
+       key for tapering, limits for tapering
+OUTPUT: cl_arr, with ccl_splines->N_ELL_CORR elements
+ */
+static int corr_fftlog_cl_grid(int n_ell,double *ell,double *cls,double *l_arr,double *cl_arr,
+			       int do_taper_cl,double *taper_cl_limits)
+{
+  int i;
+  double cl_tilt,l_edge,cl_edge;
+  SplPar *cl_spl=ccl_spline_init(n_ell,ell,cls,cls[0],0);
+  if(cl_spl==NULL)
+    return 1;
+
+  l_edge=ell[n_ell-1];
+  if((cls[n_ell-1]*cls[n_ell-2]<0) || (cls[n_ell-2]==0)) {
+    cl_tilt=0;
+    cl_edge=0;
+  }
+  else {
+    cl_tilt=log(cls[n_ell-1]/cls[n_ell-2])/log(ell[n_ell-1]/ell[n_ell-2]);
+    cl_edge=cls[n_ell-1];
+  }
+  for(i=0;i<ccl_splines->N_ELL_CORR;i++) {
+    if(l_arr[i]>=l_edge)
+      cl_arr[i]=cl_edge*pow(l_arr[i]/l_edge,cl_tilt);
+    else
+      cl_arr[i]=ccl_spline_eval(l_arr[i],cl_spl);
+  }
+  ccl_spline_free(cl_spl);
+
+  if (do_taper_cl)
+    taper_cl(ccl_splines->N_ELL_CORR,l_arr,cl_arr,taper_cl_limits);
+
+  return 0;
+}
+
+/*--------ROUTINE: corr_fftlog_interpolate ------
+TASK: Interpolate a correlation function computed by FFTLog at th_arr (in radians)
+      to the output values of theta (in degrees). Returns 1 if out of memory.
+ */
+static int corr_fftlog_interpolate(double *th_arr,double *wth_arr,int n_theta,double *theta,double *wtheta)
+{
+  int i;
+  SplPar *wth_spl=ccl_spline_init(ccl_splines->N_ELL_CORR,th_arr,wth_arr,wth_arr[0],0);
+  if(wth_spl==NULL)
+    return 1;
+  for(i=0;i<n_theta;i++)
+    wtheta[i]=ccl_spline_eval(theta[i]*M_PI/180.,wth_spl);
+  ccl_spline_free(wth_spl);
+
+  return 0;
+}
+
 /*--------ROUTINE: ccl_tracer_corr_fftlog ------
 TASK: For a given tracer, get the correlation function
       Following function takes a function to calculate angular cl as well.
@@ -74,8 +174,7 @@ static void ccl_tracer_corr_fftlog(ccl_cosmology *cosmo,
   }
 
   //Interpolate input Cl into array needed for FFTLog
-  SplPar *cl_spl=ccl_spline_init(n_ell,ell,cls,cls[0],0);
-  if(cl_spl==NULL) {
+  if(corr_fftlog_cl_grid(n_ell,ell,cls,l_arr,cl_arr,do_taper_cl,taper_cl_limits)) {
     free(l_arr);
     free(cl_arr);
     *status=CCL_ERROR_MEMORY;
@@ -83,27 +182,6 @@ static void ccl_tracer_corr_fftlog(ccl_cosmology *cosmo,
     return;
   }
 
-  double cl_tilt,l_edge,cl_edge;
-  l_edge=ell[n_ell-1];
-  if((cls[n_ell-1]*cls[n_ell-2]<0) || (cls[n_ell-2]==0)) {
-    cl_tilt=0;
-    cl_edge=0;
-  }
-  else {
-    cl_tilt=log(cls[n_ell-1]/cls[n_ell-2])/log(ell[n_ell-1]/ell[n_ell-2]);
-    cl_edge=cls[n_ell-1];
-  }
-  for(i=0;i<ccl_splines->N_ELL_CORR;i++) {
-    if(l_arr[i]>=l_edge)
-      cl_arr[i]=cl_edge*pow(l_arr[i]/l_edge,cl_tilt);
-    else
-      cl_arr[i]=ccl_spline_eval(l_arr[i],cl_spl);
-  }
-  ccl_spline_free(cl_spl);
-
-  if (do_taper_cl)
-    taper_cl(ccl_splines->N_ELL_CORR,l_arr,cl_arr,taper_cl_limits);
-
   th_arr=malloc(sizeof(double)*ccl_splines->N_ELL_CORR);
   if(th_arr==NULL) {
     free(l_arr);
@@ -124,18 +202,17 @@ static void ccl_tracer_corr_fftlog(ccl_cosmology *cosmo,
     th_arr[i]=0;
   //Although set here to 0, theta is modified by FFTlog to obtain the correlation at ~1/l
 
-  int i_bessel=0;
-  if(corr_type==CCL_CORR_GG) i_bessel=0;
-  if(corr_type==CCL_CORR_GL) i_bessel=2;
-  if(corr_type==CCL_CORR_LP) i_bessel=0;
-  if(corr_type==CCL_CORR_LM) i_bessel=4;
-  fftlog_ComputeXi2D(i_bessel,ccl_splines->N_ELL_CORR,l_arr,cl_arr,th_arr,wth_arr);
-
+  int i_bessel=corr_bessel_order(corr_type);
+  if(i_bessel<0) i_bessel=0;
+  if(fftlog_ComputeXi2D(i_bessel,ccl_splines->N_ELL_CORR,l_arr,cl_arr,th_arr,wth_arr)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog ran out of memory\n");
+  }
   // Interpolate to output values of theta
-  SplPar *wth_spl=ccl_spline_init(ccl_splines->N_ELL_CORR,th_arr,wth_arr,wth_arr[0],0);
-  for(i=0;i<n_theta;i++)
-    wtheta[i]=ccl_spline_eval(theta[i]*M_PI/180.,wth_spl);
-  ccl_spline_free(wth_spl);
+  else if(corr_fftlog_interpolate(th_arr,wth_arr,n_theta,theta,wtheta)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog ran out of memory\n");
+  }
 
   free(l_arr); free(cl_arr);
   free(th_arr); free(wth_arr);
@@ -143,6 +220,108 @@ static void ccl_tracer_corr_fftlog(ccl_cosmology *cosmo,
   return;
 }
 
+/*--------ROUTINE: ccl_tracer_corr_fftlog_multi ------
+TASK: Same as ccl_tracer_corr_fftlog for n_cls power spectra and n_types correlation types
+      at once. All the spectra are transformed together for each distinct Bessel order,
+      sharing the FFTs of the inputs and the FFTLog coefficients.
+INPUT: number of ell bins, ell vector, n_cls C_ell vectors, theta vector,
+       correlation types, key for tapering, limits for tapering
+OUTPUT: wtheta[(i_type*n_cls+i_cl)*n_theta+i_theta]
+ */
+static void ccl_tracer_corr_fftlog_multi(ccl_cosmology *cosmo,
+					 int n_ell,double *ell,int n_cls,double *cls,
+					 int n_theta,double *theta,
+					 int n_types,int *corr_types,double *wtheta,
+					 int do_taper_cl,double *taper_cl_limits,
+					 int *status)
+{
+  int i,it,n_orders=0;
+  int N=ccl_splines->N_ELL_CORR;
+  double orders[3];
+  int *i_order=NULL;
+  double *l_arr=NULL,*cl_arr=NULL,*th_arr=NULL,*wth_arr=NULL;
+
+  //Distinct Bessel orders needed
+  i_order=malloc(n_types*sizeof(int));
+  if(i_order==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog_multi ran out of memory\n");
+    return;
+  }
+  for(it=0;it<n_types;it++) {
+    int io,order=corr_bessel_order(corr_types[it]);
+    if(order<0) {
+      *status=CCL_ERROR_INCONSISTENT;
+      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_multi. Unknown correlation type\n");
+      free(i_order);
+      return;
+    }
+    for(io=0;io<n_orders;io++) {
+      if(orders[io]==order)
+	break;
+    }
+    if(io==n_orders)
+      orders[n_orders++]=order;
+    i_order[it]=io;
+  }
+
+  l_arr=ccl_log_spacing(ccl_splines->ELL_MIN_CORR,ccl_splines->ELL_MAX_CORR,N);
+  cl_arr=malloc(n_cls*N*sizeof(double));
+  th_arr=malloc(n_orders*N*sizeof(double));
+  wth_arr=malloc(n_orders*n_cls*N*sizeof(double));
+  if((l_arr==NULL) || (cl_arr==NULL) || (th_arr==NULL) || (wth_arr==NULL)) {
+    *status=CCL_ERROR_MEMORY;
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog_multi ran out of memory\n");
+  }
+
+  //Interpolate input Cls into arrays needed for FFTLog
+  if(*status==0) {
+    for(i=0;i<n_cls;i++) {
+      if(corr_fftlog_cl_grid(n_ell,ell,&(cls[i*n_ell]),l_arr,&(cl_arr[i*N]),
+			     do_taper_cl,taper_cl_limits)) {
+	*status=CCL_ERROR_MEMORY;
+	ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog_multi ran out of memory\n");
+	break;
+      }
+    }
+  }
+
+  if(*status==0) {
+    if(fftlog_ComputeXi2D_many(n_orders,orders,n_cls,N,l_arr,cl_arr,th_arr,wth_arr)) {
+      *status=CCL_ERROR_MEMORY;
+      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog_multi ran out of memory\n");
+    }
+  }
+
+  // Interpolate to output values of theta
+  if(*status==0) {
+    for(it=0;it<n_types;it++) {
+      for(i=0;i<n_cls;i++) {
+	if(corr_fftlog_interpolate(&(th_arr[i_order[it]*N]),&(wth_arr[(i_order[it]*n_cls+i)*N]),
+				   n_theta,theta,&(wtheta[(it*n_cls+i)*n_theta]))) {
+	  *status=CCL_ERROR_MEMORY;
+	  ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_fftlog_multi ran out of memory\n");
+	  break;
+	}
+      }
+    }
+  }
+
+  free(i_order);
+  free(l_arr); free(cl_arr);
+  free(th_arr); free(wth_arr);
+}
+
+//Gauss-Legendre points per panel and panel width in u=asinh(pi/r_p)
+//used to integrate xi(pi,r_p) along the line of sight in ccl_correlation_wp
+#define CCL_CORR_WP_NGL 8
+#define CCL_CORR_WP_DU 0.1
+
+//Gauss-Legendre points per panel and number of logarithmic panels per decade in x=l*theta
+//used by the Bessel-zero-segmented quadrature of CCL_CORR_BESSEL
+#define CCL_CORR_BESSEL_NGL 16
+#define CCL_CORR_BESSEL_NLOG 20
+
 typedef struct {
   int nell;
   double ell0;
@@ -155,14 +334,11 @@ typedef struct {
   double tiltf;
   SplPar *cl_spl;
   int i_bessel;
-  double th;
 } corr_int_par;
 
-static double corr_bessel_integrand(double l,void *params)
+static double corr_bessel_cl(double l,corr_int_par *p)
 {
-  double cl,jbes;
-  corr_int_par *p=(corr_int_par *)params;
-  double x=l*p->th;
+  double cl;
 
   if(l<p->ell0) {
     if(p->extrapol_0)
@@ -179,16 +355,143 @@ static double corr_bessel_integrand(double l,void *params)
   else
     cl=ccl_spline_eval(l,p->cl_spl);
 
-  jbes=gsl_sf_bessel_Jn(p->i_bessel,x);
+  return cl;
+}
 
-  return l*jbes*cl;
+//Quadrature of \int dx x J_n(x) f(x), with panels bounded by the zeros of J_n and,
+//where those are far apart compared to x, by a logarithmic grid in x.
+//The nodes and the weights (including x J_n(x)) do not depend on theta.
+typedef struct {
+  int i_bessel;
+  int n_panels;
+  double *x_edge; //n_panels+1 panel edges
+  double *x_q; //CCL_CORR_BESSEL_NGL nodes per panel
+  double *wxj_q; //weight*x*J_n(x) at each node
+  gsl_integration_glfixed_table *tgl;
+} corr_hankel_table;
+
+static void corr_hankel_table_free(corr_hankel_table *ht)
+{
+  if(ht!=NULL) {
+    free(ht->x_edge);
+    free(ht->x_q);
+    free(ht->wxj_q);
+    if(ht->tgl!=NULL)
+      gsl_integration_glfixed_table_free(ht->tgl);
+    free(ht);
+  }
 }
 
+/*--------ROUTINE: corr_hankel_table_new ------
+TASK: Build the panels and Gauss-Legendre nodes for x in [0,x_max], with the first
+      panel covering [0,x_lo]. Returns NULL and sets status if out of memory
+      (CCL_ERROR_MEMORY) or if the panels don't reach x_max (CCL_ERROR_INTEG).
+ */
+static corr_hankel_table *corr_hankel_table_new(int i_bessel,double x_lo,double x_max,int *status)
+{
+  int ip,iz,n_max;
+  double x,x_zero,ratio=pow(10.,1./CCL_CORR_BESSEL_NLOG);
+  corr_hankel_table *ht=malloc(sizeof(corr_hankel_table));
+  if(ht==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  n_max=(int)(x_max/M_PI)+(int)(CCL_CORR_BESSEL_NLOG*log10(x_max/x_lo))+4;
+  ht->i_bessel=i_bessel;
+  ht->x_edge=malloc((n_max+1)*sizeof(double));
+  ht->x_q=malloc(n_max*CCL_CORR_BESSEL_NGL*sizeof(double));
+  ht->wxj_q=malloc(n_max*CCL_CORR_BESSEL_NGL*sizeof(double));
+  ht->tgl=gsl_integration_glfixed_table_alloc(CCL_CORR_BESSEL_NGL);
+  if((ht->x_edge==NULL) || (ht->x_q==NULL) || (ht->wxj_q==NULL) || (ht->tgl==NULL)) {
+    corr_hankel_table_free(ht);
+    *status=CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  //Panel edges: merge the zeros of J_n with the logarithmic grid
+  ht->x_edge[0]=0;
+  ht->x_edge[1]=x_lo;
+  ip=1;
+  x=x_lo;
+  iz=1;
+  x_zero=gsl_sf_bessel_zero_Jnu(i_bessel,iz);
+  while((x<x_max) && (ip<n_max)) {
+    double x_next=x*ratio;
+    while(x_zero<=x) {
+      iz++;
+      x_zero=gsl_sf_bessel_zero_Jnu(i_bessel,iz);
+    }
+    if(x_zero<x_next)
+      x_next=x_zero;
+    x=fmin(x_next,x_max);
+    ip++;
+    ht->x_edge[ip]=x;
+  }
+  ht->n_panels=ip;
+  //The integral would be silently truncated otherwise
+  if(x<x_max) {
+    corr_hankel_table_free(ht);
+    *status=CCL_ERROR_INTEG;
+    return NULL;
+  }
+
+#pragma omp parallel for default(none) shared(ht,i_bessel)
+  for(ip=0;ip<ht->n_panels;ip++) {
+    int ig;
+    for(ig=0;ig<CCL_CORR_BESSEL_NGL;ig++) {
+      int iq=ip*CCL_CORR_BESSEL_NGL+ig;
+      double w;
+      gsl_integration_glfixed_point(ht->x_edge[ip],ht->x_edge[ip+1],ig,&(ht->x_q[iq]),&w,ht->tgl);
+      ht->wxj_q[iq]=w*ht->x_q[iq]*gsl_sf_bessel_Jn(i_bessel,ht->x_q[iq]);
+    }
+  }
+
+  return ht;
+}
+
+/*--------ROUTINE: corr_hankel_integrate ------
+TASK: Compute \int_0^{l_max} dl l J_n(l theta) C_l = theta^-2 \int_0^{theta l_max} dx x J_n(x) C_{x/theta}
+      using the precomputed panels, and fresh nodes in the panel containing theta*l_max.
+INPUT: table, C_l parameters, theta (in radians), l_max
+ */
+static double corr_hankel_integrate(corr_hankel_table *ht,corr_int_par *cp,double th,double l_max)
+{
+  int ip,ig,iq=0;
+  double sum=0;
+  double x_max=th*l_max;
+
+  for(ip=0;(ip<ht->n_panels) && (ht->x_edge[ip+1]<=x_max);ip++) {
+    for(ig=0;ig<CCL_CORR_BESSEL_NGL;ig++) {
+      sum+=ht->wxj_q[iq]*corr_bessel_cl(ht->x_q[iq]/th,cp);
+      iq++;
+    }
+  }
+  if((ip<ht->n_panels) && (ht->x_edge[ip]<x_max)) {
+    for(ig=0;ig<CCL_CORR_BESSEL_NGL;ig++) {
+      double x,w;
+      gsl_integration_glfixed_point(ht->x_edge[ip],x_max,ig,&x,&w,ht->tgl);
+      sum+=w*x*gsl_sf_bessel_Jn(ht->i_bessel,x)*corr_bessel_cl(x/th,cp);
+    }
+  }
+
+  return sum/(th*th);
+}
+
+/*--------ROUTINE: ccl_tracer_corr_bessel ------
+TASK: Compute correlation function by direct integration over the Bessel function.
+      The integral is split at the zeros of J_n, with Gauss-Legendre nodes that are
+      shared by all values of theta, and parallelized over theta.
+ */
 static void ccl_tracer_corr_bessel(ccl_cosmology *cosmo,
 				   int n_ell,double *ell,double *cls,
 				   int n_theta,double *theta,double *wtheta,
 				   int corr_type,int *status)
 {
+  int ith;
+  double th_min,th_max,x_lo;
+  double l_max=ccl_splines->ELL_MAX_CORR;
+  corr_hankel_table *ht;
   corr_int_par *cp=malloc(sizeof(corr_int_par));
   if(cp==NULL) {
     *status=CCL_ERROR_MEMORY;
@@ -237,61 +540,93 @@ static void ccl_tracer_corr_bessel(ccl_cosmology *cosmo,
     cp->tiltf=log10(cls[n_ell-1]/cls[n_ell-2])/log10(ell[n_ell-1]/ell[n_ell-2]);
   }
 
-  int ith, gslstatus;
-  double result,eresult;
-  gsl_function F;
-  gsl_integration_workspace *w=gsl_integration_workspace_alloc(ccl_gsl->N_ITERATION);
-  for(ith=0;ith<n_theta;ith++) {
-    cp->th=theta[ith]*M_PI/180;
-    F.function=&corr_bessel_integrand;
-    F.params=cp;
-    //TODO: Split into intervals between first bessel zeros before integrating
-    //This will help both speed and accuracy of the integral.
-    gslstatus = gsl_integration_qag(&F, 0, ccl_splines->ELL_MAX_CORR, 0,
-                                    ccl_gsl->INTEGRATION_EPSREL, ccl_gsl->N_ITERATION,
-                                    ccl_gsl->INTEGRATION_GAUSS_KRONROD_POINTS,
-                                    w, &result, &eresult);
-    if(gslstatus != GSL_SUCCESS) {
-      ccl_raise_gsl_warning(gslstatus, "ccl_correlation.c: ccl_tracer_corr_bessel():");
-      *status |= gslstatus;
-    }
-    wtheta[ith]=result/(2*M_PI);
-  }
-  gsl_integration_workspace_free(w);
+  //The first panel, [0,x_lo], lies well below the smallest ell in the input for all theta
+  th_min=th_max=theta[0]*M_PI/180;
+  for(ith=1;ith<n_theta;ith++) {
+    th_min=fmin(th_min,theta[ith]*M_PI/180);
+    th_max=fmax(th_max,theta[ith]*M_PI/180);
+  }
+  x_lo=1E-2*th_min*((ell[0]>0) ? fmin(ell[0],1.) : 1.);
+  ht=corr_hankel_table_new(cp->i_bessel,x_lo,fmax(th_max*l_max,2*x_lo),status);
+  if(ht==NULL) {
+    ccl_spline_free(cp->cl_spl);
+    free(cp);
+    if(*status==CCL_ERROR_MEMORY)
+      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_bessel ran out of memory\n");
+    else
+      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_bessel(): "
+				       "too many integration panels\n");
+    return;
+  }
+
+#pragma omp parallel for default(none) shared(n_theta,theta,wtheta,ht,cp,l_max) schedule(dynamic)
+  for(ith=0;ith<n_theta;ith++)
+    wtheta[ith]=corr_hankel_integrate(ht,cp,theta[ith]*M_PI/180,l_max)/(2*M_PI);
+
+  corr_hankel_table_free(ht);
   ccl_spline_free(cp->cl_spl);
   free(cp);
 }
 
-
-/*--------ROUTINE: ccl_compute_legendre_polynomial ------
-TASK: Compute input factor for ccl_tracer_corr_legendre
-INPUT: tracer 1, tracer 2, i_bessel, theta array, n_theta, L_max, output Pl_theta
+/*--------ROUTINE: ccl_sum_legendre ------
+TASK: Compute the full-sky sum over multipoles 2<=l<ell_max (1<=l<ell_max for CCL_CORR_GG)
+        CCL_CORR_GG : sum_l (2l+1) C_l P_l(cos theta)
+        CCL_CORR_GL : sum_l (2l+1)/(l(l+1)) C_l P_l^2(cos theta)   (arXiv:1007.4809)
+        CCL_CORR_LP : sum_l (2l+1) C_l d^l_{22}(theta)
+        CCL_CORR_LM : sum_l (2l+1) C_l d^l_{2-2}(theta)
+      The Legendre functions and Wigner d-functions are generated on the fly with their
+      (stable) upward three-term recurrences in l, so the cost is O(ell_max) per theta.
+INPUT: type of correlation, theta (in degrees), ell_max, C_l for l=0..ell_max
  */
-static void ccl_compute_legendre_polynomial(int corr_type,double theta,int ell_max,double *Pl_theta)
+static double ccl_sum_legendre(int corr_type,double theta,int ell_max,double *cl_arr)
 {
-  int i,j;
-  double k=0;
-  double cth=cos(theta*M_PI/180);
-  
-  //Initialize Pl_theta
-  for (j=0;j<=ell_max;j++)
-      Pl_theta[j]=0.;
+  int l;
+  double sum=0;
+  double x=cos(theta*M_PI/180);
 
   if(corr_type==CCL_CORR_GG) {
-    gsl_sf_legendre_Pl_array(ell_max,cth,Pl_theta);
-    for (j=0;j<=ell_max;j++)
-      Pl_theta[j]*=(2*j+1);
+    double p_lm1=1,p_l=x,p_lp1;
+    for(l=1;l<ell_max;l++) {
+      sum+=(2*l+1.)*cl_arr[l]*p_l;
+      p_lp1=((2*l+1.)*x*p_l-l*p_lm1)/(l+1.);
+      p_lm1=p_l;
+      p_l=p_lp1;
+    }
   }
   else if(corr_type==CCL_CORR_GL) {
-    for (j=2;j<=ell_max;j++) {//https://arxiv.org/pdf/1007.4809.pdf
-      Pl_theta[j]=gsl_sf_legendre_Plm(j,2,cth);
-      Pl_theta[j]*=(2*j+1.)/((j+0.)*(j+1.));
+    // P_1^2=0, P_2^2=3(1-x^2), (l-1) P_{l+1}^2 = (2l+1) x P_l^2 - (l+2) P_{l-1}^2
+    double p_lm1=0,p_l=3*(1-x*x),p_lp1;
+    for(l=2;l<ell_max;l++) {
+      sum+=(2*l+1.)/(l*(l+1.))*cl_arr[l]*p_l;
+      p_lp1=((2*l+1.)*x*p_l-(l+2.)*p_lm1)/(l-1.);
+      p_lm1=p_l;
+      p_l=p_lp1;
+    }
+  }
+  else if((corr_type==CCL_CORR_LP) || (corr_type==CCL_CORR_LM)) {
+    // d^2_{22}=((1+x)/2)^2, d^2_{2-2}=((1-x)/2)^2 and, for m=2, m'=+-2,
+    // l ((l+1)^2-4) d^{l+1} = (2l+1) (l(l+1) x - m m') d^l - (l+1) (l^2-4) d^{l-1}
+    double mm=(corr_type==CCL_CORR_LP) ? 4 : -4;
+    double d_lm1=0,d_l,d_lp1;
+    if(corr_type==CCL_CORR_LP)
+      d_l=0.25*(1+x)*(1+x);
+    else
+      d_l=0.25*(1-x)*(1-x);
+    for(l=2;l<ell_max;l++) {
+      double dl=l,lp1=l+1.;
+      sum+=(2*dl+1)*cl_arr[l]*d_l;
+      d_lp1=((2*dl+1)*(dl*lp1*x-mm)*d_l-lp1*(dl*dl-4)*d_lm1)/(dl*(lp1*lp1-4));
+      d_lm1=d_l;
+      d_l=d_lp1;
     }
   }
+
+  return sum;
 }
 
 /*--------ROUTINE: ccl_tracer_corr_legendre ------
-TASK: Compute correlation function via Legendre polynomials
+TASK: Compute correlation function via a full-sky sum over Legendre polynomials
+      (or Wigner d-functions for xi+-), parallelized over theta.
 INPUT: cosmology, number of theta bins, theta array, tracer 1, tracer 2, i_bessel, boolean
        for tapering, vector of tapering limits, correlation vector, angular_cl function.
  */
@@ -302,16 +637,12 @@ static void ccl_tracer_corr_legendre(ccl_cosmology *cosmo,
 				     int *status)
 {
   int i;
-  double *l_arr,*cl_arr,*Pl_theta;
+  int ell_max=(int)(ccl_splines->ELL_MAX_CORR);
+  double *l_arr=NULL,*cl_arr=NULL;
   SplPar *cl_spl;
 
-  if(corr_type==CCL_CORR_LM || corr_type==CCL_CORR_LP){
-    *status=CCL_ERROR_NOT_IMPLEMENTED;
-    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: CCL does not support full-sky xi+- calcuations.\nhttps://arxiv.org/abs/1702.05301 indicates flat-sky to be sufficient.\n");
-  }
-  
   if(*status==0) {
-    l_arr=malloc(((int)(ccl_splines->ELL_MAX_CORR)+1)*sizeof(double));
+    l_arr=malloc((ell_max+1)*sizeof(double));
     if(l_arr==NULL) {
       *status=CCL_ERROR_MEMORY;
       ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_legendre ran out of memory\n");
@@ -319,7 +650,7 @@ static void ccl_tracer_corr_legendre(ccl_cosmology *cosmo,
   }
   
   if(*status==0) {
-    cl_arr=malloc(((int)(ccl_splines->ELL_MAX_CORR)+1)*sizeof(double));
+    cl_arr=malloc((ell_max+1)*sizeof(double));
     if(cl_arr==NULL) {
       *status=CCL_ERROR_MEMORY;
       ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_legendre ran out of memory\n");
@@ -346,7 +677,7 @@ static void ccl_tracer_corr_legendre(ccl_cosmology *cosmo,
       cl_tilt=log(cls[n_ell-1]/cls[n_ell-2])/log(ell[n_ell-1]/ell[n_ell-2]);
       cl_edge=cls[n_ell-1];
     }
-    for(i=0;i<=(int)(ccl_splines->ELL_MAX_CORR);i++) {
+    for(i=0;i<=ell_max;i++) {
       double l=(double)i;
       l_arr[i]=l;
       if(l>=l_edge)
@@ -357,28 +688,15 @@ static void ccl_tracer_corr_legendre(ccl_cosmology *cosmo,
     ccl_spline_free(cl_spl);
 
     if (do_taper_cl)
-      *status=taper_cl((int)(ccl_splines->ELL_MAX_CORR)+1,l_arr,cl_arr,taper_cl_limits);
+      *status=taper_cl(ell_max+1,l_arr,cl_arr,taper_cl_limits);
   }
 
   if(*status==0) {
-    Pl_theta=malloc(sizeof(double)*((int)(ccl_splines->ELL_MAX_CORR)+1));
-    if(Pl_theta==NULL) {
-      *status=CCL_ERROR_MEMORY;
-      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_tracer_corr_legendre ran out of memory\n");
-    }
-  }
-  
-  if(*status==0) {
-    for (int i=0;i<n_theta;i++) {
-      wtheta[i]=0;
-      ccl_compute_legendre_polynomial(corr_type,theta[i],(int)(ccl_splines->ELL_MAX_CORR),Pl_theta);
-      for(int i_L=1;i_L<(int)(ccl_splines->ELL_MAX_CORR);i_L+=1)
-	wtheta[i]+=cl_arr[i_L]*Pl_theta[i_L];
-      wtheta[i]/=(M_PI*4);
-    }
+#pragma omp parallel for default(none) shared(n_theta,theta,wtheta,corr_type,ell_max,cl_arr)
+    for(i=0;i<n_theta;i++)
+      wtheta[i]=ccl_sum_legendre(corr_type,theta[i],ell_max,cl_arr)/(M_PI*4);
   }
 
-  free(Pl_theta);
   free(l_arr);
   free(cl_arr);
 }
@@ -417,6 +735,182 @@ void ccl_correlation(ccl_cosmology *cosmo,
   ccl_check_status(cosmo,status);
 }
 
+/*--------ROUTINE: ccl_correlation_multi ------
+TASK: Compute several correlation functions for a stack of power spectra in one call.
+      With CCL_CORR_FFTLOG all of them are computed by batched transforms, otherwise
+      they are computed one by one.
+INPUT: cosmology, number of multipoles, multipoles, number of power spectra, power spectra,
+       theta vector, number of correlation types, correlation types, key for tapering,
+       limits of tapering, method
+ */
+void ccl_correlation_multi(ccl_cosmology *cosmo,
+			   int n_ell,double *ell,int n_cls,double *cls,
+			   int n_theta,double *theta,
+			   int n_types,int *corr_types,double *wtheta,
+			   int do_taper_cl,double *taper_cl_limits,int flag_method,
+			   int *status)
+{
+  int it,i;
+
+  if(flag_method==CCL_CORR_FFTLOG) {
+    ccl_tracer_corr_fftlog_multi(cosmo,n_ell,ell,n_cls,cls,n_theta,theta,n_types,corr_types,
+				 wtheta,do_taper_cl,taper_cl_limits,status);
+  }
+  else {
+    for(it=0;(it<n_types) && (*status==0);it++) {
+      for(i=0;(i<n_cls) && (*status==0);i++)
+	ccl_correlation(cosmo,n_ell,ell,&(cls[i*n_ell]),n_theta,theta,
+			&(wtheta[(it*n_cls+i)*n_theta]),corr_types[it],
+			do_taper_cl,taper_cl_limits,flag_method,status);
+    }
+  }
+
+  ccl_check_status(cosmo,status);
+}
+
+/*--------ROUTINE: corr3d_window ------
+TASK: Smooth window going from 0 at x=0 to 1 at x=1 with vanishing first derivative at both ends
+ */
+static double corr3d_window(double x)
+{
+  return x-sin(2*M_PI*x)/(2*M_PI);
+}
+
+/*--------ROUTINE: corr3d_xil_splines_thread ------
+TASK: Compute the Hankel transforms of the non-linear (or, if linear!=0, linear) matter power spectrum
+        xi_l(r) = \int dk k^2 P(k,a) j_l(kr) / (2 pi^2)
+      for a set of multipoles l using FFTLog, and store them as splines in r.
+      P(k) is sampled once for all multipoles.
+      If N_K_3DCOR_LEAN>0, a lean grid with N_K_3DCOR_LEAN points per decade is used.
+      P(k) is extrapolated as a power law over K_EXTRAP_3DCOR decades beyond [K_MIN,K_MAX],
+      where it is smoothly tapered to zero, and the grid is zero-padded by a fraction
+      ZEROPAD_3DCOR of its length on each side to reduce aliasing.
+      Otherwise [K_MIN,K_MAX] is sampled with N_K_3DCOR points per decade.
+      This function doesn't set the status message of the cosmology, so that it can be
+      called from several threads (see corr3d_xil_splines).
+INPUT: cosmology, scale factor a, number of multipoles, multipoles, key for the linear
+       power spectrum, key for tapering, limits of tapering
+OUTPUT: array of n_l splines
+ */
+static void corr3d_xil_splines_thread(ccl_cosmology *cosmo,double a,int n_l,int *ls,int linear,
+				      int do_taper_pk,double *taper_pk_limits,
+				      SplPar **spl,int *status)
+{
+  int i,il,n_data,n_pad,n_k,i_lo=-1,i_hi=-1;
+  double lk_lo,lk_hi,dlk,lk_range;
+  double *k_arr,*pk_arr,*r_arr,*xi_arr;
+
+  for(il=0;il<n_l;il++)
+    spl[il]=NULL;
+
+  if(ccl_splines->N_K_3DCOR_LEAN>0) {
+    lk_lo=log10(ccl_splines->K_MIN)-ccl_splines->K_EXTRAP_3DCOR;
+    lk_hi=log10(ccl_splines->K_MAX)+ccl_splines->K_EXTRAP_3DCOR;
+    n_data=(int)(ccl_splines->N_K_3DCOR_LEAN*(lk_hi-lk_lo))+1;
+    n_pad=(int)(ccl_splines->ZEROPAD_3DCOR*n_data);
+  }
+  else {
+    lk_lo=log10(ccl_splines->K_MIN);
+    lk_hi=log10(ccl_splines->K_MAX);
+    n_data=(int)(ccl_splines->N_K_3DCOR*(lk_hi-lk_lo));
+    n_pad=0;
+  }
+  n_k=n_data+2*n_pad;
+  dlk=(lk_hi-lk_lo)/(n_data-1);
+
+  //FFTLog needs the whole grid at once, so it can't be streamed. All arrays share one block.
+  k_arr=malloc(4*n_k*sizeof(double));
+  if(k_arr==NULL) {
+    *status=CCL_ERROR_MEMORY;
+    return;
+  }
+  pk_arr=k_arr+n_k;
+  r_arr=k_arr+2*n_k;
+  xi_arr=k_arr+3*n_k;
+
+  //Sample P(k) within [K_MIN,K_MAX]
+  for(i=0;i<n_k;i++) {
+    k_arr[i]=pow(10.,lk_lo+(i-n_pad)*dlk);
+    pk_arr[i]=0;
+    if((k_arr[i]>=ccl_splines->K_MIN*(1-1E-10)) && (k_arr[i]<=ccl_splines->K_MAX*(1+1E-10))) {
+      if(linear)
+	pk_arr[i]=ccl_linear_matter_power(cosmo,k_arr[i],a,status);
+      else
+	pk_arr[i]=ccl_nonlin_matter_power(cosmo,k_arr[i],a,status);
+      if(i_lo<0)
+	i_lo=i;
+      i_hi=i;
+    }
+  }
+
+  //Power-law extrapolation, tapered to zero at the ends of the grid
+  if((ccl_splines->N_K_3DCOR_LEAN>0) && (i_hi>i_lo+1)) {
+    if((pk_arr[i_lo]>0) && (pk_arr[i_lo+1]>0)) {
+      double tilt=log(pk_arr[i_lo+1]/pk_arr[i_lo])/log(k_arr[i_lo+1]/k_arr[i_lo]);
+      for(i=n_pad;i<i_lo;i++)
+	pk_arr[i]=pk_arr[i_lo]*pow(k_arr[i]/k_arr[i_lo],tilt)*
+	  corr3d_window((i-n_pad)/(double)(i_lo-n_pad));
+    }
+    if((pk_arr[i_hi]>0) && (pk_arr[i_hi-1]>0)) {
+      double tilt=log(pk_arr[i_hi]/pk_arr[i_hi-1])/log(k_arr[i_hi]/k_arr[i_hi-1]);
+      for(i=i_hi+1;i<n_pad+n_data;i++)
+	pk_arr[i]=pk_arr[i_hi]*pow(k_arr[i]/k_arr[i_hi],tilt)*
+	  corr3d_window((n_pad+n_data-1-i)/(double)(n_pad+n_data-1-i_hi));
+    }
+  }
+
+  if (do_taper_pk)
+    taper_cl(n_k,k_arr,pk_arr,taper_pk_limits);
+
+  //Same transform as fftlog_ComputeXiLM(l,2,...), with the k^(3/2) weight
+  //applied once for all multipoles
+  for(i=0;i<n_k;i++)
+    pk_arr[i]*=k_arr[i]*sqrt(k_arr[i]);
+  lk_range=log(k_arr[n_k-1]/k_arr[0])*n_k/(n_k-1.);
+
+  for(il=0;il<n_l;il++) {
+    fftlog_plan *plan;
+    if(*status)
+      break;
+    plan=fftlog_plan_get(n_k,ls[il]+0.5,0,lk_range,1,1);
+    if(plan==NULL) {
+      *status=CCL_ERROR_MEMORY;
+      break;
+    }
+    fftlog_plan_execute(plan,k_arr,pk_arr,r_arr,xi_arr);
+    for(i=0;i<n_k;i++)
+      xi_arr[i]*=pow(2*M_PI*r_arr[i],-1.5);
+    spl[il]=ccl_spline_init(n_k,r_arr,xi_arr,xi_arr[0],0);
+    if(spl[il]==NULL) {
+      *status=CCL_ERROR_SPLINE;
+    }
+  }
+
+  if(*status) {
+    for(il=0;il<n_l;il++) {
+      if(spl[il]!=NULL)
+	ccl_spline_free(spl[il]);
+      spl[il]=NULL;
+    }
+  }
+
+  free(k_arr);
+}
+
+/*--------ROUTINE: corr3d_xil_splines ------
+TASK: Same as corr3d_xil_splines_thread, setting the status message of the cosmology on errors
+ */
+static void corr3d_xil_splines(ccl_cosmology *cosmo,double a,int n_l,int *ls,int linear,
+			       int do_taper_pk,double *taper_pk_limits,
+			       SplPar **spl,int *status)
+{
+  corr3d_xil_splines_thread(cosmo,a,n_l,ls,linear,do_taper_pk,taper_pk_limits,spl,status);
+  if(*status==CCL_ERROR_MEMORY)
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: corr3d_xil_splines ran out of memory\n");
+  else if(*status==CCL_ERROR_SPLINE)
+    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: corr3d_xil_splines error initializing spline\n");
+}
+
 /*--------ROUTINE: ccl_correlation_3d ------
 TASK: Calculate the 3d-correlation function. Do so by using FFTLog. 
 
@@ -432,62 +926,95 @@ void ccl_correlation_3d(ccl_cosmology *cosmo, double a,
 			int do_taper_pk,double *taper_pk_limits,
 			int *status)
 {
-  int i,N_ARR;
-  double *k_arr,*pk_arr,*r_arr,*xi_arr;
+  int i,l=0;
+  SplPar *xi_spl;
 
-  //number of data points for k and pk array
-  N_ARR=(int)(ccl_splines->N_K_3DCOR*log10(ccl_splines->K_MAX/ccl_splines->K_MIN));  
+  corr3d_xil_splines(cosmo,a,1,&l,0,do_taper_pk,taper_pk_limits,&xi_spl,status);
 
-  k_arr=ccl_log_spacing(ccl_splines->K_MIN,ccl_splines->K_MAX,N_ARR);
-  if(k_arr==NULL) {
-    *status=CCL_ERROR_MEMORY;
-    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_3d ran out of memory\n");
-    return;
+  // Interpolate to output values of r
+  if(*status==0) {
+    for(i=0;i<n_r;i++)
+      xi[i]=ccl_spline_eval(r[i],xi_spl);
+    ccl_spline_free(xi_spl);
   }
 
-  pk_arr=malloc(N_ARR*sizeof(double));
-  if(pk_arr==NULL) {
-    free(k_arr);
-    *status=CCL_ERROR_MEMORY;
-    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_3d ran out of memory\n");
-    return;
-  }  
-
-  for (i=0; i<N_ARR; i++)
-    pk_arr[i] = ccl_nonlin_matter_power(cosmo, k_arr[i], a, status);
-
-  if (do_taper_pk)
-    taper_cl(N_ARR,k_arr,pk_arr,taper_pk_limits);
+  ccl_check_status(cosmo,status);
 
-  r_arr=malloc(sizeof(double)*N_ARR);
-  if(r_arr==NULL) {
-    free(k_arr);
-    free(pk_arr);
-    *status=CCL_ERROR_MEMORY;
-    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_3d ran out of memory\n");
-    return;
-  }
-  xi_arr=malloc(sizeof(double)*N_ARR);
-  if(xi_arr==NULL) {
-    free(k_arr); free(pk_arr); free(r_arr);
-    *status=CCL_ERROR_MEMORY;
-    ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_3d ran out of memory\n");
-    return;
-  }
+  return;
+}
 
-  for(i=0;i<N_ARR;i++)
-    r_arr[i]=0;
+/*--------ROUTINE: ccl_correlation_3d_multi ------
+TASK: Calculate the 3d-correlation function at several scale factors.
+      If use_growth!=0, the linear correlation function is computed once at a=1 and
+      rescaled by D(a)^2. Otherwise the non-linear one is computed for each a, in parallel,
+      with the FFTLog plans reused by each thread.
 
-  pk2xi(N_ARR,k_arr,pk_arr,r_arr,xi_arr);
+INPUT: cosmology, number of scale factors, scale factors,
+       number of r values, r values, key for growth rescaling,
+       key for tapering, limits of tapering
 
-  // Interpolate to output values of r
-  SplPar *xi_spl=ccl_spline_init(N_ARR,r_arr,xi_arr,xi_arr[0],0);
-  for(i=0;i<n_r;i++)
-    xi[i]=ccl_spline_eval(r[i],xi_spl);
-  ccl_spline_free(xi_spl);
+Correlation function result will be in array xi, with xi[i_a*n_r+i_r]
+ */
 
-  free(k_arr); free(pk_arr);
-  free(r_arr); free(xi_arr);
+void ccl_correlation_3d_multi(ccl_cosmology *cosmo,int n_a,double *a,
+			      int n_r,double *r,double *xi,int use_growth,
+			      int do_taper_pk,double *taper_pk_limits,
+			      int *status)
+{
+  int ia,i,l=0;
+
+  //Power spectra and growth are computed before they are used from several threads
+  ccl_cosmology_compute_power(cosmo,status);
+  if((*status==0) && (!cosmo->computed_growth))
+    ccl_cosmology_compute_growth(cosmo,status);
+
+  if((*status==0) && use_growth) {
+    SplPar *xi_spl;
+    corr3d_xil_splines(cosmo,1.,1,&l,1,do_taper_pk,taper_pk_limits,&xi_spl,status);
+    if(*status==0) {
+      for(ia=0;ia<n_a;ia++) {
+	double gf=ccl_growth_factor(cosmo,a[ia],status);
+	for(i=0;i<n_r;i++)
+	  xi[ia*n_r+i]=gf*gf*ccl_spline_eval(r[i],xi_spl);
+      }
+      ccl_spline_free(xi_spl);
+    }
+  }
+  else if(*status==0) {
+#pragma omp parallel default(none) \
+  shared(cosmo,n_a,a,n_r,r,xi,do_taper_pk,taper_pk_limits,status)
+    {
+      int ia_thr,ir,l_thr=0;
+      int status_this=0;
+
+#pragma omp for schedule(dynamic)
+      for(ia_thr=0;ia_thr<n_a;ia_thr++) {
+	SplPar *xi_spl;
+	if(status_this)
+	  continue;
+	corr3d_xil_splines_thread(cosmo,a[ia_thr],1,&l_thr,0,do_taper_pk,taper_pk_limits,
+				  &xi_spl,&status_this);
+	if(status_this==0) {
+	  for(ir=0;ir<n_r;ir++)
+	    xi[ia_thr*n_r+ir]=ccl_spline_eval(r[ir],xi_spl);
+	  ccl_spline_free(xi_spl);
+	}
+      } //end omp for
+
+      if(status_this) {
+#pragma omp critical
+	{
+	  *status=status_this;
+	}
+      }
+    } //end omp parallel
+
+    //The status message is only set once all threads are done
+    if(*status) {
+      ccl_cosmology_set_status_message(cosmo, "ccl_correlation.c: ccl_correlation_3d_multi(): "
+				       "error computing 3D correlation function\n");
+    }
+  }
 
   ccl_check_status(cosmo,status);
 
@@ -506,230 +1033,235 @@ Multipole function result will be in array xi
 void ccl_correlation_multipole(ccl_cosmology *cosmo, double a, double beta,
                                int l, int n_s, double *s, double *xi,
                                int *status) {
-  int i, N_ARR;
-  double *k_arr, *pk_arr, *s_arr, *xi_arr, *xi_arr0;
-
-  N_ARR = (int)(ccl_splines->N_K_3DCOR * log10(ccl_splines->K_MAX / ccl_splines->K_MIN));
-
-  k_arr = ccl_log_spacing(ccl_splines->K_MIN, ccl_splines->K_MAX, N_ARR);
-  if (k_arr == NULL) {
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole ran out of memory\n");
-    return;
-  }
-
-  pk_arr = malloc(N_ARR * sizeof(double));
-  if (pk_arr == NULL) {
-    free(k_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole ran out of memory\n");
-    return;
-  }
-
-  for (i = 0; i < N_ARR; i++)
-    pk_arr[i] = ccl_nonlin_matter_power(cosmo, k_arr[i], a, status);
-
-  s_arr = malloc(sizeof(double) * N_ARR);
-  if (s_arr == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole ran out of memory\n");
-    return;
-  }
-  xi_arr = malloc(sizeof(double) * N_ARR);
-  if (xi_arr == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole ran out of memory\n");
-    return;
-  }
-  xi_arr0 = malloc(sizeof(double) * N_ARR);
-  if (xi_arr0 == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole ran out of memory\n");
-    return;
-  }
-
-  for (i = 0; i < N_ARR; i++) s_arr[i] = 0;
-
-  // Calculate multipoles
-
-  if (l == 0) {
-    fftlog_ComputeXiLM(0, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr0);
-    for (i = 0; i < N_ARR; i++)
-      xi_arr[i] = (1. + 2. / 3 * beta + 1. / 5 * beta * beta) * xi_arr0[i];
-  } else if (l == 2) {
-    fftlog_ComputeXiLM(2, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr0);
-    for (i = 0; i < N_ARR; i++)
-      xi_arr[i] = -(4. / 3 * beta + 4. / 7 * beta * beta) * xi_arr0[i];
-  } else if (l == 4) {
-    fftlog_ComputeXiLM(4, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr0);
-    for (i = 0; i < N_ARR; i++) xi_arr[i] = 8. / 35 * beta * beta * xi_arr0[i];
-  } else {
+  int i;
+  double fac;
+  SplPar *xi_spl;
+
+  if (l == 0)
+    fac = 1. + 2. / 3 * beta + 1. / 5 * beta * beta;
+  else if (l == 2)
+    fac = -(4. / 3 * beta + 4. / 7 * beta * beta);
+  else if (l == 4)
+    fac = 8. / 35 * beta * beta;
+  else {
+    *status = CCL_ERROR_INCONSISTENT;
     strcpy(cosmo->status_message, "unavailable value of l\n");
     return;
   }
 
-  // Interpolate to output values of s
-  SplPar *xi_spl = ccl_spline_init(N_ARR, s_arr, xi_arr, xi_arr[0], 0);
-  for (i = 0; i < n_s; i++) xi[i] = ccl_spline_eval(s[i], xi_spl);
-  ccl_spline_free(xi_spl);
+  corr3d_xil_splines(cosmo, a, 1, &l, 0, 0, NULL, &xi_spl, status);
 
-  free(k_arr);
-  free(pk_arr);
-  free(s_arr);
-  free(xi_arr);
-  free(xi_arr0);
+  // Interpolate to output values of s
+  if (*status == 0) {
+    for (i = 0; i < n_s; i++) xi[i] = fac * ccl_spline_eval(s[i], xi_spl);
+    ccl_spline_free(xi_spl);
+  }
 
   ccl_check_status(cosmo, status);
 
   return;
 }
 
-/*--------ROUTINE: ccl_correlation_multipole_spline ------
-TASK: Store multipoles of the redshift-space correlation in global splines
-
-INPUT:  cosmology, scale factor a
+static void xir_entry_free(xir_entry *e)
+{
+  for (int i = 0; i < 3; i++) {
+    if (e->spl[i] != NULL)
+      ccl_spline_free(e->spl[i]);
+  }
+  free(e);
+}
 
-Result is stored in xir_spline[]
+/*--------ROUTINE: xir_cache_sync ------
+TASK: Make the multipole spline cache of a cosmology consistent with its current parameters
+      and 3D correlation settings, removing all its entries if they have changed.
+      Must be called from within the ccl_xir_cache critical region.
  */
-
-void ccl_correlation_multipole_spline(ccl_cosmology *cosmo, double a,
-                                      int *status) {
-  int i, N_ARR;
-  double *k_arr, *pk_arr, *s_arr, *xi_arr, *xi_arr0, *xi_arr2, *xi_arr4;
-
-  N_ARR = (int)(ccl_splines->N_K_3DCOR * log10(ccl_splines->K_MAX / ccl_splines->K_MIN));
-
-  k_arr = ccl_log_spacing(ccl_splines->K_MIN, ccl_splines->K_MAX, N_ARR);
-  if (k_arr == NULL) {
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
+static void xir_cache_sync(ccl_cosmology *cosmo, struct ccl_xir_cache *c) {
+  ccl_spline_params *sp = &(c->splines);
+  if (ccl_parameters_equal(&(c->params), &(cosmo->params)) &&
+      ccl_configuration_equal(&(c->config), &(cosmo->config)) &&
+      (sp->K_MIN == ccl_splines->K_MIN) && (sp->K_MAX == ccl_splines->K_MAX) &&
+      (sp->N_K_3DCOR == ccl_splines->N_K_3DCOR) &&
+      (sp->N_K_3DCOR_LEAN == ccl_splines->N_K_3DCOR_LEAN) &&
+      (sp->K_EXTRAP_3DCOR == ccl_splines->K_EXTRAP_3DCOR) &&
+      (sp->ZEROPAD_3DCOR == ccl_splines->ZEROPAD_3DCOR))
     return;
-  }
 
-  pk_arr = malloc(N_ARR * sizeof(double));
-  if (pk_arr == NULL) {
-    free(k_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+  // Entries still in use are freed by their last user (see xir_release)
+  for (int i = 0; i < c->n_entries; i++) {
+    xir_entry *e = c->entries[i];
+    e->in_cache = 0;
+    if (e->n_users == 0)
+      xir_entry_free(e);
   }
+  c->n_entries = 0;
+  c->params = cosmo->params;
+  c->config = cosmo->config;
+  c->splines = *ccl_splines;
+}
 
-  for (i = 0; i < N_ARR; i++)
-    pk_arr[i] = ccl_nonlin_matter_power(cosmo, k_arr[i], a, status);
+/*--------ROUTINE: xir_acquire ------
+TASK: Return the multipole splines stored in the cosmology for scale factor a, computing
+      and storing them if needed. The entry must be given back with xir_release.
 
-  s_arr = malloc(sizeof(double) * N_ARR);
-  if (s_arr == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+INPUT:  cosmology, scale factor a
+ */
+static xir_entry *xir_acquire(ccl_cosmology *cosmo, double a, int *status) {
+  int i;
+  xir_entry *e = NULL;
+
+#pragma omp critical(ccl_xir_cache)
+  {
+    struct ccl_xir_cache *c = cosmo->data.xir;
+    if (c != NULL) {
+      xir_cache_sync(cosmo, c);
+      for (i = 0; i < c->n_entries; i++) {
+        if (c->entries[i]->a == a) {
+          e = c->entries[i];
+          e->n_users++;
+          e->last_used = ++(c->n_calls);
+          break;
+        }
+      }
+    }
   }
-  xi_arr = malloc(sizeof(double) * N_ARR);
-  if (xi_arr == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
+  if (e != NULL)
+    return e;
+
+  // Not stored yet: the FFTLog transforms are done outside the critical region
+  xir_entry *e_new = malloc(sizeof(xir_entry));
+  if (e_new == NULL) {
     *status = CCL_ERROR_MEMORY;
     strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+           "ccl_correlation.c: xir_acquire ran out of memory\n");
+    return NULL;
   }
-  xi_arr0 = malloc(sizeof(double) * N_ARR);
-  if (xi_arr0 == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+  int ls[3] = {0, 2, 4};
+  e_new->a = a;
+  e_new->n_users = 1;
+  e_new->in_cache = 0;
+  corr3d_xil_splines(cosmo, a, 3, ls, 0, 0, NULL, e_new->spl, status);
+  if (*status) {
+    free(e_new);
+    return NULL;
   }
-  xi_arr2 = malloc(sizeof(double) * N_ARR);
-  if (xi_arr2 == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+
+#pragma omp critical(ccl_xir_cache)
+  {
+    struct ccl_xir_cache *c = cosmo->data.xir;
+    if (c == NULL) {
+      c = calloc(1, sizeof(struct ccl_xir_cache));
+      if (c != NULL) {
+        c->params = cosmo->params;
+        c->config = cosmo->config;
+        c->splines = *ccl_splines;
+      }
+      cosmo->data.xir = c;
+    }
+    if (c != NULL) {
+      xir_cache_sync(cosmo, c);
+      // Another thread may have stored the same scale factor in the meantime
+      for (i = 0; i < c->n_entries; i++) {
+        if (c->entries[i]->a == a) {
+          e = c->entries[i];
+          e->n_users++;
+          e->last_used = ++(c->n_calls);
+          break;
+        }
+      }
+      if (e == NULL) {
+        int i_store = -1;
+        if (c->n_entries < CCL_CORR_XIR_CACHE_SIZE)
+          i_store = c->n_entries++;
+        else {
+          // Replace the least recently used entry
+          for (i = 0; i < c->n_entries; i++) {
+            if ((i_store < 0) ||
+                (c->entries[i]->last_used < c->entries[i_store]->last_used))
+              i_store = i;
+          }
+          xir_entry *e_old = c->entries[i_store];
+          e_old->in_cache = 0;
+          if (e_old->n_users == 0)
+            xir_entry_free(e_old);
+        }
+        e_new->in_cache = 1;
+        e_new->last_used = ++(c->n_calls);
+        c->entries[i_store] = e_new;
+      }
+    }
   }
-  xi_arr4 = malloc(sizeof(double) * N_ARR);
-  if (xi_arr4 == NULL) {
-    free(k_arr);
-    free(pk_arr);
-    free(s_arr);
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_multipole_spline ran out of "
-           "memory\n");
-    return;
+
+  // If the cache could not be used, the new entry is only kept by the caller
+  if (e != NULL) {
+    xir_entry_free(e_new);
+    return e;
   }
+  return e_new;
+}
 
-  for (i = 0; i < N_ARR; i++) s_arr[i] = 0;
+static void xir_release(xir_entry *e) {
+  int do_free;
+#pragma omp critical(ccl_xir_cache)
+  {
+    e->n_users--;
+    do_free = (e->n_users == 0) && (!e->in_cache);
+  }
+  if (do_free)
+    xir_entry_free(e);
+}
 
-  // Calculate multipoles
+/*--------ROUTINE: ccl_correlation_multipole_spline ------
+TASK: Store multipoles of the redshift-space correlation in the cosmology
 
-  fftlog_ComputeXiLM(0, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr0);
-  fftlog_ComputeXiLM(2, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr2);
-  fftlog_ComputeXiLM(4, 2, N_ARR, k_arr, pk_arr, s_arr, xi_arr4);
+INPUT:  cosmology, scale factor a
 
-  // Interpolate to output values of s
-  xir_spline[0] = ccl_spline_init(N_ARR, s_arr, xi_arr0, xi_arr0[0], 0);
-  xir_spline[1] = ccl_spline_init(N_ARR, s_arr, xi_arr2, xi_arr2[0], 0);
-  xir_spline[2] = ccl_spline_init(N_ARR, s_arr, xi_arr4, xi_arr4[0], 0);
+Result is stored in cosmo->data.xir
+ */
 
-  free(k_arr);
-  free(pk_arr);
-  free(s_arr);
-  free(xi_arr);
-  free(xi_arr0);
-  free(xi_arr2);
-  free(xi_arr4);
+void ccl_correlation_multipole_spline(ccl_cosmology *cosmo, double a,
+                                      int *status) {
+  xir_entry *e = xir_acquire(cosmo, a, status);
+  if (e != NULL)
+    xir_release(e);
 
   ccl_check_status(cosmo, status);
 
   return;
 }
 
-/*--------ROUTINE: ccl_correlation_3dRsd ------
-TASK: free the splines
+/*--------ROUTINE: ccl_correlation_multipole_spline_free ------
+TASK: free the splines stored in the cosmology
 
 */
-void ccl_correlation_multipole_spline_free() {
-  ccl_spline_free(xir_spline[0]);
-  ccl_spline_free(xir_spline[1]);
-  ccl_spline_free(xir_spline[2]);
-  xir_spline[0] = NULL;
-  xir_spline[1] = NULL;
-  xir_spline[2] = NULL;
+void ccl_correlation_multipole_spline_free(ccl_cosmology *cosmo) {
+  if (cosmo == NULL)
+    return;
+
+  struct ccl_xir_cache *c = cosmo->data.xir;
+  if (c == NULL)
+    return;
+
+  for (int i = 0; i < c->n_entries; i++)
+    xir_entry_free(c->entries[i]);
+  free(c);
+  cosmo->data.xir = NULL;
 
   return;
 }
 
+/*--------ROUTINE: corr3d_rsd_eval ------
+TASK: Evaluate the linear (Kaiser) redshift-space correlation function at distance s and
+      cosine mu from the splines of the l=0,2,4 Hankel transforms of P(k)
+ */
+static double corr3d_rsd_eval(SplPar **spl, double beta, double s, double mu) {
+  return (1. + 2. / 3 * beta + 1. / 5 * beta * beta) * ccl_spline_eval(s, spl[0]) -
+         (4. / 3 * beta + 4. / 7 * beta * beta) * ccl_spline_eval(s, spl[1]) *
+             gsl_sf_legendre_Pl(2, mu) +
+         8. / 35 * beta * beta * ccl_spline_eval(s, spl[2]) *
+             gsl_sf_legendre_Pl(4, mu);
+}
+
 /*--------ROUTINE: ccl_correlation_3dRsd ------
 TASK: Calculate the redshift-space correlation function.  
 
@@ -744,56 +1276,26 @@ void ccl_correlation_3dRsd(ccl_cosmology *cosmo, double a, int n_s, double *s,
                            double mu, double beta, double *xi, int use_spline,
                            int *status) {
   int i;
-  double *xi_arr0, *xi_arr2, *xi_arr4;
 
   if (use_spline == 0) {
-    xi_arr0 = malloc(sizeof(double) * n_s);
-    if (xi_arr0 == NULL) {
-      *status = CCL_ERROR_MEMORY;
-      strcpy(cosmo->status_message,
-             "ccl_correlation.c: ccl_correlation_3dRsd ran out of memory\n");
-      return;
-    }
-    xi_arr2 = malloc(sizeof(double) * n_s);
-    if (xi_arr2 == NULL) {
-      free(xi_arr0);
-      *status = CCL_ERROR_MEMORY;
-      strcpy(cosmo->status_message,
-             "ccl_correlation.c: ccl_correlation_3dRsd ran out of memory\n");
-      return;
+    // All multipoles are computed from a single sampling of P(k)
+    SplPar *spl[3];
+    int ls[3] = {0, 2, 4};
+    corr3d_xil_splines(cosmo, a, 3, ls, 0, 0, NULL, spl, status);
+    if (*status == 0) {
+      for (i = 0; i < n_s; i++)
+        xi[i] = corr3d_rsd_eval(spl, beta, s[i], mu);
+      for (i = 0; i < 3; i++)
+        ccl_spline_free(spl[i]);
     }
-    xi_arr4 = malloc(sizeof(double) * n_s);
-    if (xi_arr4 == NULL) {
-      free(xi_arr2);
-      free(xi_arr4);
-      *status = CCL_ERROR_MEMORY;
-      strcpy(cosmo->status_message,
-             "ccl_correlation.c: ccl_correlation_3dRsd ran out of memory\n");
-      return;
-    }
-
-    ccl_correlation_multipole(cosmo, a, beta, 0, n_s, s, xi_arr0, status);
-    ccl_correlation_multipole(cosmo, a, beta, 2, n_s, s, xi_arr2, status);
-    ccl_correlation_multipole(cosmo, a, beta, 4, n_s, s, xi_arr4, status);
-    for (i = 0; i < n_s; i++)
-      xi[i] = xi_arr0[i] + xi_arr2[i] * gsl_sf_legendre_Pl(2, mu) +
-              xi_arr4[i] * gsl_sf_legendre_Pl(4, mu);
-    free(xi_arr0);
-    free(xi_arr2);
-    free(xi_arr4);
 
   } else {
-    if (xir_spline[0] == NULL)
-      ccl_correlation_multipole_spline(cosmo, a, status);
-
-    for (i = 0; i < n_s; i++)
-      xi[i] = (1. + 2. / 3 * beta + 1. / 5 * beta * beta) *
-                  ccl_spline_eval(s[i], xir_spline[0]) -
-              (4. / 3 * beta + 4. / 7 * beta * beta) *
-                  ccl_spline_eval(s[i], xir_spline[1]) *
-                  gsl_sf_legendre_Pl(2, mu) +
-              8. / 35 * beta * beta * ccl_spline_eval(s[i], xir_spline[2]) *
-                  gsl_sf_legendre_Pl(4, mu);
+    xir_entry *e = xir_acquire(cosmo, a, status);
+    if (e != NULL) {
+      for (i = 0; i < n_s; i++)
+        xi[i] = corr3d_rsd_eval(e->spl, beta, s[i], mu);
+      xir_release(e);
+    }
   }
 
   ccl_check_status(cosmo, status);
@@ -820,6 +1322,104 @@ void ccl_correlation_3dRsd_avgmu(ccl_cosmology *cosmo, double a, int n_s, double
   return;
 }
 
+/*--------ROUTINE: ccl_correlation_pi_sigma_grid ------
+TASK: Calculate the redshift-space correlation function on a grid of longitudinal and
+      transverse coordinates pi and sigma. The multipoles are evaluated once for each
+      point, and combined with the Legendre polynomials in a vectorizable loop.
+      Rows of constant pi are computed in parallel.
+
+INPUT:  cosmology, scale factor a, beta (= growth rate / bias),
+        number of pi values, pi values, number of sigma values, sigma values,
+        key for using spline
+
+Correlation function result will be in array xi, with xi[i_pi*n_sig+i_sig]
+*/
+
+void ccl_correlation_pi_sigma_grid(ccl_cosmology *cosmo, double a, double beta,
+                                   int n_pi, double *pi, int n_sig, double *sig,
+                                   double *xi, int use_spline, int *status) {
+  xir_entry *e = NULL;
+  SplPar *spl_own[3] = {NULL, NULL, NULL};
+  SplPar **spl = NULL;
+  double *scratch = NULL;
+  double c0 = 1. + 2. / 3 * beta + 1. / 5 * beta * beta;
+  double c2 = -(4. / 3 * beta + 4. / 7 * beta * beta);
+  double c4 = 8. / 35 * beta * beta;
+
+  if (use_spline == 0) {
+    int ls[3] = {0, 2, 4};
+    corr3d_xil_splines(cosmo, a, 3, ls, 0, 0, NULL, spl_own, status);
+    if (*status == 0)
+      spl = spl_own;
+  } else {
+    e = xir_acquire(cosmo, a, status);
+    if (e != NULL)
+      spl = e->spl;
+  }
+
+  // Scratch space for all threads, allocated once per call
+  if (spl != NULL) {
+    int n_threads = 1;
+#ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+#endif //_OPENMP
+    scratch = malloc(3 * n_sig * n_threads * sizeof(double));
+    if (scratch == NULL) {
+      *status = CCL_ERROR_MEMORY;
+      strcpy(cosmo->status_message,
+             "ccl_correlation.c: ccl_correlation_pi_sigma_grid ran out of memory\n");
+    }
+  }
+
+  if ((spl != NULL) && (scratch != NULL)) {
+#pragma omp parallel default(none) \
+  shared(n_pi, pi, n_sig, sig, xi, spl, c0, c2, c4, scratch)
+    {
+      int i_pi, j;
+#ifdef _OPENMP
+      double *xi0 = &(scratch[3 * n_sig * omp_get_thread_num()]);
+#else //_OPENMP
+      double *xi0 = scratch;
+#endif //_OPENMP
+      double *xi2 = xi0 + n_sig;
+      double *mu2 = xi0 + 2 * n_sig;
+
+#pragma omp for schedule(dynamic)
+      for (i_pi = 0; i_pi < n_pi; i_pi++) {
+        double *xi_row = &(xi[i_pi * n_sig]);
+        // Spline lookups for each s in the row
+        for (j = 0; j < n_sig; j++) {
+          double s = sqrt(pi[i_pi] * pi[i_pi] + sig[j] * sig[j]);
+          mu2[j] = (s > 0) ? pi[i_pi] * pi[i_pi] / (s * s) : 0;
+          xi0[j] = ccl_spline_eval(s, spl[0]);
+          xi2[j] = ccl_spline_eval(s, spl[1]);
+          xi_row[j] = ccl_spline_eval(s, spl[2]);
+        }
+        // xi = c0 xi_0 + c2 xi_2 P_2(mu) + c4 xi_4 P_4(mu)
+#pragma omp simd
+        for (j = 0; j < n_sig; j++) {
+          double p2 = 1.5 * mu2[j] - 0.5;
+          double p4 = (35 * mu2[j] * mu2[j] - 30 * mu2[j] + 3) / 8;
+          xi_row[j] = c0 * xi0[j] + c2 * xi2[j] * p2 + c4 * xi_row[j] * p4;
+        }
+      } //end omp for
+    } //end omp parallel
+  }
+
+  free(scratch);
+  if (e != NULL)
+    xir_release(e);
+  if (spl_own[0] != NULL) {
+    int i;
+    for (i = 0; i < 3; i++)
+      ccl_spline_free(spl_own[i]);
+  }
+
+  ccl_check_status(cosmo, status);
+
+  return;
+}
+
 /*--------ROUTINE: ccl_correlation_pi_sigma ------
 TASK: Calculate the redshift-space correlation function using longitudinal and 
       transverse coordinates pi and sigma.
@@ -834,48 +1434,82 @@ Correlation function result will be in array xi
 void ccl_correlation_pi_sigma(ccl_cosmology *cosmo, double a, double beta,
                               double pi, int n_sig, double *sig, double *xi,
                               int use_spline, int *status) {
+  ccl_correlation_pi_sigma_grid(cosmo, a, beta, 1, &pi, n_sig, sig, xi,
+                                use_spline, status);
+
+  return;
+}
+
+/*--------ROUTINE: ccl_correlation_wp ------
+TASK: Calculate the projected correlation function
+        w_p(r_p) = 2 \int_0^{pi_max} dpi xi(pi, r_p)
+      The integral is done with Gauss-Legendre panels of fixed width in u = asinh(pi/r_p),
+      which are dense around pi ~ r_p and logarithmic in pi beyond. xi(pi, r_p) is evaluated
+      from the multipole splines stored in the cosmology for scale factor a.
+
+INPUT:  cosmology, scale factor a, beta (= growth rate / bias),
+        pi_max, number of r_p values, r_p values
+
+Result will be in array wp
+*/
+
+void ccl_correlation_wp(ccl_cosmology *cosmo, double a, double beta,
+                        double pi_max, int n_rp, double *rp, double *wp,
+                        int *status) {
   int i;
-  double *mu_arr, *s_arr, *xi_arr;
+  xir_entry *e;
+  gsl_integration_glfixed_table *tgl;
 
-  mu_arr = malloc(sizeof(double) * n_sig);
-  if (mu_arr == NULL) {
-    *status = CCL_ERROR_MEMORY;
+  if (pi_max <= 0) {
+    *status = CCL_ERROR_INCONSISTENT;
     strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_pi_sigma ran out of memory\n");
-    return;
+           "ccl_correlation.c: ccl_correlation_wp: pi_max must be positive\n");
   }
-
-  s_arr = malloc(sizeof(double) * n_sig);
-  if (s_arr == NULL) {
-    *status = CCL_ERROR_MEMORY;
-    strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_pi_sigma ran out of memory\n");
+  for (i = 0; (i < n_rp) && (*status == 0); i++) {
+    if (rp[i] <= 0) {
+      *status = CCL_ERROR_INCONSISTENT;
+      strcpy(cosmo->status_message,
+             "ccl_correlation.c: ccl_correlation_wp: r_p must be positive\n");
+    }
+  }
+  if (*status) {
+    ccl_check_status(cosmo, status);
     return;
   }
 
-  xi_arr = malloc(sizeof(double) * n_sig);
-  if (xi_arr == NULL) {
+  tgl = gsl_integration_glfixed_table_alloc(CCL_CORR_WP_NGL);
+  if (tgl == NULL) {
     *status = CCL_ERROR_MEMORY;
     strcpy(cosmo->status_message,
-           "ccl_correlation.c: ccl_correlation_pi_sigma ran out of memory\n");
+           "ccl_correlation.c: ccl_correlation_wp ran out of memory\n");
+    ccl_check_status(cosmo, status);
     return;
   }
 
-  for (i = 0; i < n_sig; i++) {
-    s_arr[i] = sqrt(pi * pi + sig[i] * sig[i]);
-    mu_arr[i] = pi / s_arr[i];
-  }
-
-  for (i = 0; i < n_sig; i++) {
-    ccl_correlation_3dRsd(cosmo, a, n_sig, s_arr, mu_arr[i], beta, xi_arr,
-                          use_spline, status);
-    xi[i] = xi_arr[i];
+  e = xir_acquire(cosmo, a, status);
+  if (e != NULL) {
+#pragma omp parallel for default(none) shared(n_rp, rp, wp, e, tgl, beta, pi_max)
+    for (i = 0; i < n_rp; i++) {
+      int ip, ig;
+      double sum = 0;
+      double u_max = asinh(pi_max / rp[i]);
+      int n_panels = (int)ceil(u_max / CCL_CORR_WP_DU);
+      for (ip = 0; ip < n_panels; ip++) {
+        double u0 = ip * u_max / n_panels, u1 = (ip + 1) * u_max / n_panels;
+        for (ig = 0; ig < CCL_CORR_WP_NGL; ig++) {
+          double u, w;
+          gsl_integration_glfixed_point(u0, u1, ig, &u, &w, tgl);
+          double pi = rp[i] * sinh(u);
+          double s = rp[i] * cosh(u); // = sqrt(pi^2 + rp^2)
+          sum += w * s * corr3d_rsd_eval(e->spl, beta, s, pi / s);
+        }
+      }
+      wp[i] = 2 * sum;
+    }
+    xir_release(e);
   }
+  gsl_integration_glfixed_table_free(tgl);
 
-  free(mu_arr);
-  free(xi_arr);
-  free(s_arr);
-  
   ccl_check_status(cosmo, status);
 
   return;
@@ -24,6 +24,7 @@ pz_info* ccl_create_photoz_info(void * params,
   pz_info * this_info = malloc(sizeof(pz_info));
   this_info ->your_pz_params = params;
   this_info -> your_pz_func = pz_func;
+  this_info -> your_pz_table = NULL;
   
   return this_info;
 }
@@ -74,6 +75,7 @@ pz_info* ccl_create_gaussian_photoz_info(double sigma_z0){
     pz_info * this_info = malloc(sizeof(pz_info));
     this_info->your_pz_params = sigma_z0_copy;
     this_info->your_pz_func = &gaussian_pz;
+    this_info->your_pz_table = NULL;
     return this_info;
 }
 
@@ -81,11 +83,147 @@ pz_info* ccl_create_gaussian_photoz_info(double sigma_z0){
 INPUT: pz_info my_photoz_info
 TASK: free memory holding the structure containing user-input photoz information */
 
+static void ccl_pz_table_free(pz_table *tab)
+{
+  if(tab!=NULL) {
+    free(tab->pz);
+    free(tab->cdf);
+    free(tab);
+  }
+}
+
 void ccl_free_photoz_info(pz_info *my_photoz_info)
 {
+  ccl_pz_table_free(my_photoz_info->your_pz_table);
   free(my_photoz_info);
 }
 
+/*------ ROUTINE: ccl_photoz_info_tabulate -----
+INPUT: pz_info, tabulation method, true-z and photo-z grids
+TASK:  Sample the photo-z pdf on uniform grids and store it in photo_info, together
+       with its cumulative integral over photo-z (exact for the linearly interpolated pdf).
+*/
+void ccl_photoz_info_tabulate(pz_info *photo_info, int method, int n_zt, double zt_max,
+			      int n_x, double x_min, double x_max, int *status)
+{
+  int it,ix;
+  pz_table *tab;
+
+  if((method!=CCL_PZ_TABLE_GRID) && (method!=CCL_PZ_TABLE_SHIFT_Z) &&
+     (method!=CCL_PZ_TABLE_SHIFT_LOGZ)) {
+    *status = CCL_ERROR_INCONSISTENT;
+    ccl_raise_warning(*status, "ccl_redshifts.c: ccl_photoz_info_tabulate(): unknown tabulation method");
+    return;
+  }
+  if(method!=CCL_PZ_TABLE_GRID)
+    n_zt=1;
+  if((n_x<2) || (x_max<=x_min) ||
+     ((method==CCL_PZ_TABLE_GRID) && ((n_zt<2) || (zt_max<=Z_MIN_SOURCES)))) {
+    *status = CCL_ERROR_INCONSISTENT;
+    ccl_raise_warning(*status, "ccl_redshifts.c: ccl_photoz_info_tabulate(): inconsistent grid");
+    return;
+  }
+
+  tab = malloc(sizeof(pz_table));
+  if(tab==NULL) {
+    *status = CCL_ERROR_MEMORY;
+    return;
+  }
+  tab->method = method;
+  tab->n_zt = n_zt;
+  tab->zt_min = Z_MIN_SOURCES;
+  tab->dzt = (n_zt>1) ? (zt_max-Z_MIN_SOURCES)/(n_zt-1) : 0;
+  tab->n_x = n_x;
+  tab->x_min = x_min;
+  tab->dx = (x_max-x_min)/(n_x-1);
+  tab->pz = malloc(n_zt*n_x*sizeof(double));
+  tab->cdf = malloc(n_zt*n_x*sizeof(double));
+  if((tab->pz==NULL) || (tab->cdf==NULL)) {
+    ccl_pz_table_free(tab);
+    *status = CCL_ERROR_MEMORY;
+    return;
+  }
+
+  // The user function may call back into Python, so this loop stays serial
+  for(it=0; it<n_zt; it++) {
+    double zt = tab->zt_min+it*tab->dzt;
+    double *pz = &(tab->pz[it*n_x]);
+    double *cdf = &(tab->cdf[it*n_x]);
+    for(ix=0; ix<n_x; ix++) {
+      double x = x_min+ix*tab->dx;
+      if(method==CCL_PZ_TABLE_GRID)
+	pz[ix] = photo_info->your_pz_func(x, zt, photo_info->your_pz_params, status);
+      else if(method==CCL_PZ_TABLE_SHIFT_Z)
+	pz[ix] = photo_info->your_pz_func(x, 0., photo_info->your_pz_params, status);
+      else // Density in x=ln(1+z_ph) at z=0
+	pz[ix] = photo_info->your_pz_func(expm1(x), 0., photo_info->your_pz_params, status)*exp(x);
+    }
+    cdf[0] = 0;
+    for(ix=1; ix<n_x; ix++)
+      cdf[ix] = cdf[ix-1]+0.5*tab->dx*(pz[ix-1]+pz[ix]);
+  }
+
+  if(*status) {
+    ccl_pz_table_free(tab);
+    return;
+  }
+
+  ccl_pz_table_free(photo_info->your_pz_table);
+  photo_info->your_pz_table = tab;
+}
+
+/*------ ROUTINE: ccl_pz_table_cdf -----
+INPUT: row of a photo-z table, x
+TASK:  Cumulative integral of the linearly interpolated kernel up to x.
+*/
+static double ccl_pz_table_cdf(pz_table *tab, int it, double x)
+{
+  double *pz = &(tab->pz[it*tab->n_x]);
+  double *cdf = &(tab->cdf[it*tab->n_x]);
+  double u = (x-tab->x_min)/tab->dx;
+  int ix;
+
+  if(u<=0)
+    return 0;
+  if(u>=tab->n_x-1)
+    return cdf[tab->n_x-1];
+
+  ix = (int)u;
+  u -= ix;
+  return cdf[ix]+tab->dx*u*(pz[ix]+0.5*u*(pz[ix+1]-pz[ix]));
+}
+
+/*------ ROUTINE: ccl_pz_table_bin_prob -----
+INPUT: photo-z table, true redshift, bin limits
+TASK:  Probability of the photo-z lying in [bin_zmin,bin_zmax] from the tabulated kernel.
+*/
+static double ccl_pz_table_bin_prob(pz_table *tab, double z, double bin_zmin, double bin_zmax)
+{
+  if(tab->method==CCL_PZ_TABLE_SHIFT_Z)
+    return ccl_pz_table_cdf(tab, 0, bin_zmax-z)-ccl_pz_table_cdf(tab, 0, bin_zmin-z);
+
+  if(tab->method==CCL_PZ_TABLE_SHIFT_LOGZ) {
+    double lz = log1p(z);
+    double c_lo = (bin_zmin<=-1) ? 0 : ccl_pz_table_cdf(tab, 0, log1p(bin_zmin)-lz);
+    double c_hi = (bin_zmax<=-1) ? 0 : ccl_pz_table_cdf(tab, 0, log1p(bin_zmax)-lz);
+    return c_hi-c_lo;
+  }
+
+  // Linear interpolation between the two closest true redshifts
+  double u = (z-tab->zt_min)/tab->dzt;
+  int it;
+  if(u<=0)
+    return ccl_pz_table_cdf(tab, 0, bin_zmax)-ccl_pz_table_cdf(tab, 0, bin_zmin);
+  if(u>=tab->n_zt-1) {
+    it = tab->n_zt-1;
+    return ccl_pz_table_cdf(tab, it, bin_zmax)-ccl_pz_table_cdf(tab, it, bin_zmin);
+  }
+  it = (int)u;
+  u -= it;
+  return (1-u)*(ccl_pz_table_cdf(tab, it, bin_zmax)-ccl_pz_table_cdf(tab, it, bin_zmin))+
+    u*(ccl_pz_table_cdf(tab, it+1, bin_zmax)-ccl_pz_table_cdf(tab, it+1, bin_zmin));
+}
+
 /*------ ROUTINE: ccl_create_dNdz_info ------
 INPUT: void * params, (double *) dNdz_func (double, void *, int*)
 TASK: create a structure amalgamating the information on an analytic true dNdz model.
@@ -154,6 +292,45 @@ void ccl_free_dNdz_info(dNdz_info *my_dNdz_info)
   free(my_dNdz_info);
 }
 
+/*------ ROUTINE: ccl_photoz_bin_prob -----
+INPUT: double z, photometric bin limits, photo-z model
+TASK:  Returns the probability for a galaxy at true redshift z to have a photo-z
+       within [bin_zmin,bin_zmax]. This uses the tabulated pdf if there is one, the
+       closed form for the built-in Gaussian model, and numerical integration of the
+       photo-z pdf otherwise.
+*/
+static double ccl_photoz_bin_prob(double z, double bin_zmin, double bin_zmax,
+				  pz_info * photo_info, int *status)
+{
+  double pz_int=0;
+
+  if(photo_info->your_pz_table!=NULL)
+    return ccl_pz_table_bin_prob(photo_info->your_pz_table, z, bin_zmin, bin_zmax);
+
+  if(photo_info->your_pz_func==&gaussian_pz) {
+    double sigma_z=*((double *)(photo_info->your_pz_params))*(1.+z);
+    return 0.5*(erf((bin_zmax-z)/(M_SQRT2*sigma_z))-erf((bin_zmin-z)/(M_SQRT2*sigma_z)));
+  }
+
+  struct pz_params pz_val_p;
+  pz_val_p.z_true = z;
+  pz_val_p.status = status;
+  pz_val_p.pz_information = photo_info;
+
+  gsl_integration_cquad_workspace * workspace = gsl_integration_cquad_workspace_alloc(ccl_gsl->N_ITERATION);
+  gsl_function F;
+  F.function = ccl_photoz;
+  F.params = &pz_val_p;
+  int gslstatus = gsl_integration_cquad(&F, bin_zmin, bin_zmax, 0.0,ccl_gsl->INTEGRATION_DNDZ_EPSREL,workspace,&pz_int, NULL, NULL);
+  if(gslstatus != GSL_SUCCESS) {
+    ccl_raise_gsl_warning(gslstatus, "ccl_redshifts.c: ccl_photoz_bin_prob():");
+    *status |= gslstatus;
+  }
+  gsl_integration_cquad_workspace_free(workspace);
+
+  return pz_int;
+}
+
 /*------ ROUTINE: ccl_specs_norm_integrand -----
 INPUT: double z_ph, void *params
 TASK:  Returns the integrand which is integrated to get the normalization of 
@@ -172,16 +349,8 @@ struct norm_params {
 
 static double ccl_norm_integrand(double z, void* params)
 {	
-	
-  // This is a struct that contains a true redshift and a pointer to the information about the photo_z model
-  struct pz_params pz_val_p; // parameters for the photoz pdf wrt true-z
-  
-  double pz_int=0; // pointer to the value of the integral over the photoz model
   struct norm_params *p = (struct norm_params *) params; // parameters of the current function (because of form required for gsl integration)
   
-  double z_min = p->bin_zmin_;
-  double z_max = p->bin_zmax_;
-  
   // Check whether ccl_splines and ccl_gsl exist; exit gracefully if they 
   // can't be loaded
   if(ccl_splines==NULL || ccl_gsl==NULL) ccl_cosmology_read_config();
@@ -191,24 +360,41 @@ static double ccl_norm_integrand(double z, void* params)
     return NAN;
   }
   
-  // Set up parameters for the pz part of the intermediary integral.
-  pz_val_p.z_true = z;
-  pz_val_p.status = p->status;
-  pz_val_p.pz_information = p-> pz_information;
-  
-  // Do the intermediary integral over the model relating  photo-z to true-z	
+  // Probability of the photo-z being in the bin at this true redshift
+  double pz_int = ccl_photoz_bin_prob(z, p->bin_zmin_, p->bin_zmax_, p->pz_information, p->status);
+ 
+  return ccl_dNdz(z, p->dN_information, p->status) * pz_int ;
+}
+
+/*------ ROUTINE: ccl_dNdz_tomog_norm -----
+INPUT: tomographic boundaries [bin_zmin,bin_zmax], photo-z model, true dNdz
+TASK:  Returns the normalization of dNdz in a photometric bin,
+       i.e. the integral over true z of dNdz times the probability of being in the bin.
+*/
+static double ccl_dNdz_tomog_norm(double bin_zmin, double bin_zmax,
+				  pz_info * photo_info, dNdz_info * dN_info, int *status)
+{
+  double denom_integrand=0;
+  struct norm_params norm_p_val;
+
+  norm_p_val.bin_zmin_=bin_zmin;
+  norm_p_val.bin_zmax_=bin_zmax;
+  norm_p_val.pz_information = photo_info;
+  norm_p_val.status = status;
+  norm_p_val.dN_information = dN_info;
+
   gsl_integration_cquad_workspace * workspace = gsl_integration_cquad_workspace_alloc(ccl_gsl->N_ITERATION);
   gsl_function F;
-  F.function = ccl_photoz;
-  F.params = &pz_val_p;
-  int gslstatus = gsl_integration_cquad(&F, z_min, z_max, 0.0,ccl_gsl->INTEGRATION_DNDZ_EPSREL,workspace,&pz_int, NULL, NULL);
+  F.function = ccl_norm_integrand;
+  F.params = &norm_p_val;
+  int gslstatus = gsl_integration_cquad(&F, Z_MIN_SOURCES, Z_MAX_SOURCES, 0.0,ccl_gsl->INTEGRATION_DNDZ_EPSREL,workspace,&denom_integrand, NULL, NULL);
   if(gslstatus != GSL_SUCCESS) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_redshifts.c: ccl_specs_norm_integrand():");
-    *p->status|= gslstatus;
+    ccl_raise_gsl_warning(gslstatus, "ccl_redshifts.c: ccl_norm_integrand():");
+    *status |= gslstatus;
   }
   gsl_integration_cquad_workspace_free(workspace);
- 
-  return ccl_dNdz(z, p->dN_information, p->status) * pz_int ;
+
+  return denom_integrand;
 }
 
 /*------ ROUTINE: ccl_specs_dNdz_tomog -----
@@ -224,9 +410,6 @@ void ccl_dNdz_tomog(double z, double bin_zmin, double bin_zmax,
 {	
   // This uses equation 33 of Joachimi & Schneider 2009, arxiv:0905.0393
   double numerator_integrand=0, denom_integrand=0, dNdz_t;
-  // This struct contains a spec redshift and a pointer to a photoz information struct.
-  struct pz_params pz_p_val; //parameters for the integral over the photoz's
-  struct norm_params norm_p_val;	
   
   // Check whether ccl_splines and ccl_gsl exist; exit gracefully if they 
   // can't be loaded
@@ -238,43 +421,14 @@ void ccl_dNdz_tomog(double z, double bin_zmin, double bin_zmax,
     return;
   }
   
-  // Set up the parameters to pass to the normalising integral (of type struct norm_params
-  norm_p_val.bin_zmin_=bin_zmin;
-  norm_p_val.bin_zmax_=bin_zmax;
-  norm_p_val.pz_information = photo_info;	
-  norm_p_val.status = status;
-  norm_p_val.dN_information = dN_info;
-  
   dNdz_t = ccl_dNdz(z, dN_info, status);
   
-  // Set up the parameters for the integral over the photo z function in the numerator (of type struct pz_params)
-  pz_p_val.z_true = z;
-  pz_p_val.status = status;
-  pz_p_val.pz_information = photo_info; // pointer to user information
- 
   // Integrate over the assumed pdf of photo-z wrt true-z in this bin (this goes in the numerator of the result):
-  gsl_integration_cquad_workspace * workspace = gsl_integration_cquad_workspace_alloc(ccl_gsl->N_ITERATION);
-  gsl_function F;
-  F.function = ccl_photoz;
-  F.params = &pz_p_val;
-  int gslstatus = gsl_integration_cquad(&F, bin_zmin, bin_zmax, 0.0,ccl_gsl->INTEGRATION_DNDZ_EPSREL,workspace,&numerator_integrand, NULL, NULL);
-  if(gslstatus != GSL_SUCCESS) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_redshifts.c: ccl_norm_integrand():");
-    *status |= gslstatus;
-  } 
-  gsl_integration_cquad_workspace_free(workspace);	
+  numerator_integrand = ccl_photoz_bin_prob(z, bin_zmin, bin_zmax, photo_info, status);
   
   // Now get the denominator, which normalizes dNdz over the photometric bin
-  workspace = gsl_integration_cquad_workspace_alloc(ccl_gsl->N_ITERATION);
-  F.function = ccl_norm_integrand;
-  F.params = &norm_p_val;
-  gslstatus = gsl_integration_cquad(&F, Z_MIN_SOURCES, Z_MAX_SOURCES, 0.0,ccl_gsl->INTEGRATION_DNDZ_EPSREL,workspace,&denom_integrand, NULL, NULL);
-  if(gslstatus != GSL_SUCCESS) {
-    ccl_raise_gsl_warning(gslstatus, "ccl_redshifts.c: ccl_norm_integrand():");
-    *status |= gslstatus;
-  }
+  denom_integrand = ccl_dNdz_tomog_norm(bin_zmin, bin_zmax, photo_info, dN_info, status);
    
-  gsl_integration_cquad_workspace_free(workspace);
   if (*status) {
     *status = CCL_ERROR_INTEG;
     return;
@@ -282,3 +436,201 @@ void ccl_dNdz_tomog(double z, double bin_zmin, double bin_zmax,
   *tomoout = dNdz_t * numerator_integrand / denom_integrand;
 
 }
+
+/*------ ROUTINE: ccl_dNdz_tomog_multi -----
+INPUT: redshifts, number of bins, bin edges, photo-z model, true dNdz
+TASK:  dNdz in several tomographic bins [bin_edges[i],bin_edges[i+1]], evaluated
+       at all the input redshifts. The normalization of each bin is computed once.
+       The output for bin i at z[j] is tomoout[i*n_z+j].
+*/
+void ccl_dNdz_tomog_multi(int n_z, double *z, int n_bins, double *bin_edges,
+			  pz_info * photo_info, dNdz_info * dN_info, double *tomoout, int *status)
+{
+  int ib,iz;
+  double *dNdz_t;
+
+  if(ccl_splines==NULL || ccl_gsl==NULL) ccl_cosmology_read_config();
+  if(ccl_splines==NULL || ccl_gsl==NULL) {
+    ccl_raise_exception(CCL_ERROR_MISSING_CONFIG_FILE, 
+                        "ccl_redshifts.c: Failed to read config file.");
+    *status = CCL_ERROR_MISSING_CONFIG_FILE;
+    return;
+  }
+
+  dNdz_t = malloc(n_z*sizeof(double));
+  if(dNdz_t == NULL) {
+    *status = CCL_ERROR_MEMORY;
+    return;
+  }
+
+  // The true dNdz does not depend on the bin
+  for(iz=0; iz<n_z; iz++)
+    dNdz_t[iz] = ccl_dNdz(z[iz], dN_info, status);
+
+  for(ib=0; (ib<n_bins) && (*status==0); ib++) {
+    double norm = ccl_dNdz_tomog_norm(bin_edges[ib], bin_edges[ib+1], photo_info, dN_info, status);
+    for(iz=0; (iz<n_z) && (*status==0); iz++)
+      tomoout[ib*n_z+iz] = dNdz_t[iz] *
+	ccl_photoz_bin_prob(z[iz], bin_edges[ib], bin_edges[ib+1], photo_info, status) / norm;
+  }
+
+  free(dNdz_t);
+  if (*status)
+    *status = CCL_ERROR_INTEG;
+}
+
+/*------ ROUTINE: ccl_dNdz_sampler_free -----
+INPUT: dNdz_sampler
+TASK:  Free a redshift sampler.
+*/
+void ccl_dNdz_sampler_free(dNdz_sampler *sampler)
+{
+  if(sampler!=NULL) {
+    free(sampler->pdf);
+    free(sampler->cdf);
+    free(sampler->guide);
+    free(sampler);
+  }
+}
+
+/*------ ROUTINE: ccl_dNdz_sampler_new -----
+INPUT: true dNdz, photo-z model (or NULL) and bin, redshift grid
+TASK:  Tabulate a redshift distribution and its cumulative integral (exact for the
+       linearly interpolated distribution), and build the guide table used to invert it.
+*/
+dNdz_sampler *ccl_dNdz_sampler_new(dNdz_info *dN_info, pz_info *photo_info,
+				   double bin_zmin, double bin_zmax,
+				   int n_z, double z_min, double z_max, int *status)
+{
+  int iz,k;
+  double norm;
+  dNdz_sampler *sampler;
+
+  if((n_z<2) || (z_max<=z_min)) {
+    *status = CCL_ERROR_INCONSISTENT;
+    ccl_raise_warning(*status, "ccl_redshifts.c: ccl_dNdz_sampler_new(): inconsistent redshift grid");
+    return NULL;
+  }
+  if((photo_info!=NULL) && (photo_info->your_pz_table==NULL) &&
+     (photo_info->your_pz_func!=&gaussian_pz)) {
+    // The bin probability needs numerical integration
+    if(ccl_splines==NULL || ccl_gsl==NULL) ccl_cosmology_read_config();
+    if(ccl_splines==NULL || ccl_gsl==NULL) {
+      ccl_raise_exception(CCL_ERROR_MISSING_CONFIG_FILE, 
+                          "ccl_redshifts.c: Failed to read config file.");
+      *status = CCL_ERROR_MISSING_CONFIG_FILE;
+      return NULL;
+    }
+  }
+
+  sampler = malloc(sizeof(dNdz_sampler));
+  if(sampler==NULL) {
+    *status = CCL_ERROR_MEMORY;
+    return NULL;
+  }
+  sampler->n_z = n_z;
+  sampler->z_min = z_min;
+  sampler->dz = (z_max-z_min)/(n_z-1);
+  sampler->pdf = malloc(n_z*sizeof(double));
+  sampler->cdf = malloc(n_z*sizeof(double));
+  sampler->guide = malloc(n_z*sizeof(int));
+  if((sampler->pdf==NULL) || (sampler->cdf==NULL) || (sampler->guide==NULL)) {
+    ccl_dNdz_sampler_free(sampler);
+    *status = CCL_ERROR_MEMORY;
+    return NULL;
+  }
+
+  // The user functions may call back into Python, so this loop stays serial
+  for(iz=0; iz<n_z; iz++) {
+    double z = z_min+iz*sampler->dz;
+    double p = ccl_dNdz(z, dN_info, status);
+    if(photo_info!=NULL)
+      p *= ccl_photoz_bin_prob(z, bin_zmin, bin_zmax, photo_info, status);
+    if(!(p>=0))
+      *status = CCL_ERROR_INCONSISTENT;
+    sampler->pdf[iz] = p;
+  }
+
+  sampler->cdf[0] = 0;
+  for(iz=1; iz<n_z; iz++)
+    sampler->cdf[iz] = sampler->cdf[iz-1]+0.5*sampler->dz*(sampler->pdf[iz-1]+sampler->pdf[iz]);
+  norm = sampler->cdf[n_z-1];
+  if(!(norm>0))
+    *status = CCL_ERROR_INCONSISTENT;
+
+  if(*status) {
+    ccl_raise_warning(*status, "ccl_redshifts.c: ccl_dNdz_sampler_new(): "
+		      "redshift distribution is negative or vanishes");
+    ccl_dNdz_sampler_free(sampler);
+    return NULL;
+  }
+
+  for(iz=0; iz<n_z; iz++) {
+    sampler->pdf[iz] /= norm;
+    sampler->cdf[iz] /= norm;
+  }
+  sampler->cdf[n_z-1] = 1;
+
+  // Guide table: guide[k] is the last node with cdf <= k/n_z
+  iz = 0;
+  for(k=0; k<n_z; k++) {
+    double u = (double)k/n_z;
+    while((iz<n_z-2) && (sampler->cdf[iz+1]<=u))
+      iz++;
+    sampler->guide[k] = iz;
+  }
+
+  return sampler;
+}
+
+/*------ ROUTINE: ccl_dNdz_sampler_draw -----
+INPUT: redshift sampler, uniform deviates
+TASK:  Map uniform deviates onto redshifts by inverting the cumulative distribution.
+       Within each interval the distribution is linear, so the cumulative distribution
+       is quadratic and is inverted exactly.
+*/
+void ccl_dNdz_sampler_draw(dNdz_sampler *sampler, int n, double *u, double *z_out, int *status)
+{
+  int i, n_bad = 0;
+  int n_z = sampler->n_z;
+  double dz = sampler->dz;
+  double *pdf = sampler->pdf;
+  double *cdf = sampler->cdf;
+  int *guide = sampler->guide;
+
+#pragma omp parallel for default(none) shared(n,u,z_out,sampler,n_z,dz,pdf,cdf,guide) \
+                         reduction(+:n_bad) schedule(static)
+  for(i=0; i<n; i++) {
+    double ui = u[i];
+    int k, iz;
+    double p0, dp, delta, disc, t;
+
+    // Written so that NaNs are caught too
+    if(!((ui>=0) && (ui<=1))) n_bad++;
+    if(!(ui>0)) ui = 0;
+    if(ui>=1) ui = 1;
+
+    k = (int)(ui*n_z);
+    if(k>=n_z) k = n_z-1;
+    iz = guide[k];
+    while((iz<n_z-2) && (cdf[iz+1]<=ui))
+      iz++;
+
+    // Solve p0*t+0.5*dp*t^2 = delta (in units of dz) in the stable form
+    p0 = pdf[iz];
+    dp = pdf[iz+1]-pdf[iz];
+    delta = (ui-cdf[iz])/dz;
+    disc = p0*p0+2*dp*delta;
+    if(disc<0) disc = 0;
+    t = (delta>0) ? 2*delta/(p0+sqrt(disc)) : 0;
+    if(!(t<=1)) t = 1;
+
+    z_out[i] = sampler->z_min+(iz+t)*dz;
+  }
+
+  if(n_bad>0) {
+    *status = CCL_ERROR_INCONSISTENT;
+    ccl_raise_warning(*status, "ccl_redshifts.c: ccl_dNdz_sampler_draw(): "
+		      "%d deviates outside [0,1] were clamped", n_bad);
+  }
+}
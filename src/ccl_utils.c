@@ -149,11 +149,10 @@ SplPar *ccl_spline_init(int n,double *x,double *y,double y0,double yf)
   if(spl==NULL)
     return NULL;
 
-  spl->intacc=gsl_interp_accel_alloc();
+  spl->intacc=NULL;
   spl->spline=gsl_spline_alloc(gsl_interp_cspline,n);
   int parstatus=gsl_spline_init(spl->spline,x,y,n);
   if(parstatus) {
-    gsl_interp_accel_free(spl->intacc);
     gsl_spline_free(spl->spline);
     return NULL;
   }
@@ -175,7 +174,8 @@ double ccl_spline_eval(double x,SplPar *spl)
     return spl->yf;
   else {
     double y;
-    int stat=gsl_spline_eval_e(spl->spline,x,spl->intacc,&y);
+    //No accelerator is used, so that splines can be evaluated from several threads
+    int stat=gsl_spline_eval_e(spl->spline,x,NULL,&y);
     if (stat!=GSL_SUCCESS) {
       ccl_raise_gsl_warning(stat, "ccl_utils.c: ccl_splin_eval():");
       return NAN;
@@ -316,6 +316,5 @@ double ccl_j_bessel(int l,double x)
 void ccl_spline_free(SplPar *spl)
 {
   gsl_spline_free(spl->spline);
-  gsl_interp_accel_free(spl->intacc);
   free(spl);
 }
@@ -1,7 +1,11 @@
 #include <stdlib.h>
 #include <math.h>
+#include <complex.h>
 
 #include <fftw3.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "fftlog.h"
 
@@ -11,8 +15,11 @@
 
 /* This code is FFTLog, which is described in arXiv:astro-ph/9905191 */
 
-/* Computes the Gamma function using the Lanczos approximation */
-static double complex gamma_fftlog(double complex z)
+/* Computes the logarithm of the Gamma function using the Lanczos approximation.
+ * This is done in log space, since Gamma(z) overflows for the large
+ * values of Re(z) needed by high-order transforms. Only the value of the
+ * imaginary part modulo 2*pi is meaningful. */
+static double complex lngamma_fftlog(double complex z)
 {
   /* Lanczos coefficients for g = 7 */
   static double p[] = {
@@ -26,15 +33,20 @@ static double complex gamma_fftlog(double complex z)
     9.984369578019570859563e-6,
     1.50563273514931155834e-7
   };
-  
-  if(creal(z) < 0.5)
-    return M_PI / (sin(M_PI*z)*gamma_fftlog(1. - z));
+
+  if(cimag(z) < 0)
+    return conj(lngamma_fftlog(conj(z)));
+  if(creal(z) < 0.5) {
+    /* Reflection formula. log(sin(pi*z)) is written so that it doesn't overflow for large Im(z) */
+    double complex lnsin = -I*M_PI*z + clog((cexp(2*I*M_PI*z) - 1.)/(2*I));
+    return log(M_PI) - lnsin - lngamma_fftlog(1. - z);
+  }
   z -= 1;
   double complex x = p[0];
   for(int n = 1; n < 9; n++)
     x += p[n] / (z + (double)(n));
   double complex t = z + 7.5;
-  return sqrt(2*M_PI) * cpow(t, z+0.5) * cexp(-t) * x;
+  return 0.5*log(2*M_PI) + (z+0.5)*clog(t) - t + clog(x);
 }
 
 static double complex polar (double r, double phi)
@@ -42,12 +54,6 @@ static double complex polar (double r, double phi)
   return (r*cos(phi) +I*(r*sin(phi)));
 }
 
-static double complex lngamma_fftlog(double complex z)
-{
-  return clog(gamma_fftlog(z));
-}
-
-
 static void lngamma_4(double x, double y, double* lnr, double* arg)
 {
   double complex w = lngamma_fftlog(x+y*I);
@@ -70,7 +76,8 @@ static double goodkr(int N, double mu, double q, double L, double kr)
   return kr;
 }
 
-void compute_u_coefficients(int N, double mu, double q, double L, double kcrc, double complex u[])
+/* Computes the first N/2+1 u coefficients, which are all that is needed for real inputs */
+static void compute_u_coefficients_half(int N, double mu, double q, double L, double kcrc, double complex u[])
 {
   double y = M_PI/L;
   double k0r0 = kcrc * exp(-L);
@@ -94,13 +101,18 @@ void compute_u_coefficients(int N, double mu, double q, double L, double kcrc, d
       u[m] = polar(exp(q*log(2) + lnrp - lnrm), m*t + phip - phim);
     }
   }
-  
-  for(int m = N/2+1; m < N; m++)
-    u[m] = conj(u[N-m]);
+
   if((N % 2) == 0)
     u[N/2] = (creal(u[N/2]) + I*0.0);
 }
 
+void compute_u_coefficients(int N, double mu, double q, double L, double kcrc, double complex u[])
+{
+  compute_u_coefficients_half(N, mu, q, L, kcrc, u);
+  for(int m = N/2+1; m < N; m++)
+    u[m] = conj(u[N-m]);
+}
+
 void fht(int N, const double r[], const double complex a[], double k[], double complex b[], double mu,
          double q, double kcrc, int noring, double complex* u)
 {
@@ -115,21 +127,28 @@ void fht(int N, const double r[], const double complex a[], double k[], double c
   }
   
   /* Compute the convolution b = a*u using FFTs */
-  fftw_plan forward_plan = fftw_plan_dft_1d(N, (fftw_complex*) a, (fftw_complex*) b,  -1, FFTW_ESTIMATE);
-  fftw_plan reverse_plan = fftw_plan_dft_1d(N, (fftw_complex*) b, (fftw_complex*) b, +1, FFTW_ESTIMATE);
+  fftw_plan forward_plan, reverse_plan;
+#pragma omp critical
+  {
+    forward_plan = fftw_plan_dft_1d(N, (fftw_complex*) a, (fftw_complex*) b,  -1, FFTW_ESTIMATE);
+    reverse_plan = fftw_plan_dft_1d(N, (fftw_complex*) b, (fftw_complex*) b, +1, FFTW_ESTIMATE);
+  }
   fftw_execute(forward_plan);
   for(int m = 0; m < N; m++)
     b[m] *= u[m] / (double)(N);       // divide by N since FFTW doesn't normalize the inverse FFT
   fftw_execute(reverse_plan);
-  fftw_destroy_plan(forward_plan);
-  fftw_destroy_plan(reverse_plan);
+#pragma omp critical
+  {
+    fftw_destroy_plan(forward_plan);
+    fftw_destroy_plan(reverse_plan);
+  }
   
-  /* Reverse b array */
+  /* Reverse b array: the transform at k[n] is stored in b[(N-n)%N] */
   double complex tmp;
-  for(int n = 0; n < N/2; n++) {
+  for(int n = 1; n < (N+1)/2; n++) {
     tmp = b[n];
-    b[n] = b[N-n-1];
-    b[N-n-1] = tmp;
+    b[n] = b[N-n];
+    b[N-n] = tmp;
   }
   
   /* Compute k's corresponding to input r's */
@@ -141,48 +160,320 @@ void fht(int N, const double r[], const double complex a[], double k[], double c
   free(ulocal);
 }
 
-void fftlog_ComputeXi2D(double bessel_order,int N,const double l[],const double cl[],
+/* Transforms of real functions are done with real-to-complex FFTs. Since the
+ * u coefficients satisfy u[N-m] = conj(u[m]), only the first N/2+1 are kept. */
+struct fftlog_plan_s {
+  int N;
+  double mu, q, L, kcrc_in;
+  int noring;
+  double kcrc;
+  double complex* u;
+  double* a;
+  double complex* c;
+  fftw_plan plan_r2c;
+  fftw_plan plan_c2r;
+};
+
+#ifdef HAVE_FFTW_OMP
+/* Transforms smaller than this are planned single-threaded */
+#define FFTLOG_THREADS_MIN_N 65536
+static int fftlog_threads_ready = 0;
+#endif //HAVE_FFTW_OMP
+
+/* Set the number of threads used by the next FFTW plans, for transforms of
+ * total size N. Returns the previous setting, which must be passed to
+ * fftlog_plan_threads_restore once the plans are made, so that plans made
+ * elsewhere are not affected. Both must be called from the critical section
+ * where the plans are made. Without fftw_planner_nthreads (FFTW < 3.3.9) the
+ * previous setting is assumed to be FFTW's default of one thread. */
+static int fftlog_plan_threads(int N)
+{
+  int nthreads_prev = 1;
+#ifdef HAVE_FFTW_OMP
+  if(!fftlog_threads_ready)
+    fftlog_threads_ready = fftw_init_threads() ? 1 : -1;
+  if(fftlog_threads_ready > 0) {
+#ifdef HAVE_FFTW_PLANNER_NTHREADS
+    nthreads_prev = fftw_planner_nthreads();
+#endif //HAVE_FFTW_PLANNER_NTHREADS
+    if((N >= FFTLOG_THREADS_MIN_N) && (!omp_in_parallel()))
+      fftw_plan_with_nthreads(omp_get_max_threads());
+    else
+      fftw_plan_with_nthreads(1);
+  }
+#endif //HAVE_FFTW_OMP
+  return nthreads_prev;
+}
+
+static void fftlog_plan_threads_restore(int nthreads_prev)
+{
+#ifdef HAVE_FFTW_OMP
+  if(fftlog_threads_ready > 0)
+    fftw_plan_with_nthreads(nthreads_prev);
+#endif //HAVE_FFTW_OMP
+}
+
+fftlog_plan* fftlog_plan_new(int N, double mu, double q, double L, double kcrc, int noring)
+{
+  fftlog_plan* p = malloc(sizeof(fftlog_plan));
+  if(p == NULL)
+    return NULL;
+
+  p->N = N;
+  p->mu = mu;
+  p->q = q;
+  p->L = L;
+  p->kcrc_in = kcrc;
+  p->noring = noring;
+  p->plan_r2c = NULL;
+  p->plan_c2r = NULL;
+  p->u = malloc(sizeof(double complex)*(N/2+1));
+  p->a = fftw_malloc(sizeof(double)*N);
+  p->c = fftw_malloc(sizeof(double complex)*(N/2+1));
+  if((p->u == NULL) || (p->a == NULL) || (p->c == NULL)) {
+    fftlog_plan_free(p);
+    return NULL;
+  }
+
+  if(noring)
+    kcrc = goodkr(N, mu, q, L, kcrc);
+  p->kcrc = kcrc;
+  compute_u_coefficients_half(N, mu, q, L, kcrc, p->u);
+
+  /* FFTW planning is not thread-safe */
+#pragma omp critical
+  {
+    int nthreads_prev = fftlog_plan_threads(N);
+    p->plan_r2c = fftw_plan_dft_r2c_1d(N, p->a, (fftw_complex*) p->c, FFTW_ESTIMATE);
+    p->plan_c2r = fftw_plan_dft_c2r_1d(N, (fftw_complex*) p->c, p->a, FFTW_ESTIMATE);
+    fftlog_plan_threads_restore(nthreads_prev);
+  }
+  if((p->plan_r2c == NULL) || (p->plan_c2r == NULL)) {
+    fftlog_plan_free(p);
+    return NULL;
+  }
+
+  return p;
+}
+
+void fftlog_plan_free(fftlog_plan* p)
+{
+  if(p == NULL)
+    return;
+#pragma omp critical
+  {
+    if(p->plan_r2c != NULL)
+      fftw_destroy_plan(p->plan_r2c);
+    if(p->plan_c2r != NULL)
+      fftw_destroy_plan(p->plan_c2r);
+  }
+  fftw_free(p->a);
+  fftw_free(p->c);
+  free(p->u);
+  free(p);
+}
+
+void fftlog_plan_execute(fftlog_plan* p, const double r[], const double a[], double k[], double b[])
+{
+  int N = p->N;
+
+  /* Compute the convolution b = a*u using FFTs */
+  for(int n = 0; n < N; n++)
+    p->a[n] = a[n];
+  fftw_execute(p->plan_r2c);
+  for(int m = 0; m <= N/2; m++)
+    p->c[m] *= p->u[m] / (double)(N);   // divide by N since FFTW doesn't normalize the inverse FFT
+  fftw_execute(p->plan_c2r);
+
+  /* The transform at k[n] is stored in element (N-n)%N */
+  b[0] = p->a[0];
+  for(int n = 1; n < N; n++)
+    b[n] = p->a[N-n];
+
+  /* Compute k's corresponding to input r's */
+  k[0] = p->kcrc * exp(-p->L) / r[0];
+  for(int n = 1; n < N; n++)
+    k[n] = k[0] * exp(n*p->L/N);
+}
+
+/* Plans used by the functions below, kept per thread so that their buffers are never shared.
+ * Slots are reused in round-robin order. */
+#define FFTLOG_PLAN_CACHE_SIZE 8
+static fftlog_plan* fftlog_plan_cache[FFTLOG_PLAN_CACHE_SIZE];
+static int fftlog_plan_cache_next = 0;
+#pragma omp threadprivate(fftlog_plan_cache, fftlog_plan_cache_next)
+
+fftlog_plan* fftlog_plan_get(int N, double mu, double q, double L, double kcrc, int noring)
+{
+  for(int i = 0; i < FFTLOG_PLAN_CACHE_SIZE; i++) {
+    fftlog_plan* p = fftlog_plan_cache[i];
+    if((p != NULL) && (p->N == N) && (p->mu == mu) && (p->q == q) && (p->L == L) &&
+       (p->kcrc_in == kcrc) && (p->noring == noring))
+      return p;
+  }
+
+  fftlog_plan* p = fftlog_plan_new(N, mu, q, L, kcrc, noring);
+  if(p == NULL)
+    return NULL;
+  fftlog_plan_free(fftlog_plan_cache[fftlog_plan_cache_next]);
+  fftlog_plan_cache[fftlog_plan_cache_next] = p;
+  fftlog_plan_cache_next = (fftlog_plan_cache_next + 1) % FFTLOG_PLAN_CACHE_SIZE;
+  return p;
+}
+
+void fftlog_plan_cache_clear(void)
+{
+  for(int i = 0; i < FFTLOG_PLAN_CACHE_SIZE; i++) {
+    fftlog_plan_free(fftlog_plan_cache[i]);
+    fftlog_plan_cache[i] = NULL;
+  }
+  fftlog_plan_cache_next = 0;
+}
+
+void fftlog_plan_cache_clear_all(void)
+{
+#ifdef _OPENMP
+  if(omp_in_parallel()) {
+    fftlog_plan_cache_clear();
+    return;
+  }
+#pragma omp parallel num_threads(omp_get_max_threads())
+  fftlog_plan_cache_clear();
+#else //_OPENMP
+  fftlog_plan_cache_clear();
+#endif //_OPENMP
+}
+
+int fftlog_ComputeXi2D(double bessel_order,int N,const double l[],const double cl[],
 			double th[], double xi[])
 {
-  double complex* a = malloc(sizeof(complex double)*N);
-  double complex* b = malloc(sizeof(complex double)*N);
+  double L = log(l[N-1]/l[0]) * N/(N-1.);
+  fftlog_plan* p = fftlog_plan_get(N, bessel_order, 0, L, 1, 1);
+  double* a = malloc(sizeof(double)*N);
+  if((p == NULL) || (a == NULL)) {
+    free(a);
+    return 1;
+  }
   
   for(int i=0;i<N;i++)
     a[i]=l[i]*cl[i];
-  fht(N,l,a,th,b,bessel_order,0,1,1,NULL);
+  fftlog_plan_execute(p,l,a,th,xi);
   for(int i=0;i<N;i++)
-    xi[i]=creal(b[i]/(2*M_PI*th[i]));
+    xi[i]/=(2*M_PI*th[i]);
   
   free(a);
-  free(b);
+  return 0;
+}
+
+int fftlog_ComputeXi2D_many(int n_orders, const double bessel_order[], int n_cl, int N,
+                            const double l[], const double cl[], double th[], double xi[])
+{
+  int status = 0;
+  int Nc = N/2+1;
+  double L = log(l[N-1]/l[0]) * N/(N-1.);
+  fftw_plan plan_r2c = NULL, plan_c2r = NULL;
+  double* a = fftw_malloc(sizeof(double)*N*n_cl);
+  double complex* c = fftw_malloc(sizeof(double complex)*Nc*n_cl);
+  double complex* cu = fftw_malloc(sizeof(double complex)*Nc*n_cl);
+  if((a == NULL) || (c == NULL) || (cu == NULL))
+    status = 1;
+
+  /* One multi-transform for all the spectra, in and out of contiguous blocks */
+  if(status == 0) {
+#pragma omp critical
+    {
+      int nthreads_prev = fftlog_plan_threads(N*n_cl);
+      plan_r2c = fftw_plan_many_dft_r2c(1, &N, n_cl, a, NULL, 1, N,
+                                        (fftw_complex*) c, NULL, 1, Nc, FFTW_ESTIMATE);
+      plan_c2r = fftw_plan_many_dft_c2r(1, &N, n_cl, (fftw_complex*) cu, NULL, 1, Nc,
+                                        a, NULL, 1, N, FFTW_ESTIMATE);
+      fftlog_plan_threads_restore(nthreads_prev);
+    }
+    if((plan_r2c == NULL) || (plan_c2r == NULL))
+      status = 1;
+  }
+
+  /* The forward transforms do not depend on the Bessel order */
+  if(status == 0) {
+    for(int i = 0; i < n_cl; i++) {
+      for(int n = 0; n < N; n++)
+        a[i*N+n] = l[n]*cl[i*N+n];
+    }
+    fftw_execute(plan_r2c);
+  }
+
+  for(int io = 0; (io < n_orders) && (status == 0); io++) {
+    /* The u coefficients are taken from the cached plan for this order */
+    fftlog_plan* p = fftlog_plan_get(N, bessel_order[io], 0, L, 1, 1);
+    if(p == NULL) {
+      status = 1;
+      break;
+    }
+    for(int i = 0; i < n_cl; i++) {
+      for(int m = 0; m < Nc; m++)
+        cu[i*Nc+m] = c[i*Nc+m] * p->u[m] / (double)(N);
+    }
+    fftw_execute(plan_c2r);
+
+    double* th_o = &(th[io*N]);
+    th_o[0] = p->kcrc * exp(-L) / l[0];
+    for(int n = 1; n < N; n++)
+      th_o[n] = th_o[0] * exp(n*L/N);
+    for(int i = 0; i < n_cl; i++) {
+      double* xi_o = &(xi[(io*n_cl+i)*N]);
+      /* The transform at th[n] is stored in element (N-n)%N */
+      xi_o[0] = a[i*N] / (2*M_PI*th_o[0]);
+      for(int n = 1; n < N; n++)
+        xi_o[n] = a[i*N+N-n] / (2*M_PI*th_o[n]);
+    }
+  }
+
+#pragma omp critical
+  {
+    if(plan_r2c != NULL)
+      fftw_destroy_plan(plan_r2c);
+    if(plan_c2r != NULL)
+      fftw_destroy_plan(plan_c2r);
+  }
+  fftw_free(a);
+  fftw_free(c);
+  fftw_free(cu);
+  return status;
 }
 
-void fftlog_ComputeXiLM(double l, double m, int N, const double k[], const double pk[], 
+int fftlog_ComputeXiLM(double l, double m, int N, const double k[], const double pk[], 
 			double r[], double xi[])
 {
-  double complex* a = malloc(sizeof(complex double)*N);
-  double complex* b = malloc(sizeof(complex double)*N);
+  double L = log(k[N-1]/k[0]) * N/(N-1.);
+  fftlog_plan* p = fftlog_plan_get(N, l + 0.5, 0, L, 1, 1);
+  double* a = malloc(sizeof(double)*N);
+  if((p == NULL) || (a == NULL)) {
+    free(a);
+    return 1;
+  }
   
   for(int i = 0; i < N; i++)
     a[i] = pow(k[i], m - 0.5) * pk[i];
-  fht(N, k, a, r, b, l + 0.5, 0, 1, 1, NULL);
+  fftlog_plan_execute(p, k, a, r, xi);
   for(int i = 0; i < N; i++)
-    xi[i] = creal(pow(2*M_PI*r[i], -(m-0.5)) * b[i]);
+    xi[i] *= pow(2*M_PI*r[i], -(m-0.5));
   
   free(a);
-  free(b);
+  return 0;
 }
 
-void pk2xi(int N, const double k[], const double pk[], double r[], double xi[])
+int pk2xi(int N, const double k[], const double pk[], double r[], double xi[])
 {
-  fftlog_ComputeXiLM(0, 2, N, k, pk, r, xi);
+  return fftlog_ComputeXiLM(0, 2, N, k, pk, r, xi);
 }
 
-void xi2pk(int N, const double r[], const double xi[], double k[], double pk[])
+int xi2pk(int N, const double r[], const double xi[], double k[], double pk[])
 {
   static const double TwoPiCubed = 8*M_PI*M_PI*M_PI;
-  fftlog_ComputeXiLM(0, 2, N, r, xi, k, pk);
+  if(fftlog_ComputeXiLM(0, 2, N, r, xi, k, pk))
+    return 1;
   for(int j = 0; j < N; j++)
     pk[j] *= TwoPiCubed;
+  return 0;
 }
 
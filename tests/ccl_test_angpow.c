@@ -2,6 +2,7 @@
 #include "ctest.h"
 #include <stdio.h>
 #include <math.h>
+#include <gsl/gsl_sf_bessel.h>
 
 #define NZ 1024
 #define Z0_GC 1.0 
@@ -10,6 +11,18 @@
 
 #define CLS_PRECISION 3E-3 
 
+//Native non-Limber power spectra of lensing-like tracers
+#define Z0_WL 1.0
+#define SZ_WL 0.15
+#define NL_NATIVE 301
+#define L_LIMBER_CHECK 100
+#define NATIVE_LIMBER_PRECISION 1E-2
+#define NATIVE_BRUTE_PRECISION 2E-2
+#define NK_BRUTE 800
+#define NCHI_BRUTE 1500
+#define KMIN_BRUTE 1E-5
+#define KMAX_BRUTE 0.3
+
 CTEST_DATA(angpow) {
   double Omega_c;
   double Omega_b;
@@ -47,7 +60,7 @@ CTEST_SETUP(angpow){
 
 
 
-static void test_angpow_precision(struct angpow_data * data)
+static void test_angpow_precision(int nonlimber_method,struct angpow_data * data)
 {
   // Status flag
   int status =0;
@@ -89,6 +102,7 @@ static void test_angpow_precision(struct angpow_data * data)
   double logstep = 1.15;
   double dchi = (ct_gc_A->chimax-ct_gc_A->chimin)/1000.; 
   CCL_ClWorkspace *wap=ccl_cl_workspace_new(NL+1,2*ells[NL-1],logstep,linstep,&status);
+  wap->nonlimber_method=nonlimber_method;
   
   // Compute C_ell
   ccl_angular_cls(ccl_cosmo,wap,ct_gc_A,ct_gc_A,NL,ells,cells_gg_angpow,&status);
@@ -117,5 +131,129 @@ static void test_angpow_precision(struct angpow_data * data)
 }
 
 CTEST2(angpow,precision) {
-  test_angpow_precision(data);
+  test_angpow_precision(ccl_nonlimber_angpow,data);
+}
+
+CTEST2(angpow,native) {
+  test_angpow_precision(ccl_nonlimber_native,data);
+}
+
+//Brute-force non-Limber power spectrum of the lensing-like term of a tracer
+//   C_l = 2/pi Int dk k^2 P_L(k,z=0) Delta_l(k)^2,
+//   Delta_l(k) = f_l Int dchi K(chi) D(chi) j_l(k*chi)/(k*chi)^2,
+//where K is the lensing-like kernel of the tracer and f_l its ell-dependent prefactor.
+static double brute_force_cl_lensing(ccl_cosmology *cosmo,CCL_ClTracer *clt,int l,double f_l,int *status)
+{
+  double kernel[NCHI_BRUTE];
+  double chi_lo=clt->spl_kl->x0;
+  double dchi=(clt->chimax-chi_lo)/(NCHI_BRUTE-1);
+  double dlk=log(KMAX_BRUTE/KMIN_BRUTE)/(NK_BRUTE-1);
+  double cl=0;
+
+  for(int ic=0;ic<NCHI_BRUTE;ic++) {
+    double chi=chi_lo+ic*dchi;
+    double a=ccl_scale_factor_of_chi(cosmo,chi,status);
+    kernel[ic]=ccl_spline_eval(chi,clt->spl_kl)*ccl_growth_factor(cosmo,a,status);
+    if((ic==0) || (ic==NCHI_BRUTE-1))
+      kernel[ic]*=0.5;
+  }
+
+  for(int ik=0;ik<NK_BRUTE;ik++) {
+    double k=KMIN_BRUTE*exp(ik*dlk);
+    double delta=0;
+    for(int ic=0;ic<NCHI_BRUTE;ic++) {
+      double x=k*(chi_lo+ic*dchi);
+      if(x>0)
+	delta+=kernel[ic]*gsl_sf_bessel_jl(l,x)/(x*x);
+    }
+    delta*=f_l*dchi;
+    cl+=k*k*k*ccl_linear_matter_power(cosmo,k,1.,status)*delta*delta;
+  }
+
+  return 2*cl*dlk/M_PI;
+}
+
+//Compares the native non-Limber power spectrum of a weak lensing or magnification tracer
+//with Limber's approximation at high ell and with a brute-force j_l integral at low ell.
+static void test_native_lensing(int tracer_type,struct angpow_data * data)
+{
+  int status=0;
+  int ells[NL_NATIVE];
+  double cl_native[NL_NATIVE],cl_limber[NL_NATIVE],cl_again[NL_NATIVE];
+  double z_arr[NZ],nz_arr[NZ],bz_arr[NZ],sz_arr[NZ];
+  int ells_brute[3]={2,10,30};
+
+  ccl_configuration ccl_config=default_config;
+  ccl_config.transfer_function_method=ccl_eisenstein_hu;
+  ccl_config.matter_power_spectrum_method=ccl_linear;
+  ccl_parameters ccl_params = ccl_parameters_create(data->Omega_c, data->Omega_b, data->Omega_k, data->Neff, data->mnu, data->mnu_type,data->w_0, data->w_a, data->h, data->A_s, data->n_s,-1,-1,-1,-1,NULL,NULL, &status);
+  ccl_cosmology *ccl_cosmo=ccl_cosmology_create(ccl_params,ccl_config);
+
+  for(int i=0;i<NZ;i++) {
+    z_arr[i]=Z0_WL-5*SZ_WL+10*SZ_WL*(i+0.5)/NZ;
+    nz_arr[i]=exp(-0.5*pow((z_arr[i]-Z0_WL)/SZ_WL,2));
+    bz_arr[i]=0;
+    sz_arr[i]=0;
+  }
+
+  //Magnification only: no bias and no RSD
+  CCL_ClTracer *clt;
+  if(tracer_type==ccl_weak_lensing_tracer)
+    clt=ccl_cl_tracer_lensing_simple(ccl_cosmo,NZ,z_arr,nz_arr,&status);
+  else
+    clt=ccl_cl_tracer_number_counts(ccl_cosmo,0,1,NZ,z_arr,nz_arr,NZ,z_arr,bz_arr,
+				    NZ,z_arr,sz_arr,&status);
+  ASSERT_NOT_NULL(clt);
+
+  for(int ii=0;ii<NL_NATIVE;ii++)
+    ells[ii]=ii;
+
+  CCL_ClWorkspace *w_native=ccl_cl_workspace_new(NL_NATIVE+1,NL_NATIVE,1.05,20,&status);
+  w_native->nonlimber_method=ccl_nonlimber_native;
+  CCL_ClWorkspace *w_limber=ccl_cl_workspace_new_limber(NL_NATIVE+1,1.05,20,&status);
+  ccl_angular_cls(ccl_cosmo,w_native,clt,clt,NL_NATIVE,ells,cl_native,&status);
+  ccl_angular_cls(ccl_cosmo,w_limber,clt,clt,NL_NATIVE,ells,cl_limber,&status);
+  ASSERT_EQUAL(0,status);
+
+  //The scratch space of the native integrator is kept in the workspace and reused
+  cl_nonlimber_scratch *nl_scratch=w_native->nl_scratch;
+  ASSERT_NOT_NULL(nl_scratch);
+  ccl_angular_cls(ccl_cosmo,w_native,clt,clt,NL_NATIVE,ells,cl_again,&status);
+  ASSERT_EQUAL(0,status);
+  ASSERT_TRUE(w_native->nl_scratch==nl_scratch);
+  for(int ii=0;ii<NL_NATIVE;ii++)
+    ASSERT_TRUE(cl_again[ii]==cl_native[ii]);
+
+  //Limber's approximation is accurate at high ell
+  double rel_precision=0;
+  for(int ii=L_LIMBER_CHECK;ii<NL_NATIVE;ii++)
+    rel_precision+=fabs(cl_native[ii]/cl_limber[ii]-1);
+  rel_precision/=(NL_NATIVE-L_LIMBER_CHECK);
+  ASSERT_TRUE(rel_precision<NATIVE_LIMBER_PRECISION);
+
+  //Brute-force integral at low ell
+  for(int ii=0;ii<3;ii++) {
+    int l=ells_brute[ii];
+    double f_l;
+    if(tracer_type==ccl_weak_lensing_tracer)
+      f_l=sqrt((l+2.)*(l+1.)*l*(l-1.));
+    else
+      f_l=-2*l*(l+1.);
+    double cl_brute=brute_force_cl_lensing(ccl_cosmo,clt,l,f_l,&status);
+    ASSERT_EQUAL(0,status);
+    ASSERT_DBL_NEAR_TOL(1.,cl_native[l]/cl_brute,NATIVE_BRUTE_PRECISION);
+  }
+
+  ccl_cl_tracer_free(clt);
+  ccl_cl_workspace_free(w_native);
+  ccl_cl_workspace_free(w_limber);
+  ccl_cosmology_free(ccl_cosmo);
+}
+
+CTEST2(angpow,native_lensing) {
+  test_native_lensing(ccl_weak_lensing_tracer,data);
+}
+
+CTEST2(angpow,native_magnification) {
+  test_native_lensing(ccl_number_counts_tracer,data);
 }
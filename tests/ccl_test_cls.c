@@ -5,6 +5,9 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
 
 #define SZ_VAL 0.4 //This will cancel the magnification contribution
 #define CLS_TOLERANCE 1E-3
@@ -29,6 +32,34 @@ CTEST_SETUP(cls) {
   data->n_s = 0.96;
 }
 
+//Cosmology with a linear BBKS power spectrum, shared by the tests of batched, template
+//and photo-z power spectra
+static ccl_cosmology *cls_test_cosmology(struct cls_data * data)
+{
+  int status=0;
+  ccl_configuration config = default_config;
+  config.transfer_function_method = ccl_bbks;
+  config.matter_power_spectrum_method = ccl_linear;
+  ccl_parameters params = ccl_parameters_create_flat_lcdm(data->Omega_c,data->Omega_b,data->h,
+							  data->A_s,data->n_s, &status);
+  ASSERT_TRUE(status==0);
+  params.Omega_n_rel=0;
+  params.Omega_l = 0.7;
+  params.sigma8=data->sigma8;
+  ccl_cosmology * cosmo = ccl_cosmology_create(params, config);
+  ASSERT_NOT_NULL(cosmo);
+  return cosmo;
+}
+
+//Gaussian N(z) with mean zmean and width sigz, sampled at nz redshifts within 5*sigz of zmean
+static void cls_test_gaussian_nz(int nz,double zmean,double sigz,double *zarr,double *pzarr)
+{
+  for(int ii=0;ii<nz;ii++) {
+    zarr[ii]=zmean-5*sigz+10*sigz*(ii+0.5)/nz;
+    pzarr[ii]=exp(-0.5*((zarr[ii]-zmean)*(zarr[ii]-zmean)/(sigz*sigz)));
+  }
+}
+
 static int linecount(FILE *f)
 {
   //////
@@ -41,7 +72,7 @@ static int linecount(FILE *f)
   return i0;
 }
 
-static void compare_cls(char *compare_type,struct cls_data * data)
+static void compare_cls(char *compare_type,int limber_method,struct cls_data * data)
 {
   int status=0;
   double zlss=1100.;
@@ -435,6 +466,7 @@ static void compare_cls(char *compare_type,struct cls_data * data)
   double l_logstep = 1.05;
   double l_linstep = 5.;
   CCL_ClWorkspace *w=ccl_cl_workspace_new_limber(NELLS,l_logstep,l_linstep,&status);
+  w->limber_method=limber_method;
 
   ccl_angular_cls(cosmo,w,tr_nc_1,tr_nc_1,NELLS,ells,cls_dd_11_h,&status);
   if (status) printf("%s\n",cosmo->status_message);
@@ -703,9 +735,457 @@ static void compare_cls(char *compare_type,struct cls_data * data)
 }
 
 CTEST2(cls,analytic) {
-  compare_cls("analytic",data);
+  compare_cls("analytic",ccl_limber_qag_logk,data);
 }
 
 CTEST2(cls,histo) {
-  compare_cls("histo",data);
+  compare_cls("histo",ccl_limber_qag_logk,data);
+}
+
+CTEST2(cls,analytic_fixed) {
+  compare_cls("analytic",ccl_limber_gl_chi,data);
+}
+
+CTEST2(cls,histo_fixed) {
+  compare_cls("histo",ccl_limber_gl_chi,data);
+}
+
+static void compare_cls_multi(struct cls_data * data)
+{
+  int status=0;
+  int nz=512,nl=1000,nt=5;
+
+  ccl_cosmology * cosmo = cls_test_cosmology(data);
+
+  double *zarr_1=malloc(nz*sizeof(double));
+  double *pzarr_1=malloc(nz*sizeof(double));
+  double *zarr_2=malloc(nz*sizeof(double));
+  double *pzarr_2=malloc(nz*sizeof(double));
+  double *bzarr=malloc(nz*sizeof(double));
+  cls_test_gaussian_nz(nz,1.0,0.15,zarr_1,pzarr_1);
+  cls_test_gaussian_nz(nz,1.5,0.15,zarr_2,pzarr_2);
+  for(int ii=0;ii<nz;ii++)
+    bzarr[ii]=1.;
+
+  CCL_ClTracer *trs[5];
+  trs[0]=ccl_cl_tracer_number_counts_simple(cosmo,nz,zarr_1,pzarr_1,nz,zarr_1,bzarr,&status);
+  trs[1]=ccl_cl_tracer_number_counts_simple(cosmo,nz,zarr_2,pzarr_2,nz,zarr_2,bzarr,&status);
+  trs[2]=ccl_cl_tracer_lensing_simple(cosmo,nz,zarr_1,pzarr_1,&status);
+  trs[3]=ccl_cl_tracer_lensing_simple(cosmo,nz,zarr_2,pzarr_2,&status);
+  trs[4]=ccl_cl_tracer_cmblens(cosmo,1100.,&status);
+  for(int i1=0;i1<nt;i1++)
+    ASSERT_NOT_NULL(trs[i1]);
+
+  int *ells=malloc(nl*sizeof(int));
+  double *cl_pair=malloc(nt*nt*nl*sizeof(double));
+  double *cl_multi=malloc(nt*nt*nl*sizeof(double));
+  for(int ii=0;ii<nl;ii++)
+    ells[ii]=ii;
+
+  CCL_ClWorkspace *w=ccl_cl_workspace_new_limber(nl,1.05,5.,&status);
+  for(int i1=0;i1<nt;i1++) {
+    for(int i2=0;i2<nt;i2++) {
+      ccl_angular_cls(cosmo,w,trs[i1],trs[i2],nl,ells,&(cl_pair[(i1*nt+i2)*nl]),&status);
+      ASSERT_TRUE(status==0);
+    }
+  }
+  ccl_angular_cls_multi(cosmo,w,nt,trs,nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+
+  //Compare with pairwise computation at the interpolation nodes
+  for(int ii=0;ii<w->n_ls;ii++) {
+    int l=w->l_arr[ii];
+    for(int i1=0;i1<nt;i1++) {
+      for(int i2=0;i2<nt;i2++) {
+	double cl_11=cl_pair[(i1*nt+i1)*nl+l];
+	double cl_22=cl_pair[(i2*nt+i2)*nl+l];
+	double cl_12=cl_pair[(i1*nt+i2)*nl+l];
+	ASSERT_TRUE(fabs(cl_multi[(i1*nt+i2)*nl+l]-cl_12)<=CLS_TOLERANCE*sqrt(fabs(cl_11*cl_22)));
+      }
+    }
+  }
+
+  //Adaptive nodes, starting from a coarse workspace, against the default nodes
+  CCL_ClWorkspace *w_ad=ccl_cl_workspace_new_limber(nl,2.,200,&status);
+  ASSERT_NOT_NULL(w_ad);
+  w_ad->l_tol=1E-4;
+  ccl_angular_cls(cosmo,w_ad,trs[0],trs[0],nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  ccl_angular_cls(cosmo,w_ad,trs[2],trs[4],nl,ells,&(cl_multi[nl]),&status);
+  ASSERT_TRUE(status==0);
+  ASSERT_TRUE(w_ad->n_ls<w->n_ls);
+  for(int ii=2;ii<nl;ii++) {
+    double cl_00=cl_pair[ii],cl_24=cl_pair[(2*nt+4)*nl+ii];
+    double cl_22=cl_pair[(2*nt+2)*nl+ii],cl_44=cl_pair[(4*nt+4)*nl+ii];
+    ASSERT_TRUE(fabs(cl_multi[ii]-cl_00)<=CLS_TOLERANCE*cl_00);
+    ASSERT_TRUE(fabs(cl_multi[nl+ii]-cl_24)<=CLS_TOLERANCE*sqrt(cl_22*cl_44));
+  }
+  ccl_angular_cls_multi(cosmo,w_ad,nt,trs,nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  for(int ii=2;ii<nl;ii++) {
+    for(int i1=0;i1<nt;i1++) {
+      for(int i2=0;i2<nt;i2++) {
+	double cl_11=cl_pair[(i1*nt+i1)*nl+ii];
+	double cl_22=cl_pair[(i2*nt+i2)*nl+ii];
+	double cl_12=cl_pair[(i1*nt+i2)*nl+ii];
+	ASSERT_TRUE(fabs(cl_multi[(i1*nt+i2)*nl+ii]-cl_12)<=CLS_TOLERANCE*sqrt(fabs(cl_11*cl_22)));
+      }
+    }
+  }
+  ccl_cl_workspace_free(w_ad);
+
+  //Cached power spectra must match the direct calculation, and only be computed once
+  CCL_ClCache *cache=ccl_cl_cache_new(1,&status);
+  ASSERT_NOT_NULL(cache);
+  ccl_angular_cls_cached(cosmo,w,cache,trs[0],trs[2],nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  ccl_angular_cls_cached(cosmo,w,cache,trs[2],trs[0],nl,ells,&(cl_multi[nl]),&status);
+  ASSERT_TRUE(status==0);
+  ASSERT_TRUE(cache->n_hits==1);
+  for(int ii=0;ii<nl;ii++) {
+    ASSERT_DBL_NEAR_TOL(cl_pair[(0*nt+2)*nl+ii],cl_multi[ii],1E-10*fabs(cl_multi[ii]));
+    ASSERT_TRUE(cl_multi[ii]==cl_multi[nl+ii]);
+  }
+  ccl_angular_cls_cached(cosmo,w,cache,trs[1],trs[3],nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  ccl_angular_cls_cached(cosmo,w,cache,trs[0],trs[2],nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  ASSERT_TRUE(cache->n_hits==1);
+  ASSERT_TRUE(cache->n_entries==1);
+  ccl_cl_cache_clear(cache);
+  ASSERT_TRUE(cache->n_entries==0);
+  ccl_cl_cache_free(cache);
+
+  //Gaussian covariance against a direct calculation from the pairwise spectra
+  int nbins=4,npairs=nt*(nt+1)/2;
+  int l_edges[5]={2,10,50,200,nl};
+  double noise[nt*nt];
+  double *cl_binned=malloc(npairs*nbins*sizeof(double));
+  double *cov=malloc(nbins*npairs*npairs*sizeof(double));
+  for(int i1=0;i1<nt*nt;i1++)
+    noise[i1]=0;
+  for(int i1=0;i1<nt;i1++)
+    noise[i1*nt+i1]=1E-9;
+  ccl_angular_cls_gaussian_covariance(cosmo,w,nt,trs,noise,0.4,nbins,l_edges,cl_binned,cov,&status);
+  ASSERT_TRUE(status==0);
+  for(int ib=0;ib<nbins;ib++) {
+    int ip=0;
+    double nmodes=0;
+    for(int l=l_edges[ib];l<l_edges[ib+1];l++)
+      nmodes+=2*l+1;
+    for(int i1=0;i1<nt;i1++) {
+      for(int i2=i1;i2<nt;i2++) {
+	int iq=0;
+	double cb=0;
+	for(int l=l_edges[ib];l<l_edges[ib+1];l++)
+	  cb+=(2*l+1)*cl_pair[(i1*nt+i2)*nl+l]/nmodes;
+	ASSERT_TRUE(fabs(cl_binned[ip*nbins+ib]-cb)<=CLS_TOLERANCE*fabs(cb));
+	for(int i3=0;i3<nt;i3++) {
+	  for(int i4=i3;i4<nt;i4++) {
+	    double c=0,c_pp,c_qq;
+	    for(int l=l_edges[ib];l<l_edges[ib+1];l++) {
+	      c+=(2*l+1)*((cl_pair[(i1*nt+i3)*nl+l]+noise[i1*nt+i3])*(cl_pair[(i2*nt+i4)*nl+l]+noise[i2*nt+i4])+
+			  (cl_pair[(i1*nt+i4)*nl+l]+noise[i1*nt+i4])*(cl_pair[(i2*nt+i3)*nl+l]+noise[i2*nt+i3]));
+	    }
+	    c/=0.4*nmodes*nmodes;
+	    c_pp=cov[(ib*npairs+ip)*npairs+ip];
+	    c_qq=cov[(ib*npairs+iq)*npairs+iq];
+	    ASSERT_TRUE(fabs(cov[(ib*npairs+ip)*npairs+iq]-c)<=2*CLS_TOLERANCE*sqrt(c_pp*c_qq));
+	    ASSERT_TRUE(cov[(ib*npairs+ip)*npairs+iq]==cov[(ib*npairs+iq)*npairs+ip]);
+	    iq++;
+	  }
+	}
+	ip++;
+      }
+    }
+  }
+  free(cl_binned);
+  free(cov);
+
+  //Reusing the workspace (and its cached quadrature) must give the same result,
+  //without allocating new scratch space
+  w->limber_method=ccl_limber_gl_chi;
+  ccl_angular_cls(cosmo,w,trs[0],trs[1],nl,ells,cl_pair,&status);
+  ASSERT_TRUE(status==0);
+  double *chi_0=w->chi,*chi_new_0=w->chi_new,*achi_0=w->achi,*pw_0=w->pw;
+  double *scratch_0=w->scratch,*cl_nodes_0=w->cl_nodes,*ref_cl_0=w->ref_cl;
+  ccl_angular_cls(cosmo,w,trs[2],trs[3],nl,ells,&(cl_pair[nl]),&status);
+  ASSERT_TRUE(status==0);
+  ccl_angular_cls(cosmo,w,trs[0],trs[1],nl,ells,&(cl_pair[2*nl]),&status);
+  ASSERT_TRUE(status==0);
+  for(int ii=0;ii<nl;ii++)
+    ASSERT_DBL_NEAR_TOL(cl_pair[ii],cl_pair[2*nl+ii],1E-10*fabs(cl_pair[ii]));
+  ccl_angular_cls_multi(cosmo,w,nt,trs,nl,ells,cl_multi,&status);
+  ASSERT_TRUE(status==0);
+  //New quadrature nodes are swapped with the old ones
+  ASSERT_TRUE(((w->chi==chi_0) && (w->chi_new==chi_new_0)) ||
+	      ((w->chi==chi_new_0) && (w->chi_new==chi_0)));
+  ASSERT_TRUE(w->achi==achi_0);
+  ASSERT_TRUE(w->pw==pw_0);
+  ASSERT_TRUE(w->scratch==scratch_0);
+  ASSERT_TRUE(w->cl_nodes==cl_nodes_0);
+  ASSERT_TRUE(w->ref_cl==ref_cl_0);
+
+  ccl_cl_workspace_free(w);
+  free(ells);
+  free(cl_pair);
+  free(cl_multi);
+  free(zarr_1);
+  free(zarr_2);
+  free(pzarr_1);
+  free(pzarr_2);
+  free(bzarr);
+  for(int i1=0;i1<nt;i1++)
+    ccl_cl_tracer_free(trs[i1]);
+  ccl_cosmology_free(cosmo);
+}
+
+CTEST2(cls,multi) {
+  compare_cls_multi(data);
+}
+
+static void compare_cls_templates(struct cls_data * data)
+{
+  int status=0;
+  int nz=512,nl=500,nb=4,ns=3,nba=3;
+
+  ccl_cosmology * cosmo = cls_test_cosmology(data);
+
+  double *zarr=malloc(nz*sizeof(double));
+  double *pzarr=malloc(nz*sizeof(double));
+  double *rfarr=malloc(nz*sizeof(double));
+  cls_test_gaussian_nz(nz,1.0,0.15,zarr,pzarr);
+  for(int ii=0;ii<nz;ii++)
+    rfarr[ii]=0.5;
+
+  //Nuisance parameters: b(z) and s(z) for number counts, ba(z) for weak lensing
+  double z_b[4]={0.4,0.8,1.2,1.6},z_s[3]={0.3,1.0,1.7},z_ba[3]={0.5,1.0,1.5};
+  double p_nc_0[7]={1.0,1.0,1.0,1.0,0.4,0.4,0.4};
+  double p_wl_0[3]={1.0,1.0,1.0};
+  double p_nc[7]={0.9,1.3,1.7,2.2,0.1,0.3,0.6};
+  double p_wl[3]={0.5,1.5,-2.0};
+
+  CCL_ClTracer *tr_nc_0=ccl_cl_tracer_number_counts(cosmo,0,1,nz,zarr,pzarr,nb,z_b,p_nc_0,
+						    ns,z_s,&(p_nc_0[nb]),&status);
+  CCL_ClTracer *tr_wl_0=ccl_cl_tracer_lensing(cosmo,1,nz,zarr,pzarr,nba,z_ba,p_wl_0,
+					      nz,zarr,rfarr,&status);
+  CCL_ClTracer *trs[2];
+  trs[0]=ccl_cl_tracer_number_counts(cosmo,0,1,nz,zarr,pzarr,nb,z_b,p_nc,
+				     ns,z_s,&(p_nc[nb]),&status);
+  trs[1]=ccl_cl_tracer_lensing(cosmo,1,nz,zarr,pzarr,nba,z_ba,p_wl,
+			       nz,zarr,rfarr,&status);
+  ASSERT_TRUE(status==0);
+
+  int *ells=malloc(nl*sizeof(int));
+  double *cl_direct=malloc(4*nl*sizeof(double));
+  double *cl_tmpl=malloc(nl*sizeof(double));
+  for(int ii=0;ii<nl;ii++)
+    ells[ii]=ii;
+
+  CCL_ClWorkspace *w=ccl_cl_workspace_new_limber(nl,1.05,5.,&status);
+  ccl_angular_cls_multi(cosmo,w,2,trs,nl,ells,cl_direct,&status);
+  ASSERT_TRUE(status==0);
+
+  //Templates are computed from tracers with different nuisance parameters
+  CCL_ClTemplates *t_nn=ccl_cl_templates_new(cosmo,w,tr_nc_0,tr_nc_0,nl,ells,&status);
+  CCL_ClTemplates *t_nw=ccl_cl_templates_new(cosmo,w,tr_nc_0,tr_wl_0,nl,ells,&status);
+  CCL_ClTemplates *t_ww=ccl_cl_templates_new(cosmo,w,tr_wl_0,tr_wl_0,nl,ells,&status);
+  ASSERT_TRUE(status==0);
+  ASSERT_TRUE(t_nn->n_par1==nb+ns);
+  ASSERT_TRUE(t_nw->n_par2==nba);
+
+  CCL_ClTemplates *tmpls[3]={t_nn,t_nw,t_ww};
+  double *pars[2]={p_nc,p_wl};
+  int i1s[3]={0,0,1},i2s[3]={0,1,1};
+  for(int ip=0;ip<3;ip++) {
+    int i1=i1s[ip],i2=i2s[ip];
+    ccl_cl_templates_eval(tmpls[ip],pars[i1],pars[i2],cl_tmpl);
+    for(int ii=2;ii<nl;ii++) {
+      double cl_11=cl_direct[(i1*2+i1)*nl+ii];
+      double cl_22=cl_direct[(i2*2+i2)*nl+ii];
+      double cl_12=cl_direct[(i1*2+i2)*nl+ii];
+      ASSERT_TRUE(fabs(cl_tmpl[ii]-cl_12)<=CLS_TOLERANCE*sqrt(fabs(cl_11*cl_22)));
+    }
+  }
+
+  ccl_cl_templates_free(t_nn);
+  ccl_cl_templates_free(t_nw);
+  ccl_cl_templates_free(t_ww);
+  ccl_cl_workspace_free(w);
+  free(ells);
+  free(cl_direct);
+  free(cl_tmpl);
+  free(zarr);
+  free(pzarr);
+  free(rfarr);
+  ccl_cl_tracer_free(tr_nc_0);
+  ccl_cl_tracer_free(tr_wl_0);
+  ccl_cl_tracer_free(trs[0]);
+  ccl_cl_tracer_free(trs[1]);
+  ccl_cosmology_free(cosmo);
+}
+
+CTEST2(cls,templates) {
+  compare_cls_templates(data);
+}
+
+static void compare_cls_photoz(struct cls_data * data)
+{
+  int status=0;
+  int nz=512,nl=500;
+  double dz=0.05,stretch=1.1;
+
+  ccl_cosmology * cosmo = cls_test_cosmology(data);
+
+  double *zarr=malloc(nz*sizeof(double));
+  double *pzarr=malloc(nz*sizeof(double));
+  double *zarr_s=malloc(nz*sizeof(double));
+  double *pzarr_s=malloc(nz*sizeof(double));
+  double *barr=malloc(nz*sizeof(double));
+  double *sarr=malloc(nz*sizeof(double));
+  double zn=0,nn=0;
+  cls_test_gaussian_nz(nz,1.0,0.15,zarr,pzarr);
+  for(int ii=0;ii<nz;ii++) {
+    barr[ii]=1.;
+    sarr[ii]=0.2;
+  }
+  for(int ii=0;ii<nz-1;ii++) {
+    zn+=0.5*(zarr[ii+1]-zarr[ii])*(zarr[ii]*pzarr[ii]+zarr[ii+1]*pzarr[ii+1]);
+    nn+=0.5*(zarr[ii+1]-zarr[ii])*(pzarr[ii]+pzarr[ii+1]);
+  }
+  //Reference: tracers created directly from the shifted and stretched N(z)
+  for(int ii=0;ii<nz;ii++) {
+    zarr_s[ii]=zn/nn+dz+stretch*(zarr[ii]-zn/nn);
+    pzarr_s[ii]=pzarr[ii]/stretch;
+  }
+
+  CCL_ClTracer *trs[2],*trs_ref[2];
+  trs[0]=ccl_cl_tracer_number_counts(cosmo,0,1,nz,zarr,pzarr,nz,zarr,barr,nz,zarr,sarr,&status);
+  trs[1]=ccl_cl_tracer_lensing_simple(cosmo,nz,zarr,pzarr,&status);
+  trs_ref[0]=ccl_cl_tracer_number_counts(cosmo,0,1,nz,zarr_s,pzarr_s,nz,zarr,barr,nz,zarr,sarr,&status);
+  trs_ref[1]=ccl_cl_tracer_lensing_simple(cosmo,nz,zarr_s,pzarr_s,&status);
+  ASSERT_TRUE(status==0);
+
+  //Parameters are relative to the input N(z), so they don't accumulate
+  for(int it=0;it<2;it++) {
+    unsigned long id=trs[it]->id;
+    ccl_cl_tracer_set_photoz(cosmo,trs[it],-0.1,0.8,&status);
+    ccl_cl_tracer_set_photoz(cosmo,trs[it],dz,stretch,&status);
+    ASSERT_TRUE(status==0);
+    ASSERT_TRUE(trs[it]->id!=id);
+
+    //Setting the same parameters again reuses the background table and the kernel splines
+    CCL_ClRadialTable *tab=trs[it]->pz_tab;
+    double *tab_a=tab->a;
+    SplPar *spl_kl=trs[it]->spl_kl;
+    ccl_cl_tracer_set_photoz(cosmo,trs[it],dz,stretch,&status);
+    ASSERT_TRUE(status==0);
+    ASSERT_TRUE(trs[it]->pz_tab==tab);
+    ASSERT_TRUE(trs[it]->pz_tab->a==tab_a);
+    ASSERT_TRUE(trs[it]->spl_kl==spl_kl);
+  }
+
+  int *ells=malloc(nl*sizeof(int));
+  double *cl=malloc(4*nl*sizeof(double));
+  double *cl_ref=malloc(4*nl*sizeof(double));
+  for(int ii=0;ii<nl;ii++)
+    ells[ii]=ii;
+  CCL_ClWorkspace *w=ccl_cl_workspace_new_limber(nl,1.05,5.,&status);
+  ccl_angular_cls_multi(cosmo,w,2,trs,nl,ells,cl,&status);
+  ccl_angular_cls_multi(cosmo,w,2,trs_ref,nl,ells,cl_ref,&status);
+  ASSERT_TRUE(status==0);
+  for(int i1=0;i1<2;i1++) {
+    for(int i2=i1;i2<2;i2++) {
+      for(int ii=2;ii<nl;ii++) {
+	double cl_11=cl_ref[(i1*2+i1)*nl+ii];
+	double cl_22=cl_ref[(i2*2+i2)*nl+ii];
+	double cl_12=cl_ref[(i1*2+i2)*nl+ii];
+	ASSERT_TRUE(fabs(cl[(i1*2+i2)*nl+ii]-cl_12)<=CLS_TOLERANCE*sqrt(fabs(cl_11*cl_22)));
+      }
+    }
+  }
+
+  ccl_cl_workspace_free(w);
+  free(ells);
+  free(cl);
+  free(cl_ref);
+  free(zarr);
+  free(pzarr);
+  free(zarr_s);
+  free(pzarr_s);
+  free(barr);
+  free(sarr);
+  ccl_cl_tracer_free(trs[0]);
+  ccl_cl_tracer_free(trs[1]);
+  ccl_cl_tracer_free(trs_ref[0]);
+  ccl_cl_tracer_free(trs_ref[1]);
+  ccl_cl_tracer_free(NULL);
+  ccl_cosmology_free(cosmo);
+}
+
+CTEST2(cls,photoz) {
+  compare_cls_photoz(data);
+}
+
+//Power spectra computed in parallel must not depend on the number of threads,
+//since every multipole is computed independently
+static void compare_cls_threads(struct cls_data * data)
+{
+#ifdef _OPENMP
+  int status=0;
+  int nz=512,nl=1000;
+  int n_threads=omp_get_max_threads();
+  int methods[2]={ccl_limber_qag_logk,ccl_limber_gl_chi};
+  ccl_cosmology * cosmo = cls_test_cosmology(data);
+
+  double *zarr=malloc(nz*sizeof(double));
+  double *pzarr=malloc(nz*sizeof(double));
+  double *bzarr=malloc(nz*sizeof(double));
+  cls_test_gaussian_nz(nz,1.0,0.15,zarr,pzarr);
+  for(int ii=0;ii<nz;ii++)
+    bzarr[ii]=1.;
+
+  CCL_ClTracer *trs[2];
+  trs[0]=ccl_cl_tracer_number_counts_simple(cosmo,nz,zarr,pzarr,nz,zarr,bzarr,&status);
+  trs[1]=ccl_cl_tracer_lensing_simple(cosmo,nz,zarr,pzarr,&status);
+  ASSERT_TRUE(status==0);
+
+  int *ells=malloc(nl*sizeof(int));
+  double *cl_1=malloc(5*nl*sizeof(double));
+  double *cl_n=malloc(5*nl*sizeof(double));
+  for(int ii=0;ii<nl;ii++)
+    ells[ii]=ii;
+
+  for(int im=0;im<2;im++) {
+    for(int it=0;it<2;it++) {
+      double *cl=(it==0) ? cl_1 : cl_n;
+      CCL_ClWorkspace *w=ccl_cl_workspace_new_limber(nl,1.05,5.,&status);
+      ASSERT_NOT_NULL(w);
+      w->limber_method=methods[im];
+      w->l_tol=1E-4;
+      omp_set_num_threads((it==0) ? 1 : 4);
+      ccl_angular_cls(cosmo,w,trs[0],trs[1],nl,ells,cl,&status);
+      ccl_angular_cls_multi(cosmo,w,2,trs,nl,ells,&(cl[nl]),&status);
+      ccl_cl_workspace_free(w);
+      ASSERT_TRUE(status==0);
+    }
+    omp_set_num_threads(n_threads);
+    for(int ii=0;ii<5*nl;ii++)
+      ASSERT_TRUE(cl_1[ii]==cl_n[ii]);
+  }
+
+  free(ells);
+  free(cl_1);
+  free(cl_n);
+  free(zarr);
+  free(pzarr);
+  free(bzarr);
+  ccl_cl_tracer_free(trs[0]);
+  ccl_cl_tracer_free(trs[1]);
+  ccl_cosmology_free(cosmo);
+#endif //_OPENMP
+}
+
+CTEST2(cls,threads) {
+  compare_cls_threads(data);
 }
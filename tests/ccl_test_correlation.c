@@ -6,6 +6,8 @@
 #include <math.h>
 #include <time.h>
 #include <string.h>
+#include <gsl/gsl_integration.h>
+#include <gsl/gsl_sf_bessel.h>
 
 #define CORR_ERROR_FRACTION 0.1
 #define ELL_MAX_CL 10000
@@ -805,3 +807,165 @@ CTEST2(corrs,analytic_bessel) {
 CTEST2(corrs,histo_bessel) {
   compare_corr("histo",CCL_CORR_BESSEL,data);
 }
+
+// Model angular power spectrum with a Gaussian cutoff at l_cut, used by the tests below
+static double bessel_ref_cl(double l,double l_cut)
+{
+  return 1E-8*exp(-pow(l/l_cut,2))/(1+l/100.);
+}
+
+// At small separations the full-sky sums must agree with the flat-sky Bessel integrals
+CTEST2(corrs,legendre_flat_sky) {
+  int i,it,status=0;
+  int n_ell=1000,n_theta=10;
+  int types[4]={CCL_CORR_GG,CCL_CORR_GL,CCL_CORR_LP,CCL_CORR_LM};
+  ccl_configuration config = default_config;
+  config.transfer_function_method = ccl_bbks;
+  ccl_parameters params = ccl_parameters_create_flat_lcdm(data->Omega_c,data->Omega_b,data->h,
+							  data->sigma8,data->n_s,&status);
+  ccl_cosmology * cosmo = ccl_cosmology_create(params, config);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *ell=ccl_log_spacing(1.,30000.,n_ell);
+  double *cls=malloc(n_ell*sizeof(double));
+  for(i=0;i<n_ell;i++)
+    cls[i]=bessel_ref_cl(ell[i],3000.);
+  double *theta=ccl_log_spacing(0.05,1.,n_theta);
+  double *wt_lgndre=malloc(n_theta*sizeof(double));
+  double *wt_bessel=malloc(n_theta*sizeof(double));
+
+  for(it=0;it<4;it++) {
+    double wt_max=0;
+    ccl_correlation(cosmo,n_ell,ell,cls,n_theta,theta,wt_lgndre,types[it],
+		    0,NULL,CCL_CORR_LGNDRE,&status);
+    ASSERT_EQUAL(0,status);
+    ccl_correlation(cosmo,n_ell,ell,cls,n_theta,theta,wt_bessel,types[it],
+		    0,NULL,CCL_CORR_BESSEL,&status);
+    ASSERT_EQUAL(0,status);
+    for(i=0;i<n_theta;i++)
+      wt_max=fmax(wt_max,fabs(wt_bessel[i]));
+    for(i=0;i<n_theta;i++)
+      ASSERT_DBL_NEAR_TOL(0.,(wt_lgndre[i]-wt_bessel[i])/wt_max,1E-2);
+  }
+
+  free(ell);
+  free(cls);
+  free(theta);
+  free(wt_lgndre);
+  free(wt_bessel);
+  ccl_cosmology_free(cosmo);
+}
+
+typedef struct {
+  int i_bessel;
+  double th;
+} bessel_ref_par;
+
+static double bessel_ref_integrand(double l,void *params)
+{
+  bessel_ref_par *p=(bessel_ref_par *)params;
+  return l*gsl_sf_bessel_Jn(p->i_bessel,l*p->th)*bessel_ref_cl(l,3000.);
+}
+
+// At large separations the integrand oscillates many times before C_l dies off.
+// The panel quadrature must agree with adaptive integration (done over chunks of
+// a few oscillations, so that it converges) up to the point where C_l is negligible.
+CTEST2(corrs,bessel_large_theta) {
+  int i,it,status=0;
+  int n_ell=1000,n_theta=8;
+  int types[2]={CCL_CORR_GG,CCL_CORR_LM};
+  int orders[2]={0,4};
+  ccl_configuration config = default_config;
+  config.transfer_function_method = ccl_bbks;
+  ccl_parameters params = ccl_parameters_create_flat_lcdm(data->Omega_c,data->Omega_b,data->h,
+							  data->sigma8,data->n_s,&status);
+  ccl_cosmology * cosmo = ccl_cosmology_create(params, config);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *ell=ccl_log_spacing(1.,30000.,n_ell);
+  double *cls=malloc(n_ell*sizeof(double));
+  for(i=0;i<n_ell;i++)
+    cls[i]=bessel_ref_cl(ell[i],3000.);
+  double *theta=ccl_log_spacing(1.,10.,n_theta);
+  double *wt_bessel=malloc(n_theta*sizeof(double));
+  double *wt_ref=malloc(n_theta*sizeof(double));
+  gsl_integration_workspace *w=gsl_integration_workspace_alloc(1000);
+
+  for(it=0;it<2;it++) {
+    double wt_max=0;
+    ccl_correlation(cosmo,n_ell,ell,cls,n_theta,theta,wt_bessel,types[it],
+		    0,NULL,CCL_CORR_BESSEL,&status);
+    ASSERT_EQUAL(0,status);
+
+    for(i=0;i<n_theta;i++) {
+      double l_lo=0,sum=0;
+      bessel_ref_par p={orders[it],theta[i]*M_PI/180};
+      double dl=20*2*M_PI/p.th;
+      gsl_function F;
+      F.function=&bessel_ref_integrand;
+      F.params=&p;
+      while(l_lo<30000.) {
+	double result,eresult;
+	gsl_integration_qag(&F,l_lo,l_lo+dl,1E-16,1E-8,1000,GSL_INTEG_GAUSS61,w,&result,&eresult);
+	sum+=result;
+	l_lo+=dl;
+      }
+      wt_ref[i]=sum/(2*M_PI);
+      wt_max=fmax(wt_max,fabs(wt_ref[i]));
+    }
+    for(i=0;i<n_theta;i++)
+      ASSERT_DBL_NEAR_TOL(0.,(wt_bessel[i]-wt_ref[i])/wt_max,1E-4);
+  }
+
+  gsl_integration_workspace_free(w);
+  free(ell);
+  free(cls);
+  free(theta);
+  free(wt_bessel);
+  free(wt_ref);
+  ccl_cosmology_free(cosmo);
+}
+
+// Batched FFTLog transforms must reproduce the one-by-one ones
+CTEST2(corrs,multi_fftlog) {
+  int i,ic,it,status=0;
+  int n_ell=1000,n_theta=10,n_cls=3;
+  int types[4]={CCL_CORR_GG,CCL_CORR_GL,CCL_CORR_LP,CCL_CORR_LM};
+  ccl_configuration config = default_config;
+  config.transfer_function_method = ccl_bbks;
+  ccl_parameters params = ccl_parameters_create_flat_lcdm(data->Omega_c,data->Omega_b,data->h,
+							  data->sigma8,data->n_s,&status);
+  ccl_cosmology * cosmo = ccl_cosmology_create(params, config);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *ell=ccl_log_spacing(1.,30000.,n_ell);
+  double *cls=malloc(n_cls*n_ell*sizeof(double));
+  for(ic=0;ic<n_cls;ic++) {
+    for(i=0;i<n_ell;i++)
+      cls[ic*n_ell+i]=bessel_ref_cl(ell[i],1000.*(ic+1));
+  }
+  double *theta=ccl_log_spacing(0.01,5.,n_theta);
+  double *wt_multi=malloc(4*n_cls*n_theta*sizeof(double));
+  double *wt_single=malloc(n_theta*sizeof(double));
+
+  ccl_correlation_multi(cosmo,n_ell,ell,n_cls,cls,n_theta,theta,4,types,wt_multi,
+			0,NULL,CCL_CORR_FFTLOG,&status);
+  ASSERT_EQUAL(0,status);
+  for(it=0;it<4;it++) {
+    for(ic=0;ic<n_cls;ic++) {
+      ccl_correlation(cosmo,n_ell,ell,&(cls[ic*n_ell]),n_theta,theta,wt_single,types[it],
+		      0,NULL,CCL_CORR_FFTLOG,&status);
+      ASSERT_EQUAL(0,status);
+      for(i=0;i<n_theta;i++)
+	ASSERT_DBL_NEAR_TOL(wt_single[i],wt_multi[(it*n_cls+ic)*n_theta+i],
+			    1E-10*fabs(wt_single[i])+1E-20);
+    }
+  }
+
+  free(ell);
+  free(cls);
+  free(theta);
+  free(wt_multi);
+  free(wt_single);
+  ccl_cosmology_free(cosmo);
+}
@@ -1,4 +1,5 @@
 #include "ccl.h"
+#include "../include/ccl_params.h"
 #include "ctest.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -55,7 +56,8 @@ static int linecount(FILE *f)
   return i0;
 }
 
-static void compare_correlation_3d(int i_model,struct corrs_3d_data * data)
+//n_k_lean -> if non-negative, value of N_K_3DCOR_LEAN used for this comparison only
+static void compare_correlation_3d(int i_model,int n_k_lean,struct corrs_3d_data * data)
 {
   int nk,nr,i,j;
   int status=0;
@@ -119,23 +121,34 @@ static void compare_correlation_3d(int i_model,struct corrs_3d_data * data)
     }
   }
 
-  double *ximm_ccl_out1=malloc(N1*sizeof(double));
-  double *ximm_ccl_out2=malloc((nr-N1)*sizeof(double));
+  double *ximm_ccl_out1=malloc(6*N1*sizeof(double));
+  double *ximm_ccl_out2=malloc(6*(nr-N1)*sizeof(double));
 
-   for(j=0;j<6;j++) {
-      double z = j+0.;	
-      ccl_correlation_3d(cosmo,1.0/(j+1),N1,r_arr1,ximm_ccl_out1,0,NULL,&status);
-      ccl_correlation_3d(cosmo,1.0/(j+1),nr-N1,r_arr2,ximm_ccl_out2,0,NULL,&status);
+  //The k grid is a global setting, so it is restored before any of the checks below
+  int n_k_lean_save=-1;
+  if(n_k_lean>=0) {
+    if(ccl_splines==NULL)
+      ccl_cosmology_read_config();
+    n_k_lean_save=ccl_splines->N_K_3DCOR_LEAN;
+    ccl_splines->N_K_3DCOR_LEAN=n_k_lean;
+  }
+  for(j=0;j<6;j++) {
+    ccl_correlation_3d(cosmo,1.0/(j+1),N1,r_arr1,&(ximm_ccl_out1[j*N1]),0,NULL,&status);
+    ccl_correlation_3d(cosmo,1.0/(j+1),nr-N1,r_arr2,&(ximm_ccl_out2[j*(nr-N1)]),0,NULL,&status);
+  }
+  if(n_k_lean>=0)
+    ccl_splines->N_K_3DCOR_LEAN=n_k_lean_save;
 
+   for(j=0;j<6;j++) {
       if (status) printf("%s\n",cosmo->status_message);
       for(i=0;i<nr;i++){     
       double err;
       if(i<N1){
-      err=fabs(r_arr1[i]*r_arr1[i]*(ximm_ccl_out1[i]-ximm_bench_arr[i][j])); 
+      err=fabs(r_arr1[i]*r_arr1[i]*(ximm_ccl_out1[j*N1+i]-ximm_bench_arr[i][j])); 
       ASSERT_DBL_NEAR_TOL(0.,err,CORR_TOLERANCE1[j]);
       }
       else{
-      err=fabs(r_arr2[i-N1]*r_arr2[i-N1]*(ximm_ccl_out2[i-N1]-ximm_bench_arr[i][j])); 
+      err=fabs(r_arr2[i-N1]*r_arr2[i-N1]*(ximm_ccl_out2[j*(nr-N1)+i-N1]-ximm_bench_arr[i][j])); 
       ASSERT_DBL_NEAR_TOL(0.,err,CORR_TOLERANCE2[j]);
       }
       }   
@@ -153,15 +166,64 @@ static void compare_correlation_3d(int i_model,struct corrs_3d_data * data)
 
 CTEST2(corrs_3d,model_1) {
   int model=1;
-  compare_correlation_3d(model,data);
+  compare_correlation_3d(model,-1,data);
 }
 
 CTEST2(corrs_3d,model_2) {
   int model=2;
-  compare_correlation_3d(model,data);
+  compare_correlation_3d(model,-1,data);
 }
 
 CTEST2(corrs_3d,model_3) {
   int model=3;
-  compare_correlation_3d(model,data);
+  compare_correlation_3d(model,-1,data);
+}
+
+CTEST2(corrs_3d,model_1_dense) {
+  //Same benchmark with the dense k grid instead of the lean one
+  int model=1;
+  compare_correlation_3d(model,0,data);
+}
+
+CTEST2(corrs_3d,multi_a) {
+  //Several scale factors at once, with and without growth rescaling
+  int i,ia,status=0;
+  int n_a=3,n_r=20;
+  double a_arr[3]={0.4,0.7,1.0};
+  ccl_configuration config = default_config;
+  config.matter_power_spectrum_method= ccl_linear;
+  config.transfer_function_method = ccl_bbks;
+  ccl_parameters params = ccl_parameters_create(data->Omega_c,data->Omega_b,data->Omega_k[0],
+		data->Neff, data->mnu, data->mnu_type, data->w_0[0],data->w_a[0],
+		data->h,data->A_s,data->n_s,-1, -1, -1, -1,NULL,NULL, &status);
+  params.Omega_g=0.0;
+  params.Omega_l=data->Omega_v[0];
+  params.sigma8=data->sigma8;
+  ccl_cosmology * cosmo = ccl_cosmology_create(params, config);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *r=ccl_linear_spacing(5.,100.,n_r);
+  double *xi_multi=malloc(n_a*n_r*sizeof(double));
+  double *xi_growth=malloc(n_a*n_r*sizeof(double));
+  double *xi_single=malloc(n_r*sizeof(double));
+
+  ccl_correlation_3d_multi(cosmo,n_a,a_arr,n_r,r,xi_multi,0,0,NULL,&status);
+  ASSERT_EQUAL(0,status);
+  ccl_correlation_3d_multi(cosmo,n_a,a_arr,n_r,r,xi_growth,1,0,NULL,&status);
+  ASSERT_EQUAL(0,status);
+  for(ia=0;ia<n_a;ia++) {
+    ccl_correlation_3d(cosmo,a_arr[ia],n_r,r,xi_single,0,NULL,&status);
+    ASSERT_EQUAL(0,status);
+    for(i=0;i<n_r;i++) {
+      ASSERT_DBL_NEAR_TOL(xi_single[i],xi_multi[ia*n_r+i],1E-10*fabs(xi_single[i]));
+      //The BBKS linear power spectrum scales exactly as D(a)^2
+      ASSERT_DBL_NEAR_TOL(xi_single[i],xi_growth[ia*n_r+i],1E-3*fabs(xi_single[i]));
+    }
+  }
+
+  free(r);
+  free(xi_multi);
+  free(xi_growth);
+  free(xi_single);
+  ccl_cosmology_free(cosmo);
 }
@@ -163,3 +163,115 @@ CTEST2(corrs_3dRSD,model_3) {
   int model=3;
   compare_correlation_3dRSD(model,data);
 }
+
+//Linear-theory version of model 1, used by the multipole spline tests
+static ccl_cosmology *corrs_3dRSD_linear_cosmology(struct corrs_3dRSD_data * data)
+{
+  int status=0;
+  ccl_configuration config = default_config;
+  config.matter_power_spectrum_method= ccl_linear;
+  config.transfer_function_method = ccl_boltzmann;
+  ccl_parameters params = ccl_parameters_create(data->Omega_c,data->Omega_b,data->Omega_k[0],
+		data->Neff, data->mnu, data->mnu_type, data->w_0[0],data->w_a[0],
+		data->h,data->A_s,data->n_s,-1, -1, -1, -1,NULL,NULL, &status);
+  params.Omega_g=0.0;
+  params.Omega_l=data->Omega_v[0];
+  params.sigma8=data->sigma8;
+  return ccl_cosmology_create(params, config);
+}
+
+CTEST2(corrs_3dRSD,spline_per_a) {
+  int status=0,i,ia;
+  int ns=16;
+  double a_arr[2]={1.0,0.5};
+  double mu=0.4;
+  ccl_cosmology * cosmo = corrs_3dRSD_linear_cosmology(data);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *s=malloc(ns*sizeof(double));
+  double *xi_spl=malloc(ns*sizeof(double));
+  double *xi_dir=malloc(ns*sizeof(double));
+  for(i=0;i<ns;i++)
+    s[i]=5.+10.*i;
+
+  // Splines for one a must not be reused for another, alternating calls
+  // exercise both the insertion and the lookup paths.
+  for(ia=0;ia<4;ia++) {
+    double a=a_arr[ia%2];
+    double beta=0.5*a;
+    ccl_correlation_3dRsd(cosmo,a,ns,s,mu,beta,xi_spl,1,&status);
+    ASSERT_EQUAL(0,status);
+    ccl_correlation_3dRsd(cosmo,a,ns,s,mu,beta,xi_dir,0,&status);
+    ASSERT_EQUAL(0,status);
+    for(i=0;i<ns;i++)
+      ASSERT_DBL_NEAR_TOL(0.,s[i]*s[i]*(xi_spl[i]-xi_dir[i]),1E-6);
+  }
+  ccl_correlation_multipole_spline_free(cosmo);
+
+  free(s);
+  free(xi_spl);
+  free(xi_dir);
+  ccl_cosmology_free(cosmo);
+}
+
+// w_p(r_p) must match a brute-force integral of xi(pi,r_p) over pi
+CTEST2(corrs_3dRSD,wp) {
+  int status=0,i,j;
+  int nrp=5,npi=20000;
+  double a=0.8,beta=0.5,pi_max=100.;
+  double rp[5]={0.5,2.,10.,40.,100.};
+  ccl_cosmology * cosmo = corrs_3dRSD_linear_cosmology(data);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *wp=malloc(nrp*sizeof(double));
+  double *xi=malloc(npi*sizeof(double));
+  ccl_correlation_wp(cosmo,a,beta,pi_max,nrp,rp,wp,&status);
+  ASSERT_EQUAL(0,status);
+
+  for(i=0;i<nrp;i++) {
+    // Midpoint rule in pi
+    double wp_bf=0,dpi=pi_max/npi;
+    for(j=0;j<npi;j++) {
+      double pi=(j+0.5)*dpi;
+      ccl_correlation_pi_sigma(cosmo,a,beta,pi,1,&(rp[i]),&(xi[j]),1,&status);
+      wp_bf+=2*xi[j]*dpi;
+    }
+    ASSERT_EQUAL(0,status);
+    ASSERT_DBL_NEAR_TOL(wp_bf,wp[i],1E-3*fabs(wp_bf)+1E-4);
+  }
+  ccl_correlation_multipole_spline_free(cosmo);
+
+  free(wp);
+  free(xi);
+  ccl_cosmology_free(cosmo);
+}
+
+// The (pi,sigma) grid must match the correlation function at the same s and mu
+CTEST2(corrs_3dRSD,pi_sigma_grid) {
+  int status=0,i,j,ius;
+  int npi=7,nsig=9;
+  double a=0.8,beta=0.5;
+  ccl_cosmology * cosmo = corrs_3dRSD_linear_cosmology(data);
+  ASSERT_NOT_NULL(cosmo);
+
+  double *pi=ccl_linear_spacing(0.,120.,npi);
+  double *sig=ccl_linear_spacing(1.,121.,nsig);
+  double *xi=malloc(npi*nsig*sizeof(double));
+  for(ius=0;ius<2;ius++) {
+    ccl_correlation_pi_sigma_grid(cosmo,a,beta,npi,pi,nsig,sig,xi,ius,&status);
+    ASSERT_EQUAL(0,status);
+    for(i=0;i<npi;i++) {
+      for(j=0;j<nsig;j++) {
+	double s=sqrt(pi[i]*pi[i]+sig[j]*sig[j]),xi_s;
+	ccl_correlation_3dRsd(cosmo,a,1,&s,pi[i]/s,beta,&xi_s,1,&status);
+	ASSERT_DBL_NEAR_TOL(0.,s*s*(xi[i*nsig+j]-xi_s),1E-6);
+      }
+    }
+  }
+  ccl_correlation_multipole_spline_free(cosmo);
+
+  free(pi);
+  free(sig);
+  free(xi);
+  ccl_cosmology_free(cosmo);
+}
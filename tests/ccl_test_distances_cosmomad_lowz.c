@@ -136,6 +136,34 @@ static void compare_distances(int model, struct distances_cosmomad_lowz_data * d
         ASSERT_DBL_NEAR_TOL(data->dm[model][j], dm_ij, absolute_tolerance);
     }
   }
+
+  // Same distances from the direct-indexed distance table, and back to redshift
+  double chi_tab[6], z_tab[6], z_pos[6], dm_tab[6], dl_tab[6];
+  int n_pos=0;
+  ccl_convert_distances(cosmo, CCL_DIST_CHI, 6, data->z, chi_tab, &status);
+  ASSERT_EQUAL(0, status);
+  ccl_convert_distances(cosmo, CCL_DIST_Z_OF_CHI, 6, chi_tab, z_tab, &status);
+  ASSERT_EQUAL(0, status);
+  for (int j=0; j<6; j++) {
+    double absolute_tolerance = DISTANCES_TOLERANCE*data->chi[model][j];
+    if (fabs(absolute_tolerance)<1e-12) absolute_tolerance = 1e-12;
+    ASSERT_DBL_NEAR_TOL(data->chi[model][j], chi_tab[j]*data->h, absolute_tolerance);
+    ASSERT_DBL_NEAR_TOL(data->z[j], z_tab[j], 1e-8*(1+data->z[j]));
+    if (data->z[j]>0)
+      z_pos[n_pos++] = data->z[j];
+  }
+  ccl_convert_distances(cosmo, CCL_DIST_MU, n_pos, z_pos, dm_tab, &status);
+  ASSERT_EQUAL(0, status);
+  ccl_convert_distances(cosmo, CCL_DIST_DL, n_pos, z_pos, dl_tab, &status);
+  ASSERT_EQUAL(0, status);
+  ccl_convert_distances(cosmo, CCL_DIST_Z_OF_DL, n_pos, dl_tab, z_tab, &status);
+  ASSERT_EQUAL(0, status);
+  for (int j=0; j<n_pos; j++) {
+    double a = 1/(1.+z_pos[j]);
+    ASSERT_DBL_NEAR_TOL(ccl_distance_modulus(cosmo, a, &status), dm_tab[j], 1e-6);
+    ASSERT_DBL_NEAR_TOL(ccl_luminosity_distance(cosmo, a, &status), dl_tab[j], 1e-8*dl_tab[j]);
+    ASSERT_DBL_NEAR_TOL(z_pos[j], z_tab[j], 1e-8*(1+z_pos[j]));
+  }
   
   ccl_cosmology_free(cosmo);
 }
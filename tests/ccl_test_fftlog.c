@@ -0,0 +1,57 @@
+#include <math.h>
+#include <complex.h>
+#include "ctest.h"
+#include "fftlog.h"
+
+#define FFTLOG_NPTS 512
+#define FFTLOG_RMIN 1E-4
+#define FFTLOG_RMAX 1E4
+#define FFTLOG_TOL 1E-4
+
+// a(r) = r^(mu+1) exp(-r^2/2) is its own Hankel transform:
+//   int_0^inf a(r) J_mu(k r) k dr = k^(mu+1) exp(-k^2/2)
+static double hankel_pair(double mu,double x)
+{
+  return pow(x,mu+1)*exp(-0.5*x*x);
+}
+
+static void check_fftlog(double mu)
+{
+  int i,N=FFTLOG_NPTS;
+  double r[FFTLOG_NPTS],a[FFTLOG_NPTS];
+  double k_fht[FFTLOG_NPTS],k_plan[FFTLOG_NPTS],b_plan[FFTLOG_NPTS];
+  double complex ac[FFTLOG_NPTS],bc[FFTLOG_NPTS];
+
+  for(i=0;i<N;i++) {
+    r[i]=FFTLOG_RMIN*pow(FFTLOG_RMAX/FFTLOG_RMIN,i/(N-1.));
+    a[i]=hankel_pair(mu,r[i]);
+    ac[i]=a[i];
+  }
+  double L=log(r[N-1]/r[0])*N/(N-1.);
+
+  //One-shot transform
+  fht(N,r,ac,k_fht,bc,mu,0,1,1,NULL);
+  for(i=0;i<N;i++) {
+    if((k_fht[i]>0.05) && (k_fht[i]<5.))
+      ASSERT_DBL_NEAR_TOL(hankel_pair(mu,k_fht[i]),creal(bc[i]),FFTLOG_TOL);
+  }
+
+  //Cached plan. It must be returned again for the same parameters
+  fftlog_plan *p=fftlog_plan_get(N,mu,0,L,1,1);
+  ASSERT_NOT_NULL(p);
+  ASSERT_TRUE(p==fftlog_plan_get(N,mu,0,L,1,1));
+  fftlog_plan_execute(p,r,a,k_plan,b_plan);
+  for(i=0;i<N;i++) {
+    ASSERT_DBL_NEAR_TOL(1.,k_plan[i]/k_fht[i],1E-10);
+    ASSERT_DBL_NEAR_TOL(creal(bc[i]),b_plan[i],1E-10);
+  }
+  fftlog_plan_cache_clear_all();
+}
+
+CTEST(fftlog_tests,hankel_mu_0) {
+  check_fftlog(0.);
+}
+
+CTEST(fftlog_tests,hankel_mu_2) {
+  check_fftlog(2.);
+}
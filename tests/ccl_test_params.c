@@ -295,3 +295,25 @@ CTEST2(parameters, read_write) {
     ASSERT_DBL_NEAR_TOL(params2.wa, 0.0, 1e-10);
     remove(filename);
 }
+
+CTEST2(parameters, equal) {
+  ccl_parameters params1 = ccl_parameters_create_flat_lcdm(
+    data->Omega_c, data->Omega_b, data->h, data->A_s, data->n_s, &(data->status));
+  ccl_parameters params2 = ccl_parameters_create_flat_lcdm(
+    data->Omega_c, data->Omega_b, data->h, data->A_s, data->n_s, &(data->status));
+  ccl_configuration config = default_config;
+
+  // Separately allocated parameters with the same values are equal
+  ASSERT_EQUAL(data->status, 0);
+  ASSERT_TRUE(params1.mnu != params2.mnu);
+  ASSERT_TRUE(ccl_parameters_equal(&params1, &params2));
+  ASSERT_TRUE(ccl_configuration_equal(&config, &default_config));
+
+  params2.h *= 1.01;
+  ASSERT_FALSE(ccl_parameters_equal(&params1, &params2));
+  config.matter_power_spectrum_method = ccl_linear;
+  ASSERT_FALSE(ccl_configuration_equal(&config, &default_config));
+
+  ccl_parameters_free(&params1);
+  ccl_parameters_free(&params2);
+}
@@ -138,6 +138,26 @@ def check_background(cosmo):
     assert_( all_finite(ccl.scale_factor_of_chi(cosmo, a_lst)) )
     assert_( all_finite(ccl.scale_factor_of_chi(cosmo, a_arr)) )
 
+    # convert_distances
+    z_arr = 1. / a_arr[:-1] - 1.
+    for kind in ['comoving_radial', 'comoving_angular', 'angular_diameter',
+                 'luminosity', 'distance_modulus']:
+        assert_( all_finite(ccl.convert_distances(cosmo, z_arr[0], kind)) )
+        assert_( all_finite(ccl.convert_distances(cosmo, z_arr, kind)) )
+    chi = ccl.convert_distances(cosmo, z_arr, 'comoving_radial')
+    assert_allclose(chi, ccl.comoving_radial_distance(cosmo, a_arr[:-1]),
+                    rtol=1e-6)
+    assert_allclose(ccl.convert_distances(cosmo, chi, 'z_of_comoving_radial'),
+                    z_arr, rtol=1e-6)
+    dl = ccl.convert_distances(cosmo, z_arr, 'luminosity')
+    assert_allclose(dl, ccl.luminosity_distance(cosmo, a_arr[:-1]),
+                    rtol=1e-6)
+    assert_allclose(ccl.convert_distances(cosmo, dl, 'z_of_luminosity'),
+                    z_arr, rtol=1e-6)
+    assert_raises(ValueError, ccl.convert_distances, cosmo, z_arr, 'xyz')
+    assert_raises(CCLError, ccl.convert_distances, cosmo, -1.,
+                  'comoving_radial')
+
     # omega_m_a
     assert_( all_finite(ccl.omega_x(cosmo, a_scl, 'matter')) )
     assert_( all_finite(ccl.omega_x(cosmo, a_lst, 'matter')) )
@@ -553,6 +573,29 @@ def check_cls(cosmo):
     # Check non-limber calculations
     assert_( all_finite(ccl.angular_cl(cosmo, nc1, nc1, ell_arr, l_limber=20)))
 
+    # Check fixed-node Limber integration
+    assert_( all_finite(ccl.angular_cl(cosmo, lens1, nc3, ell_arr,
+                                       limber_integration='gl_chi')) )
+    assert_raises(ValueError, ccl.angular_cl, cosmo, lens1, nc1, ell_arr,
+                  limber_integration='none')
+
+    # Check cached power spectra
+    cl_nocache = ccl.angular_cl(cosmo, lens1, nc1, ell_arr)
+    cosmo.enable_cl_cache(max_entries=2)
+    assert_( np.allclose(ccl.angular_cl(cosmo, lens1, nc1, ell_arr), cl_nocache) )
+    assert_( np.allclose(ccl.angular_cl(cosmo, nc1, lens1, ell_arr), cl_nocache) )
+    cosmo.clear_cl_cache()
+    cosmo.disable_cl_cache()
+
+    # Check photo-z shift and stretch
+    lens_pz = ccl.WeakLensingTracer(cosmo, (z, n))
+    nc_pz = ccl.NumberCountsTracer(cosmo, False, dndz=(z,n), bias=(z,b))
+    lens_pz.set_photoz(cosmo, 0.05, stretch=1.1)
+    nc_pz.set_photoz(cosmo, -0.02)
+    assert_( all_finite(ccl.angular_cl(cosmo, lens_pz, nc_pz, ell_arr)) )
+    assert_raises(CCLError, nc_pz.set_photoz, cosmo, 0.05, stretch=-1.)
+    if cmb_ok: assert_raises(CCLError, cmbl.set_photoz, cosmo, 0.05)
+
     # Check various cross-correlation combinations
     assert_( all_finite(ccl.angular_cl(cosmo, lens1, lens2, ell_arr)) )
     assert_( all_finite(ccl.angular_cl(cosmo, lens1, nc1, ell_arr)) )
@@ -703,6 +746,16 @@ def check_corr_3d(cosmo):
     assert_( all_finite(corr2))
     assert_( all_finite(corr3))
 
+    # Several scale factors at once
+    a_lst = np.array([0.5, 0.8, 1.])
+    corr4 = ccl.correlation_3d(cosmo, a_lst, r_lst)
+    corr5 = ccl.correlation_3d(cosmo, a_lst, r_lst, linear_growth=True)
+    assert_( all_finite(corr4))
+    assert_( all_finite(corr5))
+    assert_(corr4.shape == (len(a_lst), len(r_lst)))
+    assert_(corr5.shape == (len(a_lst), len(r_lst)))
+    assert_allclose(corr4[1], corr3, rtol=1e-10)
+
 
 def check_corr_3dRSD(cosmo):
 
@@ -755,7 +808,24 @@ def check_corr_3dRSD(cosmo):
     assert_( all_finite(corr11))
     assert_( all_finite(corr12))
 
+    pie_lst = np.linspace(0,100,5)
+    corr_grid = ccl.correlation_pi_sigma(cosmo, a, beta, pie_lst, sig_lst)
+    assert_( all_finite(corr_grid))
+    assert_(corr_grid.shape == (len(pie_lst), len(sig_lst)))
+    assert_allclose(corr_grid[2], corr12, rtol=1e-10)
+
+    corr13 = ccl.correlation_wp(cosmo, a, beta, sig_int, 100.)
+    corr14 = ccl.correlation_wp(cosmo, a, beta, sig, 100.)
+    corr15 = ccl.correlation_wp(cosmo, a, beta, sig_lst, 100.)
+    assert_( all_finite(corr13))
+    assert_( all_finite(corr14))
+    assert_( all_finite(corr15))
+    assert_raises(CCLError, ccl.correlation_wp, cosmo, a, beta, sig_lst, -1.)
+
     #free spline
+    ccl.correlation_spline_free(cosmo)
+    corr16 = ccl.correlation_3dRsd(cosmo, a, s_lst, mu, beta)
+    assert_allclose(corr16, corr3, rtol=1e-10)
     ccl.correlation_spline_free()
 
 def test_valid_transfer_combos():
@@ -1,5 +1,5 @@
 import numpy as np
-from numpy.testing import assert_allclose, run_module_suite
+from numpy.testing import assert_, assert_raises, assert_allclose, run_module_suite
 import numpy.testing
 import pyccl as ccl
 
@@ -138,5 +138,89 @@ def test_redshift_numerical():
         assert_allclose(ccl.dNdz_tomog(z_lst[i], zmin, zmax, PZ3, 
 		               dNdZ2), np_dndz_3[i], rtol=TOLERANCE)  
 
+def test_redshift_tomog_multi():
+    """
+    Check that the batched tomographic dNdz matches the single-bin one.
+    """
+    z = np.array([0., 0.5, 1., 1.5, 2.])
+    bin_edges = np.array([0., 0.5, 1., 2.])
+
+    PZ1 = ccl.PhotoZFunction(lambda z_ph, z_s, args:
+                             np.exp(-(z_ph - z_s)**2. / 2.))
+    PZ2 = ccl.PhotoZGaussian(sigma_z0=0.1)
+    dNdZ = ccl.dNdzSmail(alpha = 1.24, beta = 1.01, z0 = 0.51)
+
+    for pz in [PZ1, PZ2]:
+        dndz = ccl.dNdz_tomog_multi(z, bin_edges, pz, dNdZ)
+        assert_(dndz.shape == (len(bin_edges) - 1, len(z)))
+        for i in range(len(bin_edges) - 1):
+            assert_allclose(dndz[i], ccl.dNdz_tomog(z, bin_edges[i],
+                            bin_edges[i+1], pz, dNdZ), rtol=TOLERANCE)
+    assert_raises(ValueError, ccl.dNdz_tomog_multi, z, [0.], PZ2, dNdZ)
+
+def test_redshift_tabulated():
+    """
+    Check that tabulated photo-z models reproduce the analytic Gaussian.
+    """
+    z = np.array([0.1, 0.5, 1., 1.5, 2.])
+    bin_edges = np.array([0., 0.5, 1., 2.])
+    dNdZ = ccl.dNdzSmail(alpha = 1.24, beta = 1.01, z0 = 0.51)
+    dndz_ref = ccl.dNdz_tomog_multi(z, bin_edges,
+                                    ccl.PhotoZGaussian(sigma_z0=0.05), dNdZ)
+
+    def pz_grid(z_ph, z_s, args):
+        sig = 0.05 * (1. + z_s)
+        return np.exp(-0.5 * ((z_ph - z_s) / sig)**2) / np.sqrt(2. * np.pi) / sig
+
+    def pz_logz(z_ph, z_s, args):
+        x = np.log((1. + z_ph) / (1. + z_s))
+        return np.exp(-0.5 * (x / 0.05)**2) / np.sqrt(2. * np.pi) / 0.05 \
+            / (1. + z_ph)
+
+    PZ1 = ccl.PhotoZFunction(pz_grid)
+    # ~1.6E5 Python calls; the interpolation error is ~3E-4 at most on this grid
+    PZ1.tabulate('grid', x_range=(-0.5, 6.), n_x=801, n_zt=201)
+    assert_allclose(ccl.dNdz_tomog_multi(z, bin_edges, PZ1, dNdZ),
+                    dndz_ref, rtol=1E-3, atol=1E-5)
+
+    # A log-normal kernel with sigma_z0 close to the Gaussian one
+    PZ2 = ccl.PhotoZFunction(pz_logz)
+    PZ2.tabulate('shift_logz', x_range=(-0.5, 0.5))
+    PZ3 = ccl.PhotoZFunction(pz_logz)
+    assert_allclose(ccl.dNdz_tomog_multi(z, bin_edges, PZ2, dNdZ),
+                    ccl.dNdz_tomog_multi(z, bin_edges, PZ3, dNdZ),
+                    rtol=1E-3, atol=1E-5)
+
+    assert_raises(ValueError, PZ1.tabulate, 'spline')
+    assert_raises(ccl.CCLError, PZ1.tabulate, 'grid', x_range=(1., 0.))
+
+def test_redshift_sampler():
+    """
+    Check that sampled redshifts follow the cumulative dNdz.
+    """
+    from math import erf
+    u = (np.arange(1000) + 0.5) / 1000.
+    dNdZ = ccl.dNdzSmail(alpha = 1.24, beta = 1.01, z0 = 0.51)
+    PZ = ccl.PhotoZGaussian(sigma_z0=0.05)
+
+    zs = np.linspace(0., 5., 100001)
+    nz_true = zs**1.24 * np.exp(-(zs / 0.51)**1.01)
+    verf = np.vectorize(erf)
+    sig = np.sqrt(2.) * 0.05 * (1. + zs)
+    nz_bin = nz_true * (verf((1. - zs) / sig) - verf((0.5 - zs) / sig))
+    for sampler, nz in [(ccl.dNdzSampler(dNdZ), nz_true),
+                        (ccl.dNdzSampler(dNdZ, PZ, 0.5, 1.), nz_bin)]:
+        z = sampler.sample(u)
+        assert_(np.all(np.diff(z) >= 0))
+        cdf = np.concatenate([[0.], np.cumsum(0.5 * (nz[1:] + nz[:-1]))])
+        cdf /= cdf[-1]
+        assert_allclose(np.interp(z, zs, cdf), u, atol=1E-4)
+
+    assert_raises(ValueError, ccl.dNdzSampler, dNdZ, PZ)
+    assert_raises(ccl.CCLError, ccl.dNdzSampler, dNdZ, z_range=(1., 0.))
+    sampler = ccl.dNdzSampler(dNdZ)
+    assert_raises(ccl.CCLError, sampler.sample, [0.5, np.nan])
+    assert_raises(ccl.CCLError, sampler.sample, [-0.1, 0.5])
+
 if __name__ == "__main__":
     run_module_suite()
@@ -120,6 +120,8 @@ def test_swig_cls():
         COSMO,
         None, None,
         1, 1, 1,
+        ccllib.limber_qag_logk,
+        None,
         0,
         "none",
         status)